@@ -68,6 +68,7 @@ class KiwibesServer():
     ERROR_AUTHENTICATION_FAIL     = 20
     ERROR_HTTPS_CERTS_FAIL        = 21
     ERROR_SERVER_NOT_FOUND        = 22
+    ERROR_INVOCATION_UNKNOWN      = 27
    
     def __init__(self,auth_token,host='localhost',port=4242,verify_cert=True):
         """
@@ -97,14 +98,31 @@ class KiwibesServer():
         Return:
             - Kiwibes server error
         """
+        error, result = self.__post_response(route,data)
+        return error
+
+    def __post_response(self,route,data): 
+        """
+        POST method for the given HTTP route, which also returns the response.
+        Any 2xx status is a success, e.g. 202 when a job start is accepted.
+        In case of SSL error or it cannot reach the host, it
+        throws a KiwibesServerError exception.
+
+        Arguments:
+            - route : the server HTTP route 
+            - data  : the POST call data 
+
+        Return:
+            - tuple with the Kiwibes server error and the response
+        """
         try: 
             path = self.url + route
             result = requests.post(path,data=data,verify=self.verify_cert)
-            if 200 != result.status_code:
+            if (200 > result.status_code) or (300 <= result.status_code):
                 logging.error("POST - %s: (%d) %s" % (path,result.json()["error"],result.json()["message"])) 
-                return result.json()["error"]
+                return result.json()["error"], result
             else:
-                return self.ERROR_NO_ERROR
+                return self.ERROR_NO_ERROR, result
         except requests.exceptions.SSLError:
             message = "Invalid or self-signed Kiwibes server certificate !"
             logging.error(message)    
@@ -260,21 +278,80 @@ class KiwibesServer():
             return response.json()
         else:
             return None
+
+    def get_jobs_forecast(self,start=None,end=None):
+        """
+        Return the start instants of the scheduled jobs, inside a window of time.
+
+        Arguments:
+            - start : UNIX timestamp of the start of the window, by default now
+            - end   : UNIX timestamp of the end of the window, by default 24 hours after start
+
+        Returns:
+            - a dictionary with the list of start instants of each job
+        """
+        params = { "auth"  : self.token }
+        if start is not None:
+            params["from"] = start
+        if end is not None:
+            params["to"] = end
+        response = self.__get("/rest/jobs/forecast",params)
+        if response:
+            return response.json()
+        else:
+            return None
+
+    def get_stats(self):
+        """
+        Return the statistics of the server: the number of jobs, of running
+        jobs and of pending start requests, and the statistics of the runs.
+        """
+        params = { "auth"  : self.token }
+        response = self.__get("/rest/stats",params)
+        if response:
+            return response.json()
+        else:
+            return None
    
     def start_job(self,name):
         """
         Start the execution of the job. If the job is already running,
-        it queues the execution.
+        it queues the execution. The job is started by the server after
+        the request is accepted, get_invocation() tells how it went.
 
         Arguments:
             - name : the name of the job
 
         Returns:
-            - ERROR_NO_ERROR if successfull, error code otherwise
+            - the identifier of the start invocation, None in case of error
         """
         logging.info("Starting job: %s" % name)        
         data = { "auth"  : self.token }
-        return self.__post("/rest/job/start/%s" % name,data)
+        error, response = self.__post_response("/rest/job/start/%s" % name,data)
+        if self.ERROR_NO_ERROR == error:
+            return response.json()["invocation"]
+        else:
+            return None
+
+    def get_invocation(self,invocation,wait=0):
+        """
+        Return a dictionary with the state of a start invocation: the
+        invocation identifier, the job, its status (queued, started,
+        pending or failed) and the error code of the start.
+
+        Arguments:
+            - invocation : the identifier returned by start_job()
+            - wait       : milliseconds to wait for the invocation to be handled, defaults to 0
+
+        Returns:
+            - dictionary with the invocation state, None in case of error
+        """
+        params = { "auth" : self.token, "wait" : wait }
+        response = self.__get("/rest/job/invocation/%d" % invocation,params)
+        if response:
+            return response.json()
+        else:
+            return None
 
     def stop_job(self,name):
         """
@@ -306,6 +383,21 @@ class KiwibesServer():
         data = { "auth"  : self.token }
         return self.__post("/rest/job/delete/%s" % name,data)
 
+    def delete_jobs(self,names):
+        """
+        Delete many jobs from the database at once. No job is deleted 
+        if any of them does not exist, or is currently in execution.
+
+        Arguments:
+            - names : the list with the names of the jobs
+
+        Returns:
+            - ERROR_NO_ERROR if successfull, error code otherwise
+        """
+        logging.info("Deleting jobs: %s" % ", ".join(names))        
+        data = { "auth"  : self.token, "name" : names }
+        return self.__post("/rest/jobs/delete",data)
+
     def clear_job_queue(self,name):
         """
         Clear all pending executions for the job.
@@ -0,0 +1,163 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_admission_queue.h"
+
+KiwibesAdmissionQueue::KiwibesAdmissionQueue()
+{
+  acapacity = 0;
+  aarrivals = 0;
+  asize     = 0;
+}
+
+void KiwibesAdmissionQueue::set_capacity(size_t capacity)
+{
+  acapacity = capacity;
+}
+
+bool KiwibesAdmissionQueue::admissible(size_t running) const
+{
+  return (0 == acapacity) || (running < acapacity);
+}
+
+void KiwibesAdmissionQueue::push(const std::string &name, signed int priority)
+{
+  T_ADMISSION_JOB &job = ajobs[name];
+
+  /* the job is ordered again, in case its priority changed */
+  unorder(name,job);
+
+  job.priority = priority;
+  job.requests.push_back(aarrivals++);
+  asize++;
+
+  order(name,job);
+}
+
+bool KiwibesAdmissionQueue::pop(std::string &name)
+{
+  bool success = false;
+
+  if(false == aorder.empty())
+  {
+    name = std::get<2>(*aorder.begin());
+
+    std::unordered_map<std::string,T_ADMISSION_JOB>::iterator job = ajobs.find(name);
+
+    aorder.erase(aorder.begin());
+    job->second.requests.pop_front();
+    asize--;
+
+    if(true == job->second.requests.empty())
+    {
+      ajobs.erase(job);
+    }
+    else
+    {
+      order(name,job->second);
+    }
+    success = true;
+  }
+
+  return success;
+}
+
+void KiwibesAdmissionQueue::block(const std::string &name)
+{
+  T_ADMISSION_JOB &job = ajobs[name];
+
+  unorder(name,job);
+  job.blocked = true;
+}
+
+void KiwibesAdmissionQueue::unblock(const std::string &name)
+{
+  std::unordered_map<std::string,T_ADMISSION_JOB>::iterator job = ajobs.find(name);
+
+  if(ajobs.end() != job)
+  {
+    job->second.blocked = false;
+
+    if(true == job->second.requests.empty())
+    {
+      ajobs.erase(job);
+    }
+    else
+    {
+      order(name,job->second);
+    }
+  }
+}
+
+size_t KiwibesAdmissionQueue::clear(const std::string &name)
+{
+  size_t removed = 0;
+  std::unordered_map<std::string,T_ADMISSION_JOB>::iterator job = ajobs.find(name);
+
+  if(ajobs.end() != job)
+  {
+    unorder(name,job->second);
+    removed = job->second.requests.size();
+    asize  -= removed;
+    job->second.requests.clear();
+
+    /* a blocked job remains blocked */
+    if(false == job->second.blocked)
+    {
+      ajobs.erase(job);
+    }
+  }
+
+  return removed;
+}
+
+size_t KiwibesAdmissionQueue::count(const std::string &name) const
+{
+  std::unordered_map<std::string,T_ADMISSION_JOB>::const_iterator job = ajobs.find(name);
+
+  return (ajobs.end() != job) ? job->second.requests.size() : 0;
+}
+
+size_t KiwibesAdmissionQueue::size(void) const
+{
+  return asize;
+}
+
+void KiwibesAdmissionQueue::order(const std::string &name, const T_ADMISSION_JOB &job)
+{
+  if((false == job.blocked) && (false == job.requests.empty()))
+  {
+    aorder.insert(T_ADMISSION_KEY(-job.priority,job.requests.front(),name));
+  }
+}
+
+void KiwibesAdmissionQueue::unorder(const std::string &name, const T_ADMISSION_JOB &job)
+{
+  if((false == job.blocked) && (false == job.requests.empty()))
+  {
+    aorder.erase(T_ADMISSION_KEY(-job.priority,job.requests.front(),name));
+  }
+}
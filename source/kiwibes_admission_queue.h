@@ -0,0 +1,145 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the admission queue of the jobs manager. It
+  holds the start requests which cannot start yet, either because too
+  many jobs are running or because the job already runs its maximum
+  number of instances, in which case the job is blocked. The requests 
+  are admitted by the priority of their job, higher first, and then in
+  the order they arrived. Only the oldest request of each job that is 
+  not blocked is ordered, so admitting a request takes O(log n) in the
+  number of jobs, regardless of how many requests are waiting. The
+  queue is not synchronized, the owner must lock it.
+*/
+#ifndef __KIWIBES_ADMISSION_QUEUE_H__
+#define __KIWIBES_ADMISSION_QUEUE_H__
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** The requests of a job waiting in the queue
+ */
+typedef struct {
+  signed int           priority;   /* priority of the job, higher first */
+  bool                 blocked;    /* true if the requests of the job cannot be admitted */
+  std::deque<uint64_t> requests;   /* the arrival order of each request, oldest first */
+} T_ADMISSION_JOB;
+
+/** Position of a job in the order of admission: its priority, negated, the 
+    arrival order of its oldest request and its name
+ */
+typedef std::tuple<signed int,uint64_t,std::string> T_ADMISSION_KEY;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesAdmissionQueue {
+
+public:
+  /** Class constructor
+   */
+  KiwibesAdmissionQueue();
+
+  /** Set the maximum number of jobs running at once
+
+    @param capacity   the maximum number of jobs, 0 if there is no limit
+   */
+  void set_capacity(size_t capacity);
+
+  /** Return true if another job can start
+
+    @param running  the number of jobs running
+   */
+  bool admissible(size_t running) const;
+
+  /** Add a start request of the given job
+
+    @param name       the name of the job
+    @param priority   the priority of the job, it replaces that of its waiting requests
+   */
+  void push(const std::string &name, signed int priority);
+
+  /** Remove the next request to admit, the oldest of the job with the highest
+      priority which is not blocked
+
+    @param name   on return, contains the name of the job
+    @return true if a request was removed, false if none can be admitted
+   */
+  bool pop(std::string &name);
+
+  /** Stop admitting the requests of the given job
+
+    @param name   the name of the job
+   */
+  void block(const std::string &name);
+
+  /** Admit the requests of the given job again
+
+    @param name   the name of the job
+   */
+  void unblock(const std::string &name);
+
+  /** Remove all the requests of the given job
+
+    @param name   the name of the job
+    @return the number of requests removed
+   */
+  size_t clear(const std::string &name);
+
+  /** Return the number of requests of the given job
+
+    @param name   the name of the job
+   */
+  size_t count(const std::string &name) const;
+
+  /** Return the number of requests in the queue
+   */
+  size_t size(void) const;
+
+private:
+  /** Add the job to the order of admission, if it has requests and is not blocked
+
+    @param name   the name of the job
+    @param job    the requests of the job
+   */
+  void order(const std::string &name, const T_ADMISSION_JOB &job);
+
+  /** Remove the job from the order of admission, if it is there
+
+    @param name   the name of the job
+    @param job    the requests of the job
+   */
+  void unorder(const std::string &name, const T_ADMISSION_JOB &job);
+
+  size_t                                           acapacity;   /* maximum number of jobs running at once, 0 if there is no limit */
+  uint64_t                                         aarrivals;   /* number of requests that arrived so far */
+  size_t                                           asize;       /* number of requests in the queue */
+  std::unordered_map<std::string,T_ADMISSION_JOB>  ajobs;       /* the jobs with requests, or blocked */
+  std::set<T_ADMISSION_KEY>                        aorder;      /* the jobs whose requests can be admitted, next first */
+};  
+
+#endif
@@ -0,0 +1,495 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_cgroups.h"
+
+#include "NanoLog/NanoLog.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Name of the folder of the cgroups of the runs
+ */
+#define CGROUPS_FOLDER    "kiwibes-jobs"
+
+/** Name of the leaf cgroup the server moves into, so that its own cgroup can delegate controllers
+ */
+#define CGROUPS_SERVER    "kiwibes-server"
+
+/** Period of the CPU limit, in microseconds
+ */
+#define CGROUPS_CPU_PERIOD  (100000)
+
+/*----------------- Private Functions Declarations -----------------------------*/
+/** Return the folder of the cgroup v2 of the server
+
+  @return the folder, empty if the server is not in a cgroup v2 hierarchy
+ */
+static std::string server_cgroup(void);
+
+/** Write a value to a file of a cgroup
+
+  @param path   the path of the file
+  @param value  the value
+  @return true if successfull, false otherwise
+ */
+static bool write_cgroup_file(const std::string &path, const std::string &value);
+
+/** Return true if a controller is listed in a file of a cgroup
+
+  @param path         the path of the file, cgroup.controllers or cgroup.subtree_control
+  @param controller   the name of the controller
+  @return true if the controller is listed, false otherwise
+ */
+static bool has_controller(const std::string &path, const std::string &controller);
+
+/** Read the contents of a file of a cgroup
+
+  @param path     the path of the file
+  @param content  on return, contains the contents of the file
+  @return true if successfull, false if the file does not exist
+ */
+static bool read_cgroup_file(const std::string &path, std::string &content);
+
+/*--------------- Class Implemementation --------------------------------------*/
+KiwibesCgroups::KiwibesCgroups()
+{
+  cenabled = false;
+  cserial  = 0;
+  cmemory  = false;
+  ccpu     = false;
+}
+
+KiwibesCgroups::~KiwibesCgroups()
+{
+#if defined(__linux__)
+  if(true == cenabled)
+  {
+    /* the processes not reaped yet may have exited, those still running keep their cgroup */
+    for(std::unordered_map<T_PROCESS_HANDLER,std::string>::iterator group = cgroups.begin(); group != cgroups.end(); group++)
+    {
+      cstale.push_back(group->second);
+    }
+    for(std::unordered_map<int,std::string>::iterator group = ccreated.begin(); group != ccreated.end(); group++)
+    {
+      close(group->first);
+      cstale.push_back(group->second);
+    }
+    remove_stale();
+
+    /* other servers may share the folder, then it stays */
+    rmdir(cfolder.c_str());
+  }
+#endif
+}
+
+bool KiwibesCgroups::enable(const std::string &parent)
+{
+#if defined(__linux__)
+  std::string folder = (true == parent.empty()) ? server_cgroup() : parent;
+
+  cenabled = false;
+  cmemory  = false;
+  ccpu     = false;
+
+  if(false == folder.empty())
+  {
+    const char *controllers[] = { "cpu", "memory", "io" };
+
+    if('/' != folder.back())
+    {
+      folder += "/";
+    }
+    cfolder = folder + CGROUPS_FOLDER + "/";
+
+    /* only the cgroups below the root have a type */
+    bool root = (0 != access((folder + "cgroup.type").c_str(),F_OK));
+
+    if((0 != mkdir(cfolder.c_str(),0755)) && (EEXIST != errno))
+    {
+      LOG_WARN << "Cannot create the cgroups of the jobs in " << cfolder << "(" << errno << "): " << strerror(errno);
+    }
+    else
+    {
+      std::string leaf = folder + CGROUPS_SERVER + "/";
+
+      /* a cgroup with processes cannot delegate controllers, the server moves into a leaf */
+      if(true == root)
+      {
+        LOG_INFO << "The server runs in the root cgroup, its controllers are left as they are";
+      }
+      else if((true == parent.empty()) &&
+              ((((0 != mkdir(leaf.c_str(),0755)) && (EEXIST != errno))) ||
+               (false == write_cgroup_file(leaf + "cgroup.procs",std::to_string(getpid())))))
+      {
+        LOG_WARN << "Cannot move the server into the cgroup " << leaf << "(" << errno << "): " << strerror(errno);
+      }
+
+      /* the controllers are optional, without them only the CPU time is accounted */
+      for(size_t c = 0; c < sizeof(controllers)/sizeof(const char *); c++)
+      {
+        if((false == root) && (false == has_controller(folder + "cgroup.subtree_control",controllers[c])) &&
+           (false == write_cgroup_file(folder + "cgroup.subtree_control",std::string("+") + controllers[c])))
+        {
+          LOG_WARN << "Cannot enable the " << controllers[c] << " controller in " << folder << "(" << errno << "): " << strerror(errno);
+        }
+
+        if((true == has_controller(cfolder + "cgroup.controllers",controllers[c])) &&
+           (false == write_cgroup_file(cfolder + "cgroup.subtree_control",std::string("+") + controllers[c])))
+        {
+          LOG_WARN << "Cannot enable the " << controllers[c] << " controller in " << cfolder << "(" << errno << "): " << strerror(errno);
+        }
+      }
+
+      cmemory = has_controller(cfolder + "cgroup.subtree_control","memory");
+      ccpu    = has_controller(cfolder + "cgroup.subtree_control","cpu");
+
+      if(false == cmemory)
+      {
+        LOG_WARN << "The memory controller is not available, the memory limits of the jobs are ignored";
+      }
+      if(false == ccpu)
+      {
+        LOG_WARN << "The cpu controller is not available, the CPU limits of the jobs are ignored";
+      }
+
+      LOG_INFO << "The jobs run in cgroups under " << cfolder;
+      cenabled = true;
+    }
+  }
+#endif
+
+  return cenabled;
+}
+
+bool KiwibesCgroups::enabled(void) const
+{
+  return cenabled;
+}
+
+int KiwibesCgroups::create(const std::string &name, unsigned int max_memory, unsigned int max_cpu)
+{
+  int fd = -1;
+
+#if defined(__linux__)
+  if(true == cenabled)
+  {
+    std::string group;
+    int         error;
+
+    /* groups left behind by a previous server keep their name */
+    do
+    {
+      group = cfolder + name + "." + std::to_string(++cserial) + "/";
+      error = (0 == mkdir(group.c_str(),0755)) ? 0 : errno;
+    } while(EEXIST == error);
+
+    if(0 != error)
+    {
+      LOG_WARN << "Cannot create the cgroup of job '" << name << "'(" << error << "): " << strerror(error);
+    }
+    else
+    {
+      /* the limits are set before the process is in the cgroup */
+      if((0 < max_memory) && (false == cmemory))
+      {
+        LOG_WARN << "Ignoring the memory limit of job '" << name << "', the memory controller is not available";
+      }
+      else if((0 < max_memory) && (false == write_cgroup_file(group + "memory.max",std::to_string((uint64_t)max_memory*1024*1024))))
+      {
+        LOG_WARN << "Cannot limit the memory of job '" << name << "'";
+      }
+
+      if((0 < max_cpu) && (false == ccpu))
+      {
+        LOG_WARN << "Ignoring the CPU limit of job '" << name << "', the cpu controller is not available";
+      }
+      else if((0 < max_cpu) && (false == write_cgroup_file(group + "cpu.max",std::to_string((uint64_t)max_cpu*CGROUPS_CPU_PERIOD/100) + " " + std::to_string(CGROUPS_CPU_PERIOD))))
+      {
+        LOG_WARN << "Cannot limit the CPU of job '" << name << "'";
+      }
+
+      fd = open(group.c_str(),O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+      if(0 > fd)
+      {
+        LOG_WARN << "Cannot open the cgroup of job '" << name << "'(" << errno << "): " << strerror(errno);
+        rmdir(group.c_str());
+      }
+      else
+      {
+        ccreated[fd] = group;
+      }
+    }
+  }
+#endif
+
+  return fd;
+}
+
+bool KiwibesCgroups::join(int group)
+{
+  bool success = false;
+
+#if defined(__linux__)
+  /* 0 stands for the process which writes it */
+  int fd = openat(group,"cgroup.procs",O_WRONLY | O_CLOEXEC);
+
+  if(0 <= fd)
+  {
+    success = (1 == write(fd,"0",1));
+    close(fd);
+  }
+#endif
+
+  return success;
+}
+
+bool KiwibesCgroups::attach(T_PROCESS_HANDLER handle, int group)
+{
+  bool success = false;
+
+#if defined(__linux__)
+  std::unordered_map<int,std::string>::iterator created = ccreated.find(group);
+
+  if(ccreated.end() != created)
+  {
+    if(INVALID_PROCESS_HANDLE != handle)
+    {
+      cgroups[handle] = created->second;
+      success         = true;
+    }
+    else
+    {
+      rmdir(created->second.c_str());
+    }
+
+    close(group);
+    ccreated.erase(created);
+  }
+#endif
+
+  return success;
+}
+
+void KiwibesCgroups::collect(T_PROCESS_HANDLER handle, T_JOB_RUN &run)
+{
+#if defined(__linux__)
+  std::unordered_map<T_PROCESS_HANDLER,std::string>::iterator group = cgroups.find(handle);
+
+  if(cgroups.end() != group)
+  {
+    std::string content;
+
+    /* the CPU time is always accounted, and includes the descendants of the process */
+    if(true == read_cgroup_file(group->second + "cpu.stat",content))
+    {
+      std::istringstream stat(content);
+      std::string        key;
+      int64_t            value;
+
+      while(stat >> key >> value)
+      {
+        if(std::string("user_usec") == key)
+        {
+          run.cpu_user = value;
+        }
+        else if(std::string("system_usec") == key)
+        {
+          run.cpu_system = value;
+        }
+      }
+    }
+
+    if(true == read_cgroup_file(group->second + "memory.peak",content))
+    {
+      run.memory_peak = strtoll(content.c_str(),NULL,10);
+    }
+
+    /* one line per device, with the bytes read and written among other counters */
+    if(true == read_cgroup_file(group->second + "io.stat",content))
+    {
+      std::istringstream stat(content);
+      std::string        field;
+
+      run.io_read  = 0;
+      run.io_write = 0;
+
+      while(stat >> field)
+      {
+        if(0 == field.compare(0,7,"rbytes="))
+        {
+          run.io_read += strtoll(field.c_str() + 7,NULL,10);
+        }
+        else if(0 == field.compare(0,7,"wbytes="))
+        {
+          run.io_write += strtoll(field.c_str() + 7,NULL,10);
+        }
+      }
+    }
+
+    /* descendants of the process may still be running, the cgroup is then removed later */
+    if(0 != rmdir(group->second.c_str()))
+    {
+      cstale.push_back(group->second);
+    }
+    cgroups.erase(group);
+  }
+
+  remove_stale();
+#endif
+}
+
+size_t KiwibesCgroups::size(void) const
+{
+  return cgroups.size();
+}
+
+/*--------------- Private Methods --------------------------------------*/
+void KiwibesCgroups::remove_stale(void)
+{
+#if defined(__linux__)
+  for(size_t s = 0; s < cstale.size(); )
+  {
+    if((0 == rmdir(cstale[s].c_str())) || (ENOENT == errno))
+    {
+      cstale[s] = cstale.back();
+      cstale.pop_back();
+    }
+    else
+    {
+      s++;
+    }
+  }
+#endif
+}
+
+/*--------------- Private Functions Definitions --------------------------------*/
+static std::string server_cgroup(void)
+{
+  std::string folder;
+
+#if defined(__linux__)
+  std::ifstream mounts("/proc/self/mountinfo");
+  std::ifstream groups("/proc/self/cgroup");
+  std::string   line;
+  std::string   mount;
+  std::string   path;
+
+  /* the fields after the separator are the filesystem type, source and options */
+  while((true == mount.empty()) && (std::getline(mounts,line)))
+  {
+    size_t separator = line.find(" - ");
+
+    if((std::string::npos != separator) && (0 == line.compare(separator + 3,8,"cgroup2 ")))
+    {
+      std::istringstream fields(line);
+      std::string        field;
+
+      for(int f = 0; (f < 5) && (fields >> field); f++)
+      {
+        mount = (4 == f) ? field : mount;
+      }
+    }
+  }
+
+  /* the cgroup v2 of the process is the one in hierarchy 0 */
+  while((true == path.empty()) && (std::getline(groups,line)))
+  {
+    if(0 == line.compare(0,3,"0::"))
+    {
+      path = line.substr(3);
+    }
+  }
+
+  if((false == mount.empty()) && (false == path.empty()))
+  {
+    folder = mount + path;
+  }
+#endif
+
+  return folder;
+}
+
+static bool write_cgroup_file(const std::string &path, const std::string &value)
+{
+  bool success = false;
+
+#if defined(__linux__)
+  int fd = open(path.c_str(),O_WRONLY | O_CLOEXEC);
+
+  if(0 <= fd)
+  {
+    success = ((ssize_t)value.size() == write(fd,value.c_str(),value.size()));
+    close(fd);
+  }
+#endif
+
+  return success;
+}
+
+static bool has_controller(const std::string &path, const std::string &controller)
+{
+  std::string content;
+  std::string name;
+  bool        found = false;
+
+  if(true == read_cgroup_file(path,content))
+  {
+    std::istringstream names(content);
+
+    while((false == found) && (names >> name))
+    {
+      found = (controller == name);
+    }
+  }
+
+  return found;
+}
+
+static bool read_cgroup_file(const std::string &path, std::string &content)
+{
+  std::ifstream     file(path);
+  std::stringstream buffer;
+
+  if(true == file.is_open())
+  {
+    buffer << file.rdbuf();
+    content = buffer.str();
+  }
+
+  return file.is_open();
+}
@@ -0,0 +1,136 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class places each run of a job in its own cgroup v2, created in a
+  folder under the cgroup of the server before the run is launched. When the run exits, the CPU time,
+  peak memory and I/O that its cgroup accounted are collected into the run,
+  and the cgroup is removed. The memory and CPU limits of the job are 
+  enforced through the memory.max and cpu.max of its cgroup, when those
+  controllers are available, otherwise they are ignored with a warning.
+  A cgroup with processes cannot delegate controllers, so the server first
+  moves into a leaf cgroup of its own. The controllers of the root cgroup
+  are never changed, they belong to the whole system. Without cgroup v2, 
+  or for the resources that it does not account, the caller keeps the 
+  usage reported by wait4. The cgroups are not synchronized, the owner 
+  must lock them.
+*/
+#ifndef __KIWIBES_CGROUPS_H__
+#define __KIWIBES_CGROUPS_H__
+
+#include "kiwibes_job_history.h"
+#include "kiwibes_process_table.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesCgroups {
+
+public:
+  /** Class constructor, the runs are not placed in cgroups until they are enabled
+   */
+  KiwibesCgroups();
+
+  /** Class destructor, removes the cgroups whose processes exited
+   */
+  ~KiwibesCgroups();
+
+  /** Enable the cgroups of the runs, created in a folder under the given cgroup
+
+    The cpu, memory and io controllers are enabled for the runs, as far as 
+    the parent cgroup delegates them. For the cgroup of the server, the server
+    first moves into a leaf cgroup under it, unless it is the root cgroup.
+
+    @param parent   the folder of the parent cgroup, empty for the cgroup of the server
+    @return true if the runs are placed in cgroups, false if cgroup v2 is not available
+   */
+  bool enable(const std::string &parent);
+
+  /** Return true if the runs are placed in cgroups
+   */
+  bool enabled(void) const;
+
+  /** Create a new cgroup for a run of a job, with the limits of the job
+
+    The process of the run then joins it before executing the program of 
+    the job, so that all its children are accounted and limited as well.
+    A limit is ignored, with a warning, if its controller is not available.
+
+    @param name         the name of the job
+    @param max_memory   maximum memory of the run, in MB, 0 if there is no limit
+    @param max_cpu      maximum CPU of the run, in percent of a CPU, 0 if there is no limit
+    @return the file descriptor of the folder of the cgroup, -1 if the run is not placed in a cgroup
+   */
+  int create(const std::string &name, unsigned int max_memory, unsigned int max_cpu);
+
+  /** Move the calling process into a cgroup
+
+    It only uses system calls, so a child process which still shares the 
+    memory of the server can call it before executing its program.
+
+    @param group  the file descriptor of the folder of the cgroup
+    @return true if successfull, false otherwise
+   */
+  static bool join(int group);
+
+  /** Attach a process to the cgroup created for it, and close the file descriptor of the cgroup
+
+    If the process could not be launched in the cgroup, the cgroup is removed.
+
+    @param handle   the handle of the process, INVALID_PROCESS_HANDLE if it is not in the cgroup
+    @param group    the file descriptor of the folder of the cgroup, as returned by create
+    @return true if successfull, false if the process is not in its own cgroup
+   */
+  bool attach(T_PROCESS_HANDLER handle, int group);
+
+  /** Collect the resources used by the cgroup of an exited process, and remove it
+
+    The resources which the cgroup does not account are left as they are.
+
+    @param handle   the handle of the process
+    @param run      the run of the process, on return contains the resources it used
+   */
+  void collect(T_PROCESS_HANDLER handle, T_JOB_RUN &run);
+
+  /** Return the number of processes placed in cgroups
+   */
+  size_t size(void) const;
+
+private:
+  /** Remove the cgroups whose processes left behind descendants, once they exited
+   */
+  void remove_stale(void);
+
+  std::string                                        cfolder;   /* folder of the cgroups of the runs, ending with a separator */
+  bool                                               cenabled;  /* true if the runs are placed in cgroups */
+  std::unordered_map<T_PROCESS_HANDLER,std::string>  cgroups;   /* the cgroup of each process */
+  std::unordered_map<int,std::string>                ccreated;  /* the cgroups not attached to a process yet, by file descriptor */
+  std::vector<std::string>                           cstale;    /* cgroups which could not be removed yet */
+  uint64_t                                           cserial;   /* serial number of the last cgroup created */
+  bool                                               cmemory;   /* true if the memory controller is enabled for the runs */
+  bool                                               ccpu;      /* true if the cpu controller is enabled for the runs */
+};  
+
+#endif
@@ -62,6 +62,11 @@ T_KIWIBES_ERROR parse_and_validate_command_line(T_CMD_LINE_OPTIONS &options, int
   options.log_max_size    = 1;     /* 1 MB log file size */
   options.https_port      = 4242;  /* listen on port 4242 */
   options.data_store_size = 10;    /* maximum data store size, 10 MB */
+  options.journal_sync    = 0;     /* the OS writes the database journal to disk */
+  options.binary_snapshot = 0;     /* the database is only saved as JSON */
+  options.group_commit    = 0;     /* each change is written to the journal at once */
+  options.max_running     = 0;     /* any number of jobs can run at once */
+  options.job_output      = 0;     /* the output of the jobs is only kept in memory */
 
   T_KIWIBES_ERROR error = parse_command_line(options,argc,argv);
 
@@ -82,6 +87,12 @@ void show_cmd_line_help(void)
   std::cout << "  -s UINT : log maximum size in MB, must be less than 100. Default is 1 MB" << std::endl;
   std::cout << "  -p UINT : HTTPS listening port. Default is 4242" << std::endl;
   std::cout << "  -d UINT : maxium size in MB, for the data store. Default is 10 MB, must be less than 100 MB" << std::endl;
+  std::cout << "  -f UINT : database journal sync, 0 leaves it to the OS, 1 syncs every change to disk. Default is 0" << std::endl;
+  std::cout << "  -b UINT : database binary snapshot, 1 keeps a binary copy of the database for faster startup. Default is 0" << std::endl;
+  std::cout << "  -g UINT : database group commit, maximum delay in ms before changes are written to the journal, must be less than 1000. Default is 0 ms" << std::endl;
+  std::cout << "            With -f 1 and -g > 0, a change is acknowledged before it is synced, and up to -g ms of changes can be lost" << std::endl;
+  std::cout << "  -j UINT : maximum number of jobs running at once, the other start requests are queued. Default is 0 (aka no limit)" << std::endl;
+  std::cout << "  -o UINT : job output, 1 also writes the complete output of each run to HOME/output. Default is 0 (aka latest output in memory only)" << std::endl;
   std::cout << std::endl;
 }
 
@@ -121,6 +132,31 @@ static T_KIWIBES_ERROR parse_command_line(T_CMD_LINE_OPTIONS &options, int argc,
         a++;
         options.data_store_size = strtol(argv[a],NULL,10);  
       }
+      else if((0 == strcmp("-f",argv[a])) && (a + 1) < argc) 
+      {
+        a++;
+        options.journal_sync = strtol(argv[a],NULL,10);  
+      }
+      else if((0 == strcmp("-b",argv[a])) && (a + 1) < argc) 
+      {
+        a++;
+        options.binary_snapshot = strtol(argv[a],NULL,10);  
+      }
+      else if((0 == strcmp("-g",argv[a])) && (a + 1) < argc) 
+      {
+        a++;
+        options.group_commit = strtol(argv[a],NULL,10);  
+      }
+      else if((0 == strcmp("-j",argv[a])) && (a + 1) < argc) 
+      {
+        a++;
+        options.max_running = strtol(argv[a],NULL,10);  
+      }
+      else if((0 == strcmp("-o",argv[a])) && (a + 1) < argc) 
+      {
+        a++;
+        options.job_output = strtol(argv[a],NULL,10);  
+      }
       else
       {
 #ifndef __KIWIBES_UT__
@@ -163,6 +199,34 @@ static T_KIWIBES_ERROR validate_command_line(T_CMD_LINE_OPTIONS &options)
 #endif
     error = ERROR_CMDLINE_INV_DATA_STORE_MAX_SIZE; 
   }
+  else if(1 < options.journal_sync)
+  {
+#ifndef __KIWIBES_UT__
+    std::cerr << "[ERROR] invalid database journal sync: " << options.journal_sync;
+#endif
+    error = ERROR_CMDLINE_INV_JOURNAL_SYNC; 
+  }
+  else if(1 < options.binary_snapshot)
+  {
+#ifndef __KIWIBES_UT__
+    std::cerr << "[ERROR] invalid database binary snapshot: " << options.binary_snapshot;
+#endif
+    error = ERROR_CMDLINE_INV_BINARY_SNAPSHOT; 
+  }
+  else if(1000 <= options.group_commit)
+  {
+#ifndef __KIWIBES_UT__
+    std::cerr << "[ERROR] invalid database group commit delay: " << options.group_commit;
+#endif
+    error = ERROR_CMDLINE_INV_GROUP_COMMIT; 
+  }
+  else if(1 < options.job_output)
+  {
+#ifndef __KIWIBES_UT__
+    std::cerr << "[ERROR] invalid job output: " << options.job_output;
+#endif
+    error = ERROR_CMDLINE_INV_JOB_OUTPUT; 
+  }
   else
   {
     /* verify that the home folder exists */
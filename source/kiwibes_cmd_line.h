@@ -41,6 +41,11 @@ typedef struct{
   unsigned int                 log_max_size;      /* the log maximum size in MB, must be less than 100 */
   unsigned int                 https_port;        /* the HTTPS listening port */
   unsigned int                 data_store_size;   /* maximum size of the data store in MB, defaults to 10 */ 
+  unsigned int                 journal_sync;      /* database journal synchronization policy, must be in the range [0,1] */
+  unsigned int                 binary_snapshot;   /* set to 1 to keep a binary snapshot of the database, must be in the range [0,1] */
+  unsigned int                 group_commit;      /* maximum delay of the database group commit in ms, must be less than 1000 */
+  unsigned int                 max_running;       /* maximum number of jobs running at once, 0 if there is no limit */
+  unsigned int                 job_output;        /* set to 1 to spill the complete output of the jobs to files, must be in the range [0,1] */
 } T_CMD_LINE_OPTIONS;
 
 /*-------------------------- Public Function Declarations -------------------------------*/
@@ -27,10 +27,42 @@
 #include "kiwibes_cron.h"
 #include "NanoLog/NanoLog.hpp"
 #include <chrono>
+#include <ctime>
+
+/*----------------- Private Functions Declarations -----------------------------*/
+/** Pack the bytes of a ccronexpr field into a single bitset
+
+  @param bytes  the bytes of the field
+  @param size   number of bytes
+  @return the bitset, with bit N of the field in position N
+ */
+static uint64_t field_bitset(const uint8_t *bytes, size_t size);
+
+/** Return the instant of the given local calendar time
+
+  @param year   years since 1900
+  @param month  month of the year, 0 to 11
+  @param day    day of the month, 1 to 31
+  @param hour   hour of the day
+  @param minute minute of the hour
+  @param second second of the minute
+  @param out    if not null, on return contains the normalized calendar time
+ */
+static std::time_t local_instant(int year, int month, int day, int hour, int minute, int second, struct tm *out);
+
+/** Return the number of days in the given month
+
+  @param year   years since 1900
+  @param month  month of the year, 0 to 11
+ */
+static int days_in_month(int year, int month);
+
+/*--------------- Class Implemementation --------------------------------------*/  
 
 KiwibesCron::KiwibesCron(const std::string &expression)
 {
-  cron.reset(new cron_expr);
+  /* the parser only sets the bits of the fields, so they must be cleared first */
+  cron.reset(new cron_expr());
   const char *error;
 
   cron_parse_expr(expression.c_str(),cron.get(),&error);
@@ -44,6 +76,13 @@ KiwibesCron::KiwibesCron(const std::string &expression)
   {
     valid = true;
   }
+
+  seconds       = field_bitset(cron->seconds,sizeof(cron->seconds));
+  minutes       = field_bitset(cron->minutes,sizeof(cron->minutes));
+  hours         = (uint32_t)field_bitset(cron->hours,sizeof(cron->hours));
+  days_of_month = (uint32_t)field_bitset(cron->days_of_month,sizeof(cron->days_of_month));
+  days_of_week  = (uint32_t)field_bitset(cron->days_of_week,sizeof(cron->days_of_week)) & 0x7F;
+  months        = (uint32_t)field_bitset(cron->months,sizeof(cron->months)) & 0xFFF;
 }
 
 bool KiwibesCron::is_valid(void)
@@ -52,14 +91,189 @@ bool KiwibesCron::is_valid(void)
 }
 
 std::time_t KiwibesCron::next(void)
+{
+  return next(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+}
+
+std::time_t KiwibesCron::next(std::time_t from)
 {
   if(true == valid)
   {
-    std::time_t now  = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    return cron_next(cron.get(),now);
+    return cron_next(cron.get(),from);
   }
   else
   {
     return 0;
   }
-}
\ No newline at end of file
+}
+size_t KiwibesCron::next_n(std::time_t from, std::time_t to, std::vector<std::time_t> &out, size_t max)
+{
+  size_t initial = out.size();
+  max += initial;
+
+  if((true == valid) && (from < to))
+  {
+    struct tm start;
+    localtime_r(&from,&start);
+
+    /* go through the months of the window, skipping the months not in the expression */
+    int year  = start.tm_year;
+    int month = start.tm_mon;
+
+    while((out.size() < max) && (local_instant(year,month,1,0,0,0,nullptr) <= to))
+    {
+      if(0 != (months & (1u << month)))
+      {
+        /* the days of the week of this month, repeating every 7 days from the first */
+        struct tm first;
+        uint32_t  week_days = 0;
+        int       ndays     = days_in_month(year,month);
+
+        local_instant(year,month,1,0,0,0,&first);
+        for(int d = 0; d < 7; d++)
+        {
+          if(0 != (days_of_week & (1u << ((first.tm_wday + d) % 7))))
+          {
+            for(int w = 1 + d; w <= ndays; w += 7)
+            {
+              week_days |= (1u << w);
+            }
+          }
+        }
+
+        /* jump straight to the days that match both the day of the month and of the week */
+        uint32_t days = days_of_month & week_days;
+
+        if((year == start.tm_year) && (month == start.tm_mon))
+        {
+          days &= ~((1u << start.tm_mday) - 1);
+        }
+
+        for(; (0 != days) && (out.size() < max); days &= (days - 1))
+        {
+          struct tm   day;
+          std::time_t midnight = local_instant(year,month,__builtin_ctz(days),0,0,0,&day);
+
+          if(to < midnight)
+          {
+            break;
+          }
+
+          next_n_day(day,midnight,from,to,out,max);
+        }
+      }
+
+      if(12 == ++month)
+      {
+        month = 0;
+        year++;
+      }
+    }
+  }
+
+  return (out.size() - initial);
+}
+
+void KiwibesCron::next_n_day(const struct tm &day, std::time_t midnight, std::time_t from, std::time_t to, std::vector<std::time_t> &out, size_t max)
+{
+  std::time_t next_day = local_instant(day.tm_year,day.tm_mon,day.tm_mday + 1,0,0,0,nullptr);
+  bool        regular  = ((next_day - midnight) == 24*3600);
+  bool        done     = (next_day <= from);
+
+  for(uint32_t h = hours; (0 != h) && (false == done); h &= (h - 1))
+  {
+    int         hour = __builtin_ctz(h);
+    std::time_t t_h  = midnight + 3600*hour;
+
+    /* skip the whole hour if it is before the window, stop if it is after */
+    if((true == regular) && ((t_h + 3599) <= from))
+    {
+      continue;
+    }
+    done = ((true == regular) && (to < t_h));
+
+    for(uint64_t m = minutes; (0 != m) && (false == done); m &= (m - 1))
+    {
+      int         minute = __builtin_ctzll(m);
+      std::time_t t_m    = t_h + 60*minute;
+
+      if((true == regular) && ((t_m + 59) <= from))
+      {
+        continue;
+      }
+      done = ((true == regular) && (to < t_m));
+
+      for(uint64_t s = seconds; (0 != s) && (false == done); s &= (s - 1))
+      {
+        int         second = __builtin_ctzll(s);
+        std::time_t t      = t_m + second;
+
+        /* on the days with daylight saving changes, let the C library do the math */
+        if(false == regular)
+        {
+          t = local_instant(day.tm_year,day.tm_mon,day.tm_mday,hour,minute,second,nullptr);
+        }
+
+        if((from < t) && (t <= to))
+        {
+          out.push_back(t);
+          done = (out.size() >= max);
+        }
+        else
+        {
+          done = ((true == regular) && (to < t));
+        }
+      }
+    }
+  }
+}
+
+/*--------------------- Private Functions Definitions ------------------------------*/
+static uint64_t field_bitset(const uint8_t *bytes, size_t size)
+{
+  uint64_t bitset = 0;
+
+  for(size_t b = 0; b < size; b++)
+  {
+    bitset |= ((uint64_t)bytes[b]) << (8*b);
+  }
+
+  return bitset;
+}
+
+static std::time_t local_instant(int year, int month, int day, int hour, int minute, int second, struct tm *out)
+{
+  struct tm calendar = {};
+
+  calendar.tm_year  = year;
+  calendar.tm_mon   = month;
+  calendar.tm_mday  = day;
+  calendar.tm_hour  = hour;
+  calendar.tm_min   = minute;
+  calendar.tm_sec   = second;
+  calendar.tm_isdst = -1;
+
+  std::time_t instant = mktime(&calendar);
+
+  if(nullptr != out)
+  {
+    *out = calendar;
+  }
+
+  return instant;
+}
+
+static int days_in_month(int year, int month)
+{
+  static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  int              y        = 1900 + year;
+
+  if((1 == month) && (0 == (y % 4)) && ((0 != (y % 100)) || (0 == (y % 400))))
+  {
+    return 29;
+  }
+  else
+  {
+    return days[month];
+  }
+}
@@ -23,6 +23,8 @@
   -------
 
   This class implements a wrapper around the Cron expression parser.
+  Besides the next occurrence, it can list all the occurrences in a
+  window of time, by scanning the bitsets of the expression fields.
 */
 #ifndef __KIWIBES_CRON_H__
 #define __KIWIBES_CRON_H__
@@ -30,6 +32,8 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <vector>
+#include <cstdint>
 #include "ccronexpr/ccronexpr.h"
 
 class KiwibesCron {
@@ -50,9 +54,47 @@ public:
    */
   std::time_t next(void);
 
+  /** Return the instant of the first occurrence after the given instant.
+      If the expression in the constructor is invalid, it returns 0.
+
+    @param from   the instant to start searching from
+   */
+  std::time_t next(std::time_t from);
+
+  /** List all the occurrences inside the given window of time.
+      If the expression in the constructor is invalid, nothing is listed.
+      On the days with daylight saving changes, each local time occurs at
+      most once, and local times which do not exist are moved forward.
+
+    @param from   the occurrences are strictly after this instant
+    @param to     the occurrences are at, or before, this instant
+    @param out    the occurrences are appended to this vector, in order
+    @param max    maximum number of occurrences to append
+    @return the number of occurrences appended
+   */
+  size_t next_n(std::time_t from, std::time_t to, std::vector<std::time_t> &out, size_t max);
+
+private:
+  /** List the occurrences inside the window of time, for a given day
+
+    @param day        the day, with the time of the day set to midnight
+    @param midnight   the instant of the start of the day
+    @param from       the occurrences are strictly after this instant
+    @param to         the occurrences are at, or before, this instant
+    @param out        the occurrences are appended to this vector, in order
+    @param max        maximum number of occurrences in the vector
+   */
+  void next_n_day(const struct tm &day, std::time_t midnight, std::time_t from, std::time_t to, std::vector<std::time_t> &out, size_t max);
+
 private:
-  std::unique_ptr<cron_expr> cron;    /* cron expression */
-  bool                       valid;   /* true if the expression is valid, false otherwise */
+  std::unique_ptr<cron_expr> cron;            /* cron expression */
+  bool                       valid;           /* true if the expression is valid, false otherwise */
+  uint64_t                   seconds;         /* bitset of the seconds, 0 to 59 */
+  uint64_t                   minutes;         /* bitset of the minutes, 0 to 59 */
+  uint32_t                   hours;           /* bitset of the hours, 0 to 23 */
+  uint32_t                   days_of_month;   /* bitset of the days of the month, 1 to 31 */
+  uint32_t                   days_of_week;    /* bitset of the days of the week, 0 (sunday) to 6 */
+  uint32_t                   months;          /* bitset of the months, 0 to 11 */
 };
 
 #endif
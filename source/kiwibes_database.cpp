@@ -27,62 +27,466 @@
 #include "kiwibes_database.h"
 #include "kiwibes_errors.h"
 #include "kiwibes_cron.h"
+#include "kiwibes_snapshot.h"
 
 #include "NanoLog/NanoLog.hpp"
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
-#include <iomanip>
+#include <functional>
+#include <set>
+#include <sstream>
+
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #error "OS not supported"
+#endif
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** The database is saved to file when the journal has more records than 
+    this, or than the number of jobs, whichever is larger
+ */
+#define JOURNAL_MIN_RECORDS   (1000)
+
+/** Suffix added to the path of the JSON file, to get the path of the journal
+ */
+#define JOURNAL_SUFFIX        ".journal"
+
+/** Suffix added to the path of the journal, while the JSON file is being saved
+ */
+#define JOURNAL_OLD_SUFFIX    ".old"
+
+/** Suffix added to the path of a file, to get the path of the temporary file
+    written before replacing it
+ */
+#define TEMP_SUFFIX           ".tmp"
+
+/** Suffix added to the path of the JSON file, to get the path of its binary snapshot
+ */
+#define BINARY_SUFFIX         ".bin"
+
+/** Fields every job description must have
+ */
+static const char *JOB_FIELDS[] = { 
+  "program","max-runtime","avg-runtime","var-runtime","schedule","status",
+  "start-time","nbr-runs","pending-start",
+};
+
+/** Optional fields of a job description, with the history of its runs
+ */
+static const char *HISTORY_FIELDS[] = { 
+  "runtime-sketch","runtime-percentiles","runs","nbr-timeouts",
+};
+
+/** Optional fields of a job description, with the limits of its runs
+ */
+static const char *LIMITS_FIELDS[] = { 
+  "max-parallel","priority","max-memory","max-cpu",
+};
+
+/*----------------- Private Functions Declarations -----------------------------*/
+/** Convert a job record to its JSON description
+
+  @param job          the job record
+  @param description  on return, contains the JSON description of the job
+ */
+static void job_to_json(const T_JOB_FIELDS *job, nlohmann::json *description);
+
+/** Convert the JSON description of a job to a job record
+
+  @param name         the name of the job
+  @param description  the JSON description of the job, with all the expected fields
+  @param job          on return, contains the job record
+  @return true if successfull, false if a field has the wrong type
+ */
+static bool job_from_json(const std::string &name, const nlohmann::json &description, T_JOB_RECORD *job);
+
+/** Serialize the journal record of a run of a job, without building its JSON first
+
+  @param name       the name of the job
+  @param run        the run of the job
+  @param timed_out  true if the run was stopped for exceeding the maximum runtime
+  @return the journal record, as a line of JSON text
+ */
+static std::string run_to_record(const std::string &name, const T_JOB_RUN &run, bool timed_out);
+
+/** Set a new job record from the details given by the user, with the other fields reset
+
+  @param name     the name of the job
+  @param details  the program, schedule and max-runtime of the job
+  @param job      on return, contains the job record
+ */
+static void job_from_details(const std::string &name, const nlohmann::json &details, T_JOB_RECORD *job);
+
+/** Check if the JSON description of a job has all the expected fields
+
+  @param description  the JSON description of the job
+  @return true if it has all the fields, false otherwise
+ */
+static bool has_job_fields(const nlohmann::json &description);
+
+/** Add a run to the runtime statistics and history of a job
+
+  @param job  the job record
+  @param run  the run of the job
+ */
+static void job_add_run(T_JOB_RECORD *job, const T_JOB_RUN &run);
+
+/** Return the 64-bit FNV-1a hash of the given contents
+
+  @param contents   the contents to hash
+ */
+static uint64_t contents_hash(const std::string &contents);
+
+/** Write all of the data to a file
+
+  @param fd     file descriptor
+  @param data   the data to write
+  @return true if successfull, false otherwise
+ */
+static bool write_all(int fd, const std::string &data);
+
+/** Return the modification time of a file, in nanoseconds
 
+  @param fname  the path to the file
+  @return the modification time, 0 if the file does not exist
+ */
+static int64_t file_mtime(const std::string &fname);
+
+/** Flush the directory containing a file to disk, so that renaming the file is durable
+
+  @param fname  the path to the file
+ */
+static void sync_directory(const std::string &fname);
+
+/** Replace the JSON file with the new contents
+
+  The contents are written to a temporary file, which is flushed to disk 
+  and then renamed over the JSON file. Either the old or the new contents
+  are found in the JSON file, should the server stop at any point.
+
+  @param fname      the path to the JSON file
+  @param contents   the new contents
+  @param mtime      on return, contains the modification time of the new file
+  @return true if successfull, false otherwise
+ */
+static bool snapshot_write(const std::string &fname, const std::string &contents, int64_t *mtime);
+
+/** Create a journal, with the given header and records
+
+  @param fname    the path to the journal
+  @param header   the header of the journal
+  @param records  the records of the journal, each ending with a newline
+  @param sync     the synchronization policy of the journal
+  @return the file descriptor of the journal, -1 in case of error
+ */
+static int journal_create(const std::string &fname, const nlohmann::json &header, const std::vector<std::string> &records, T_JOURNAL_SYNC sync);
+
+/** Return the shard of a job
+
+  @param name   the name of the job
+  @return the index of the shard
+ */
+static size_t job_shard(const std::string &name);
+
+/*--------------- Class Implemementation --------------------------------------*/
 KiwibesDatabase::KiwibesDatabase()
 {
   dbpath.reset(new std::string(""));
-  dbjobs.reset(new nlohmann::json);
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    dbshards[s].slots.reset(new T_JOB_SLOTS());
+    dbshards[s].fresh.reset(new T_JOB_SLOTS());
+    dbshards[s].dead  = 0;
+    dbshards[s].dirty = true;
+  }
+  dbcount     = 0;
+  dbunsaved   = true;
+  dbrunning   = 0;
+  dbpending   = 0;
+  dbtimeouts  = 0;
+  dbhash      = 0;
+  dbmtime     = 0;
+  dbbinary    = false;
+  journal     = -1;
+  jrecords    = 0;
+  jrotated    = false;
+  jsync       = JOURNAL_SYNC_NONE;
+  jdelay      = 0;
+  jwriting    = false;
+  jqueued     = 0;
+  jwritten    = 0;
+  saverequest = false;
+  saverexit   = false;
+
+  saver.reset(new std::thread(&KiwibesDatabase::saver_loop,this));
+  flusher.reset(new std::thread(&KiwibesDatabase::flusher_loop,this));
+}
+
+KiwibesDatabase::~KiwibesDatabase()
+{
+  /* ask the saver and flusher threads to exit, then wait for them to stop */
+  {
+    std::lock_guard<std::mutex> lock(jlock);
+    saverexit = true;
+  }
+  saverwake.notify_one();
+  flusherwake.notify_one();
+  saver->join();
+  flusher->join();
+
+  if(0 <= journal)
+  {
+    unsafe_journal_flush();
+    close(journal);
+  }
+}
+
+void KiwibesDatabase::set_journal_sync(T_JOURNAL_SYNC sync)
+{
+  std::lock_guard<std::mutex> lock(jlock);
+
+  jsync = sync;
+}
+
+void KiwibesDatabase::set_binary_snapshot(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(jlock);
+
+  dbbinary = enabled;
+}
+
+void KiwibesDatabase::set_group_commit(unsigned int delay)
+{
+  std::lock_guard<std::mutex> lock(jlock);
+
+  /* records buffered with the previous delay are written now */
+  unsafe_journal_flush();
+  jdelay = delay;
 }
 
 T_KIWIBES_ERROR KiwibesDatabase::load(const std::string &fname)
-{ 
-  std::lock_guard<std::mutex> lock(dblock);
+{
+  std::lock_guard<std::mutex> saving(savelock);
+  T_SHARD_LOCKS               shards;
 
-  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  lock_all_shards(shards);
+  std::lock_guard<std::mutex> lock(jlock);
+
+  T_KIWIBES_ERROR              error   = ERROR_NO_ERROR;
+  bool                         recover = false;
+  std::vector<T_JOB_RECORD>    jobs;
+  std::map<std::string,size_t> index;
 
   dbpath.reset(new std::string(fname));
-  dbjobs.reset(new nlohmann::json);
 
-  std::ifstream dbfile((*dbpath));
+  if(0 <= journal)
+  {
+    unsafe_journal_flush();
+    close(journal);
+  }
+  dbhash      = 0;
+  dbmtime     = 0;
+  journal     = -1;
+  jrecords    = 0;
+  jrotated    = false;
+  saverequest = false;
+  jtail.clear();
+
+  /* the binary snapshot is only used if the JSON file has not changed since it was written */
+  struct stat       info;
+  T_SNAPSHOT_SOURCE source = {0,0,0};
+  std::string       binary = (true == dbbinary) ? (*dbpath) + BINARY_SUFFIX : std::string("");
+
+  if(0 == stat(dbpath->c_str(),&info))
+  {
+    source.mtime = ((int64_t)info.st_mtim.tv_sec)*1000000000LL + info.st_mtim.tv_nsec;
+    source.size  = info.st_size;
+  }
+
+  if((true == dbbinary) && (0 < source.mtime) && (true == snapshot_load(binary,source,jobs)))
+  {
+    LOG_INFO << "loaded the binary snapshot: " << binary;
+    dbhash  = source.hash;
+    dbmtime = source.mtime;
+
+    for(size_t j = 0; j < jobs.size(); j++)
+    {
+      index[jobs[j].name] = j;
+    }
+  }
+  else
+  {
+    error = unsafe_load_json(binary,&jobs,&index);
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    /* a previous save might have been interrupted while the journal was rotated */
+    std::string jname = (*dbpath) + JOURNAL_SUFFIX;
+    int64_t     valid = 0;
+
+    recover = (0 == access((jname + JOURNAL_OLD_SUFFIX).c_str(),F_OK));
+    unsafe_replay_journal(jname + JOURNAL_OLD_SUFFIX,&jobs,&index,&valid,&recover);
+    valid = 0;
+
+    if((true == unsafe_replay_journal(jname,&jobs,&index,&valid,&recover)) && (false == recover))
+    {
+      /* keep appending to the journal, after the last valid record */
+      journal = open(jname.c_str(),O_WRONLY | O_APPEND | O_CLOEXEC);
+
+      if((0 <= journal) && (0 != ftruncate(journal,valid)))
+      {
+        LOG_CRIT << "failed to truncate the journal";
+      }
+    }
+  }
+
+  /* in case of errors, reset the database contents */
+  if(ERROR_NO_ERROR != error)
+  {
+    jobs.clear();
+    dbhash  = 0;
+    dbmtime = 0;
+  }
+
+  /* the loaded jobs are distributed to their shards, and replace the ones seen by the readers */
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    dbshards[s].jobs.clear();
+    dbshards[s].index.clear();
+    dbshards[s].dirty = true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ilock);
+
+    dbindexes.names.clear();
+    dbindexes.running.clear();
+    dbindexes.pending.clear();
+    dbindexes.starts.clear();
+    dbindexes.next.clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(slock);
+
+    dbstats.clear();
+  }
+  dbrunning  = 0;
+  dbpending  = 0;
+  dbtimeouts = 0;
+
+  for(size_t j = 0; j < jobs.size(); j++)
+  {
+    T_JOB_SHARD *shard = &dbshards[job_shard(jobs[j].name)];
+
+    dbrunning += (JOB_STATUS_RUNNING == jobs[j].status) ? 1 : 0;
+    dbpending += jobs[j].pending_start;
+    shard->index[jobs[j].name] = shard->jobs.size();
+    shard->jobs.push_back(std::move(jobs[j]));
+  }
+
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    for(size_t j = 0; j < dbshards[s].jobs.size(); j++)
+    {
+      dbshards[s].jobs[j].slot.reset(new T_JOB_SLOT());
+      unsafe_publish_job(&dbshards[s],&dbshards[s].jobs[j]);
+    }
+    unsafe_publish_slots(&dbshards[s]);
+  }
+
+  /* without a JSON file, there is nothing the journal could apply to */
+  dbcount   = jobs.size();
+  dbunsaved = (0 == dbmtime);
+
+  if((ERROR_NO_ERROR == error) && (true == recover))
+  {
+    /* the recovered changes are saved, so that there is a single journal again */
+    LOG_WARN << "recovering the database from an interrupted save";
+    unsafe_save(nullptr,nullptr);
+  }
+
+  return error;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::unsafe_load_json(const std::string &binary, std::vector<T_JOB_RECORD> *jobs, std::map<std::string,size_t> *index)
+{
+  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  std::ifstream   dbfile((*dbpath));
 
   if(true == dbfile.is_open())
   {
     try
     {
       /* load the database and then validate its contents */
-      nlohmann::json database;
-      dbfile >> *dbjobs;
+      std::stringstream contents;
+      contents << dbfile.rdbuf();
 
-      for(nlohmann::json::iterator job = dbjobs->begin() ; job != dbjobs->end(); job++)
-      {
-        const char *expected[] = { 
-          "program","max-runtime","avg-runtime","var-runtime","schedule","status",
-          "start-time","nbr-runs","pending-start",
-        };
+      nlohmann::json descriptions = nlohmann::json::parse(contents.str());
+      dbhash  = contents_hash(contents.str());
+      dbmtime = file_mtime(*dbpath);
 
-        for(unsigned int f = 0; f < sizeof(expected)/sizeof(const char *); f++)
+      for(nlohmann::json::iterator job = descriptions.begin() ; (ERROR_NO_ERROR == error) && (job != descriptions.end()); job++)
+      {
+        for(unsigned int f = 0; f < sizeof(JOB_FIELDS)/sizeof(const char *); f++)
         {
-          if(0 == job.value().count(expected[f]))
+          if(0 == job.value().count(JOB_FIELDS[f]))
           {
-            LOG_CRIT << "job '" << job.key() << "' missing filed '" << expected[f] << "'";
+            LOG_CRIT << "job '" << job.key() << "' missing filed '" << JOB_FIELDS[f] << "'";
             error = ERROR_JOB_DESCRIPTION_INVALID;
-            break;  
+            break;
           }
         }
 
         if(ERROR_NO_ERROR == error)
         {
-          /* valid job description, reset some of the fields */
-          job.value()["status"]        = "stopped";
-          job.value()["start-time"]    = 0;
-          job.value()["pending-start"] = 0;
-        }     
+          T_JOB_RECORD record;
+
+          if(false == job_from_json(job.key(),job.value(),&record))
+          {
+            LOG_CRIT << "job '" << job.key() << "' has invalid fields";
+            error = ERROR_JOB_DESCRIPTION_INVALID;
+          }
+          else
+          {
+            /* valid job description, reset some of the fields */
+            record.status        = JOB_STATUS_STOPPED;
+            record.start_time    = 0;
+            record.start_instant = 0;
+            record.instances     = 0;
+            record.pending_start = 0;
+
+            (*index)[record.name] = jobs->size();
+            jobs->push_back(std::move(record));
+          }
+        }
+      }
+
+      if((ERROR_NO_ERROR == error) && (0 < binary.size()))
+      {
+        /* the binary snapshot is missing or out of date, the next start uses the new one */
+        std::string                       snapshot;
+        std::vector<const T_JOB_RECORD *> records;
+        T_SNAPSHOT_SOURCE                 source = {dbhash,dbmtime,contents.str().size()};
+        int64_t                           mtime  = 0;
+
+        for(size_t j = 0; j < jobs->size(); j++)
+        {
+          records.push_back(&(*jobs)[j]);
+        }
+
+        snapshot_encode(records,snapshot);
+        snapshot_seal(snapshot,source);
+        snapshot_write(binary,snapshot,&mtime);
       }
     }
     catch(nlohmann::detail::parse_error &e)
@@ -99,341 +503,1862 @@ T_KIWIBES_ERROR KiwibesDatabase::load(const std::string &fname)
     error = ERROR_NO_DATABASE_FILE;
   }
 
-  /* in case of errors, reset the database contents */
-  if(ERROR_NO_ERROR != error)
+  return error;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::save(void)
+{
+  std::lock_guard<std::mutex>  saving(savelock);
+  T_SHARD_LOCKS                shards;
+
+  lock_all_shards(shards);
+  std::unique_lock<std::mutex> lock(jlock);
+
+  /* this also takes care of any pending request to the saver thread */
+  saverequest = false;
+  unsafe_save(&lock,&shards);
+
+  return ERROR_NO_ERROR;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::barrier(void)
+{
+  T_KIWIBES_ERROR error       = ERROR_NO_ERROR;
+  bool            unjournaled = false;
+
+  {
+    std::lock_guard<std::mutex> lock(jlock);
+
+    unsafe_journal_flush();
+
+    if(0 <= journal)
+    {
+      if(0 != fdatasync(journal))
+      {
+        LOG_CRIT << "failed to sync the journal";
+        error = ERROR_JOURNAL_SYNC_FAIL;
+      }
+    }
+    else
+    {
+      /* the changes are only on disk once the saver thread writes them */
+      unjournaled = saverequest;
+    }
+  }
+
+  if(true == unjournaled)
   {
-    dbjobs.reset(new nlohmann::json);
+    error = save();
   }
 
-  return error; 
+  return error;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::save(void)
+void KiwibesDatabase::flusher_loop(void)
+{
+  std::unique_lock<std::mutex> lock(jlock);
+
+  while(false == saverexit)
+  {
+    if(0 == jbuffer.size())
+    {
+      flusherwake.wait(lock);
+    }
+    else if(std::chrono::steady_clock::now() < jdeadline)
+    {
+      /* more changes can join the batch until the deadline */
+      flusherwake.wait_until(lock,jdeadline);
+    }
+    else
+    {
+      unsafe_journal_flush();
+    }
+  }
+}
+
+void KiwibesDatabase::saver_loop(void)
+{
+  std::unique_lock<std::mutex> lock(jlock);
+
+  /* a save still pending when asked to exit is done before the thread stops */
+  while((false == saverexit) || (true == saverequest))
+  {
+    if(false == saverequest)
+    {
+      saverwake.wait(lock);
+    }
+    else
+    {
+      /* the saver lock and the shard locks must always be taken before the journal lock */
+      lock.unlock();
+      std::lock_guard<std::mutex> saving(savelock);
+      T_SHARD_LOCKS               shards;
+
+      lock_all_shards(shards);
+      lock.lock();
+
+      /* all the requests made until now are merged into a single save */
+      if(true == saverequest)
+      {
+        saverequest = false;
+        unsafe_save(&lock,&shards);
+      }
+    }
+  }
+}
+
+void KiwibesDatabase::unsafe_save(std::unique_lock<std::mutex> *lock, T_SHARD_LOCKS *shards)
+{
+  if((nullptr == dbpath.get()) || (0 == dbpath->size()))
+  {
+    LOG_CRIT << "cannot save database because it is NULL";
+  }
+  else
+  {
+    std::string                       contents;
+    std::vector<const T_JOB_RECORD *> records;
+
+    /* the buffered records apply to the current JSON file, they go to its journal */
+    unsafe_journal_flush();
+
+    /* only the shards changed since the last save are converted to JSON again */
+    for(size_t s = 0; s < DATABASE_SHARDS; s++)
+    {
+      T_JOB_SHARD *shard = &dbshards[s];
+
+      if(true == shard->dirty)
+      {
+        shard->text.clear();
+
+        for(size_t j = 0; j < shard->jobs.size(); j++)
+        {
+          nlohmann::json one;
+          std::string    text;
+
+          job_to_json(&shard->jobs[j],&one[shard->jobs[j].name]);
+          text = one.dump(4);
+
+          /* keep the member of the object, without the braces around it */
+          shard->text += (0 < shard->text.size()) ? ",\n" : "";
+          shard->text += text.substr(2,text.size() - 4);
+        }
+        shard->dirty = false;
+      }
+
+      if(0 < shard->text.size())
+      {
+        contents += (0 < contents.size()) ? ",\n" : "";
+        contents += shard->text;
+      }
+
+      if(true == dbbinary)
+      {
+        for(size_t j = 0; j < shard->jobs.size(); j++)
+        {
+          records.push_back(&shard->jobs[j]);
+        }
+      }
+    }
+    contents = (0 < contents.size()) ? ("{\n" + contents + "\n}\n") : std::string("{}\n");
+
+    std::string fname    = (*dbpath);
+    std::string jname    = fname + JOURNAL_SUFFIX;
+    uint64_t    hash     = contents_hash(contents);
+    int64_t     mtime    = 0;
+    size_t      jold     = jrecords;
+    bool        success  = false;
+
+    if(0 <= journal)
+    {
+      /* changes made while the file is written go to a new journal, which
+         applies both to the current JSON file and to the one being written */
+      close(journal);
+      journal = -1;
+
+      if(0 == rename(jname.c_str(),(jname + JOURNAL_OLD_SUFFIX).c_str()))
+      {
+        nlohmann::json header;
+        header["snapshot"] = dbhash;
+        header["mtime"]    = dbmtime;
+        header["next"]     = hash;
+
+        jtail.clear();
+        journal  = journal_create(jname,header,jtail,jsync);
+        jrecords = 0;
+        jrotated = (0 <= journal);
+      }
+
+      if(0 > journal)
+      {
+        LOG_CRIT << "failed to rotate the journal";
+        journal = open(jname.c_str(),O_WRONLY | O_APPEND | O_CLOEXEC);
+      }
+    }
+
+    /* the binary snapshot is a copy of the JSON file, only known once it is written */
+    std::string binary;
+    bool        unlocked = (true == jrotated) && (nullptr != lock);
+
+    if(true == dbbinary)
+    {
+      snapshot_encode(records,binary);
+    }
+
+    if(true == unlocked)
+    {
+      /* the journal keeps the changes, so the database can be used meanwhile */
+      if(nullptr != shards)
+      {
+        shards->clear();
+      }
+      lock->unlock();
+    }
+
+    success = snapshot_write(fname,contents,&mtime);
+
+    if((true == success) && (0 < binary.size()))
+    {
+      T_SNAPSHOT_SOURCE source = {hash,mtime,contents.size()};
+      int64_t           bmtime = 0;
+
+      snapshot_seal(binary,source);
+      snapshot_write(fname + BINARY_SUFFIX,binary,&bmtime);
+    }
+
+    if(true == unlocked)
+    {
+      lock->lock();
+
+      /* the records of the changes made meanwhile are also in the tail of the journal */
+      unsafe_journal_flush();
+    }
+
+    if(true == success)
+    {
+      /* the file has all the changes, start a journal for it with the newer changes */
+      nlohmann::json header;
+      header["snapshot"] = hash;
+      header["mtime"]    = mtime;
+
+      dbhash    = hash;
+      dbmtime   = mtime;
+      dbunsaved = false;
+
+      int fd = journal_create(jname + TEMP_SUFFIX,header,jtail,jsync);
+
+      if((0 <= fd) && (0 == rename((jname + TEMP_SUFFIX).c_str(),jname.c_str())))
+      {
+        if(0 <= journal)
+        {
+          close(journal);
+        }
+        journal  = fd;
+        jrecords = jtail.size();
+        sync_directory(fname);
+      }
+      else
+      {
+        /* the current journal also applies to the new JSON file */
+        LOG_CRIT << "failed to start a new journal";
+        if(0 <= fd)
+        {
+          close(fd);
+        }
+      }
+      std::remove((jname + JOURNAL_OLD_SUFFIX).c_str());
+    }
+    else if(0 == access((jname + JOURNAL_OLD_SUFFIX).c_str(),F_OK))
+    {
+      /* the JSON file was not replaced, move the newer changes back into the old journal */
+      if(0 <= journal)
+      {
+        close(journal);
+      }
+
+      journal = open((jname + JOURNAL_OLD_SUFFIX).c_str(),O_WRONLY | O_APPEND | O_CLOEXEC);
+
+      for(size_t r = 0; (0 <= journal) && (r < jtail.size()); r++)
+      {
+        if(false == write_all(journal,jtail[r]))
+        {
+          LOG_CRIT << "failed to write to the journal";
+        }
+      }
+
+      if((0 <= journal) && (0 != rename((jname + JOURNAL_OLD_SUFFIX).c_str(),jname.c_str())))
+      {
+        LOG_CRIT << "failed to restore the journal";
+      }
+      jrecords += jold;
+    }
+
+    jrotated = false;
+    jtail.clear();
+  }
+}
+
+T_JOB_SHARD *KiwibesDatabase::lock_shard(const std::string &name, T_SHARD_LOCKS &locks)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  T_JOB_SHARD *shard = &dbshards[job_shard(name)];
+
+  locks.emplace_back(shard->lock);
 
-  unsafe_save();
+  /* the flag only changes while all the shards are locked, so it cannot be set
+     once the shard is locked. When set, the changes are saved in full. */
+  if(true == dbunsaved)
+  {
+    locks.clear();
+    lock_all_shards(locks);
+  }
 
-  return ERROR_NO_ERROR; 
-} 
+  return shard;
+}
 
-void KiwibesDatabase::unsafe_save(void)
+void KiwibesDatabase::lock_job_shards(const std::set<std::string> &names, T_SHARD_LOCKS &locks)
 {
-  if(nullptr == dbpath.get())
+  std::set<size_t> involved;
+
+  for(std::set<std::string>::const_iterator name = names.begin(); name != names.end(); name++)
+  {
+    involved.insert(job_shard(*name));
+  }
+
+  /* the shards are locked in order, so that operations on many jobs cannot deadlock */
+  for(std::set<size_t>::iterator s = involved.begin(); s != involved.end(); s++)
+  {
+    locks.emplace_back(dbshards[*s].lock);
+  }
+
+  if(true == dbunsaved)
+  {
+    locks.clear();
+    lock_all_shards(locks);
+  }
+}
+
+void KiwibesDatabase::lock_all_shards(T_SHARD_LOCKS &locks)
+{
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    locks.emplace_back(dbshards[s].lock);
+  }
+}
+
+bool KiwibesDatabase::unsafe_replay_journal(const std::string &fname, std::vector<T_JOB_RECORD> *jobs, std::map<std::string,size_t> *index, int64_t *valid, bool *recover)
+{
+  std::ifstream jfile(fname);
+  std::string   line;
+  bool          matches = false;
+
+  /* the journal must have been started for the contents of the JSON file, or be 
+     the journal of a JSON file that was being written when the server stopped */
+  if((true == jfile.is_open()) && std::getline(jfile,line))
+  {
+    try
+    {
+      nlohmann::json header = nlohmann::json::parse(line);
+
+      matches = (1 == header.count("snapshot")) && (dbhash == header["snapshot"].get<uint64_t>()) &&
+                (1 == header.count("mtime")) && (dbmtime == header["mtime"].get<int64_t>());
+
+      if(1 == header.count("next"))
+      {
+        matches  = matches || (dbhash == header["next"].get<uint64_t>());
+        *recover = true;
+      }
+      *valid = line.size() + 1;
+    }
+    catch(nlohmann::detail::exception &e)
+    {
+      matches = false;
+    }
+  }
+
+  if(false == matches)
+  {
+    LOG_INFO << "no journal to apply to the database: " << fname;
+  }
+  else
+  {
+    size_t applied = 0;
+
+    while(std::getline(jfile,line))
+    {
+      /* the last record might be incomplete, if the server did not exit cleanly */
+      if(true == jfile.eof())
+      {
+        LOG_WARN << "ignoring incomplete journal record";
+        break;
+      }
+
+      nlohmann::json record;
+
+      try
+      {
+        record = nlohmann::json::parse(line);
+      }
+      catch(nlohmann::detail::exception &e)
+      {
+        LOG_WARN << "ignoring invalid journal record: " << e.what();
+        break;
+      }
+
+      /* a complete record stays in the journal even if it cannot be applied, the next ones still are */
+      *valid += line.size() + 1;
+
+      try
+      {
+        std::vector<std::string> names;
+        T_JOB_RECORD             job;
+
+        if((std::string("delete") == record["op"].get<std::string>()) && (1 == record.count("names")))
+        {
+          names = record["names"].get<std::vector<std::string> >();
+        }
+        else if(std::string("delete") == record["op"].get<std::string>())
+        {
+          names.push_back(record["name"].get<std::string>());
+        }
+        else if(std::string("create") == record["op"].get<std::string>())
+        {
+          std::vector<T_JOB_RECORD> created;
+
+          /* the jobs were created together, either all of them are valid or the record is */
+          for(nlohmann::json::iterator entry = record["jobs"].begin(); entry != record["jobs"].end(); entry++)
+          {
+            T_JOB_RECORD job;
+
+            if((false == has_job_fields(entry.value())) || (false == job_from_json(entry.key(),entry.value(),&job)))
+            {
+              break;
+            }
+            created.push_back(std::move(job));
+          }
+
+          if(created.size() != record["jobs"].size())
+          {
+            LOG_WARN << "ignoring journal record of jobs with invalid fields";
+            continue;
+          }
+
+          for(size_t c = 0; c < created.size(); c++)
+          {
+            std::map<std::string,size_t>::iterator position = index->find(created[c].name);
+
+            if(position == index->end())
+            {
+              (*index)[created[c].name] = jobs->size();
+              jobs->push_back(std::move(created[c]));
+            }
+            else
+            {
+              (*jobs)[position->second] = std::move(created[c]);
+            }
+          }
+        }
+        else if(std::string("run") == record["op"].get<std::string>())
+        {
+          std::map<std::string,size_t>::iterator position = index->find(record["name"].get<std::string>());
+          T_JOB_RUN                              run;
+
+          run.start       = record["run"]["start"].get<int64_t>();
+          run.duration    = record["run"]["duration"].get<int64_t>();
+          run.exit_status = record["run"]["exit-status"].get<int32_t>();
+          run.signal      = record["run"]["signal"].get<int32_t>();
+          run.cpu_user    = (1 == record["run"].count("cpu-user"))    ? record["run"]["cpu-user"].get<int64_t>()    : 0;
+          run.cpu_system  = (1 == record["run"].count("cpu-system"))  ? record["run"]["cpu-system"].get<int64_t>()  : 0;
+          run.memory_peak = (1 == record["run"].count("memory-peak")) ? record["run"]["memory-peak"].get<int64_t>() : 0;
+          run.io_read     = (1 == record["run"].count("io-read"))     ? record["run"]["io-read"].get<int64_t>()     : 0;
+          run.io_write    = (1 == record["run"].count("io-write"))    ? record["run"]["io-write"].get<int64_t>()    : 0;
+
+          if(position == index->end())
+          {
+            LOG_WARN << "ignoring journal record of unknown job: " << record["name"].get<std::string>();
+            continue;
+          }
+          job_add_run(&(*jobs)[position->second],run);
+
+          if((1 == record["run"].count("timed-out")) && (true == record["run"]["timed-out"].get<bool>()))
+          {
+            (*jobs)[position->second].nbr_timeouts++;
+          }
+        }
+        else if((false == has_job_fields(record["job"])) || (false == job_from_json(record["name"].get<std::string>(),record["job"],&job)))
+        {
+          LOG_WARN << "ignoring journal record of job with invalid fields: " << record["name"].get<std::string>();
+          continue;
+        }
+        else
+        {
+          std::map<std::string,size_t>::iterator position = index->find(job.name);
+
+          job.status        = JOB_STATUS_STOPPED;
+          job.start_time    = 0;
+          job.start_instant = 0;
+          job.instances     = 0;
+          job.pending_start = 0;
+
+          if(position == index->end())
+          {
+            (*index)[job.name] = jobs->size();
+            jobs->push_back(std::move(job));
+          }
+          else
+          {
+            (*jobs)[position->second] = std::move(job);
+          }
+        }
+
+        for(size_t n = 0; n < names.size(); n++)
+        {
+          std::map<std::string,size_t>::iterator position = index->find(names[n]);
+
+          if(position != index->end())
+          {
+            /* the slots are not created yet, the last job simply takes the place of the deleted one */
+            size_t last = position->second;
+
+            index->erase(position);
+            if(last != (jobs->size() - 1))
+            {
+              (*jobs)[last] = std::move(jobs->back());
+              (*index)[(*jobs)[last].name] = last;
+            }
+            jobs->pop_back();
+          }
+        }
+      }
+      catch(nlohmann::detail::exception &e)
+      {
+        LOG_WARN << "ignoring journal record that cannot be applied: " << e.what();
+        continue;
+      }
+
+      applied++;
+    }
+
+    LOG_INFO << "applied " << applied << " journal records to the database";
+    jrecords += applied;
+  }
+
+  return matches;
+}
+
+void KiwibesDatabase::journal_job(const T_JOB_RECORD *job, T_SHARD_LOCKS *locks)
+{
+  nlohmann::json record;
+
+  record["op"]   = "set";
+  record["name"] = job->name;
+  job_to_json(job,&record["job"]);
+
+  journal_append(record,locks);
+}
+
+void KiwibesDatabase::journal_append(const nlohmann::json &record, T_SHARD_LOCKS *locks)
+{
+  /* the record is serialized before taking the journal lock, which is shared by all the shards */
+  journal_append_line(record.dump() + "\n",locks);
+}
+
+void KiwibesDatabase::journal_append_line(const std::string &line, T_SHARD_LOCKS *locks)
+{
+  std::unique_lock<std::mutex> lock(jlock);
+  uint64_t                     queued = 0;
+
+  /* the journal can only be started for a JSON file that was loaded or saved */
+  if((0 > journal) && (0 != dbmtime))
+  {
+    unsafe_journal_start();
+  }
+
+  if((0 > journal) && (true == dbunsaved))
+  {
+    /* without a journal, the only option is to save the whole database,
+       which is possible because all the shards are locked */
+    unsafe_save(nullptr,nullptr);
+  }
+  else if(0 > journal)
+  {
+    saverequest = true;
+    saverwake.notify_one();
+  }
+  else
+  {
+    if(0 < jdelay)
+    {
+      /* the first record of a batch sets when the batch is written */
+      if(0 == jbuffer.size())
+      {
+        jdeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(jdelay);
+        flusherwake.notify_one();
+      }
+      jbuffer += line;
+    }
+    else
+    {
+      /* the record is written by the first writer to find the journal idle */
+      jbuffer += line;
+      queued   = ++jqueued;
+    }
+
+    /* the journal of the JSON file being written must have this record */
+    if(true == jrotated)
+    {
+      jtail.push_back(line);
+    }
+
+    jrecords++;
+
+    if(jrecords > std::max((size_t)JOURNAL_MIN_RECORDS,(size_t)dbcount))
+    {
+      saverequest = true;
+      saverwake.notify_one();
+    }
+  }
+
+  /* the record is queued after the previous changes of its jobs, so the next 
+     ones can be made while it is written, with the records of the other shards */
+  if(0 < queued)
+  {
+    locks->clear();
+  }
+
+  while(jwritten < queued)
+  {
+    if(true == jwriting)
+    {
+      jwrote.wait(lock);
+    }
+    else
+    {
+      unsafe_journal_commit(&lock);
+    }
+  }
+}
+
+void KiwibesDatabase::unsafe_journal_start(void)
+{
+  nlohmann::json header;
+  header["snapshot"] = dbhash;
+  header["mtime"]    = dbmtime;
+
+  if(0 <= journal)
+  {
+    close(journal);
+  }
+
+  journal  = journal_create((*dbpath) + JOURNAL_SUFFIX,header,std::vector<std::string>(),jsync);
+  jrecords = 0;
+}
+
+void KiwibesDatabase::unsafe_journal_flush(void)
+{
+  /* the records being written without the journal lock go first */
+  std::lock_guard<std::mutex> writing(jwrite);
+
+  if((0 < jbuffer.size()) && (0 <= journal))
+  {
+    if(false == write_all(journal,jbuffer))
+    {
+      LOG_CRIT << "failed to write to the journal";
+    }
+    else if(JOURNAL_SYNC_ALWAYS == jsync)
+    {
+      fdatasync(journal);
+    }
+  }
+  jbuffer.clear();
+
+  /* the writers waiting for their records are done, even if the journal was closed */
+  jwritten = jqueued;
+  jwrote.notify_all();
+}
+
+void KiwibesDatabase::unsafe_journal_commit(std::unique_lock<std::mutex> *lock)
+{
+  std::unique_lock<std::mutex> writing(jwrite);
+  std::string                  batch;
+  uint64_t                     queued = jqueued;
+  int                          fd     = journal;
+  T_JOURNAL_SYNC               sync   = jsync;
+
+  /* the journal is not closed until the batch is written, see unsafe_journal_flush */
+  batch.swap(jbuffer);
+  jwriting = true;
+  lock->unlock();
+
+  if((0 <= fd) && (0 < batch.size()))
+  {
+    if(false == write_all(fd,batch))
+    {
+      LOG_CRIT << "failed to write to the journal";
+    }
+    else if(JOURNAL_SYNC_ALWAYS == sync)
+    {
+      fdatasync(fd);
+    }
+  }
+
+  writing.unlock();
+  lock->lock();
+  jwriting = false;
+  jwritten = std::max(jwritten,queued);
+  jwrote.notify_all();
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_started(const std::string &name)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else if(job->max_parallel <= job->instances)
+  {
+    LOG_WARN << "job '" << name << "' is already running, cannot start it again";
+    error = ERROR_JOB_IS_RUNNING;    
+  }
+  else
+  {
+    LOG_INFO << "has started, job '" << name << "'";
+
+    /* the start instant is that of the first of the running instances */
+    if(0 == job->instances)
+    {
+      job->status        = JOB_STATUS_RUNNING;
+      job->start_instant = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      job->start_time    = job->start_instant/1000;
+      dbrunning++;
+    }
+    job->instances++;
+
+    unsafe_publish_job(shard,job);
+  }
+
+  return error; 
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_stopped(const std::string &name)
+{
+  return job_stopped(name,0,0);
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_stopped(const std::string &name, int exit_status, int signal)
+{
+  return job_stopped(name,exit_status,signal,false);
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_stopped(const std::string &name, int exit_status, int signal, bool timed_out)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else if(JOB_STATUS_STOPPED == job->status)
+  {
+    LOG_WARN << "job '" << name << "' is already stopped, cannot stop it again";
+    error = ERROR_JOB_IS_NOT_RUNNING;    
+  }
+  else  
+  {
+    T_JOB_RUN run;
+    int64_t   now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    run.start       = job->start_instant;
+    run.duration    = std::max((int64_t)0,now - job->start_instant);
+    run.exit_status = exit_status;
+    run.signal      = signal;
+    run.cpu_user    = 0;
+    run.cpu_system  = 0;
+    run.memory_peak = 0;
+    run.io_read     = 0;
+    run.io_write    = 0;
+
+    unsafe_stop_instance(shard,job,run,timed_out,&locks);
+  }
+
+  return error;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_stopped(const std::string &name, const T_JOB_RUN &run, bool timed_out)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else if(JOB_STATUS_STOPPED == job->status)
+  {
+    LOG_WARN << "job '" << name << "' is already stopped, cannot stop it again";
+    error = ERROR_JOB_IS_NOT_RUNNING;    
+  }
+  else  
+  {
+    unsafe_stop_instance(shard,job,run,timed_out,&locks);
+  }
+
+  return error;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_incr_start_requests(const std::string &name)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else
+  {
+    LOG_INFO << "incremented start requests for job '" << name << "'";
+
+    job->pending_start++;
+    dbpending++;
+    unsafe_publish_job(shard,job);
+  }
+
+  return error; 
+}
+
+signed int KiwibesDatabase::job_decr_start_requests(const std::string &name)
+{
+  T_SHARD_LOCKS locks;
+  T_JOB_SHARD   *shard        = lock_shard(name,locks);
+  signed int    pending_start = -1;
+  T_JOB_RECORD  *job          = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+  }
+  else if(0 < job->pending_start)
+  {
+    LOG_INFO << "decremented start requests for job '" << name << "'";
+    job->pending_start--;
+    dbpending--;
+    pending_start = job->pending_start;
+    unsafe_publish_job(shard,job);
+  }
+
+  return pending_start;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::job_clear_start_requests(const std::string &name)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    LOG_CRIT << "could not find job '" << name << "'";
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else
+  {
+    LOG_INFO << "reseted all start requests for job '" << name << "'";
+
+    dbpending         -= job->pending_start;
+    job->pending_start = 0;
+    unsafe_publish_job(shard,job);
+  }
+
+  return error; 
+}
+void KiwibesDatabase::get_all_schedulable_jobs(std::vector<std::string> &jobs)
+{
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    /* the created jobs are moved to the slots before they leave the fresh slots */
+    std::shared_ptr<const T_JOB_SLOTS> fresh = std::atomic_load(&dbshards[s].fresh);
+    std::shared_ptr<const T_JOB_SLOTS> slots = std::atomic_load(&dbshards[s].slots);
+
+    for(T_JOB_SLOTS::const_iterator slot = slots->begin(); slot != slots->end(); slot++)
+    {
+      std::shared_ptr<const T_JOB_VIEW> view = std::atomic_load(&slot->second->view);
+
+      if((nullptr != view.get()) && (true == view->schedulable))
+      {
+        jobs.push_back(slot->first);
+      }
+    }
+    for(T_JOB_SLOTS::const_iterator slot = fresh->begin(); slot != fresh->end(); slot++)
+    {
+      std::shared_ptr<const T_JOB_VIEW> view = std::atomic_load(&slot->second->view);
+
+      if((nullptr != view.get()) && (true == view->schedulable) && (0 == slots->count(slot->first)))
+      {
+        jobs.push_back(slot->first);
+      }
+    }
+  }
+
+  /* the names are spread over the shards, return them in order */
+  std::sort(jobs.begin(),jobs.end());
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::get_job_next_start(std::time_t &next, const std::string &name, std::time_t from)
+{
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
+
+  if(nullptr == job)
+  {
+    error = ERROR_JOB_NAME_UNKNOWN;
+  }
+  else
+  {
+    KiwibesCron *cron = unsafe_get_cron(job);
+
+    if(false == cron->is_valid())
+    {
+      error = ERROR_JOB_SCHEDULE_INVALID;
+    }
+    else
+    {
+      next = cron->next(from);
+      index_next_start(name,next);
+    }
+  }
+
+  return error;
+}
+
+void KiwibesDatabase::get_all_jobs_forecast(std::map<std::string,std::vector<std::time_t> > &forecast, std::time_t from, std::time_t to, size_t max)
+{
+  T_SHARD_LOCKS locks;
+
+  lock_all_shards(locks);
+  forecast.clear();
+
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    std::vector<T_JOB_RECORD> &jobs = dbshards[s].jobs;
+
+    for(size_t j = 0; j < jobs.size(); j++)
+    {
+      if(0 < jobs[j].schedule.length())
+      {
+        KiwibesCron *cron = unsafe_get_cron(&jobs[j]);
+
+        if(true == cron->is_valid())
+        {
+          cron->next_n(from,to,forecast[jobs[j].name],max);
+        }
+      }
+    }
+  }
+}
+
+T_JOB_RECORD *KiwibesDatabase::unsafe_find_job(T_JOB_SHARD *shard, const std::string &name)
+{
+  std::map<std::string,size_t>::iterator index = shard->index.find(name);
+  T_JOB_RECORD                           *job  = nullptr;
+
+  if(shard->index.end() != index)
+  {
+    job = &shard->jobs[index->second];
+  }
+
+  return job;
+}
+
+KiwibesCron *KiwibesDatabase::unsafe_get_cron(T_JOB_RECORD *job)
+{
+  if(nullptr == job->cron.get())
+  {
+    job->cron.reset(new KiwibesCron(job->schedule));
+  }
+
+  return job->cron.get();
+}
+
+void KiwibesDatabase::unsafe_publish_job(T_JOB_SHARD *shard, T_JOB_RECORD *job)
+{
+  std::shared_ptr<T_JOB_VIEW> view(new T_JOB_VIEW());
+
+  view->fields      = *static_cast<const T_JOB_FIELDS *>(job);
+  view->schedulable = (0 < job->schedule.length()) && (true == unsafe_get_cron(job)->is_valid());
+
+  std::atomic_store(&job->slot->view,std::shared_ptr<const T_JOB_VIEW>(view));
+  shard->dirty = true;
+
+  unsafe_index_job(job,job->name);
+}
+
+void KiwibesDatabase::unsafe_publish_slots(T_JOB_SHARD *shard)
+{
+  std::shared_ptr<T_JOB_SLOTS> slots(new T_JOB_SLOTS());
+
+  for(size_t j = 0; j < shard->jobs.size(); j++)
+  {
+    (*slots)[shard->jobs[j].name] = shard->jobs[j].slot;
+  }
+
+  std::atomic_store(&shard->slots,std::shared_ptr<const T_JOB_SLOTS>(slots));
+  std::atomic_store(&shard->fresh,std::shared_ptr<const T_JOB_SLOTS>(new T_JOB_SLOTS()));
+  shard->dead = 0;
+}
+
+void KiwibesDatabase::unsafe_publish_slot(T_JOB_SHARD *shard, T_JOB_RECORD *job)
+{
+  std::shared_ptr<const T_JOB_SLOTS> slots = std::atomic_load(&shard->slots);
+  std::shared_ptr<const T_JOB_SLOTS> fresh = std::atomic_load(&shard->fresh);
+  T_JOB_SLOTS::const_iterator        slot  = slots->find(job->name);
+  std::shared_ptr<T_JOB_SLOT>        dead;
+
+  if(slots->end() != slot)
+  {
+    dead = slot->second;
+  }
+  else if(fresh->end() != (slot = fresh->find(job->name)))
+  {
+    dead = slot->second;
+  }
+
+  if(nullptr != dead.get())
+  {
+    /* the slot of the deleted job is empty, readers see the job once its view is published */
+    job->slot = dead;
+    shard->dead--;
+  }
+  else if((fresh->size() + 1)*(fresh->size() + 1) > slots->size())
+  {
+    /* copying the fresh slots costs as much as publishing all of them again */
+    unsafe_publish_slots(shard);
+  }
+  else
+  {
+    std::shared_ptr<T_JOB_SLOTS> created(new T_JOB_SLOTS(*fresh));
+
+    (*created)[job->name] = job->slot;
+    std::atomic_store(&shard->fresh,std::shared_ptr<const T_JOB_SLOTS>(created));
+  }
+}
+
+void KiwibesDatabase::unsafe_remove_job(T_JOB_SHARD *shard, std::map<std::string,size_t>::iterator index)
+{
+  size_t position = index->second;
+
+  std::atomic_store(&shard->jobs[position].slot->view,std::shared_ptr<const T_JOB_VIEW>());
+  shard->dead++;
+  shard->dirty = true;
+  dbpending   -= shard->jobs[position].pending_start;
+  unsafe_index_job(nullptr,index->first);
+
+  /* keep the array dense, by moving the last job into the place of the deleted one */
+  if(position != (shard->jobs.size() - 1))
+  {
+    shard->jobs[position] = std::move(shard->jobs.back());
+    shard->index[shard->jobs[position].name] = position;
+  }
+  shard->jobs.pop_back();
+  shard->index.erase(index);
+  dbcount--;
+}
+
+void KiwibesDatabase::get_all_job_names(std::vector<std::string> &jobs)
+{
+  jobs.clear();
+
+  for(size_t s = 0; s < DATABASE_SHARDS; s++)
+  {
+    /* the created jobs are moved to the slots before they leave the fresh slots */
+    std::shared_ptr<const T_JOB_SLOTS> fresh = std::atomic_load(&dbshards[s].fresh);
+    std::shared_ptr<const T_JOB_SLOTS> slots = std::atomic_load(&dbshards[s].slots);
+
+    for(T_JOB_SLOTS::const_iterator slot = slots->begin(); slot != slots->end(); slot++)
+    {
+      /* skip the slots of deleted jobs */
+      if(nullptr != std::atomic_load(&slot->second->view).get())
+      {
+        jobs.push_back(slot->first);
+      }
+    }
+    for(T_JOB_SLOTS::const_iterator slot = fresh->begin(); slot != fresh->end(); slot++)
+    {
+      if((nullptr != std::atomic_load(&slot->second->view).get()) && (0 == slots->count(slot->first)))
+      {
+        jobs.push_back(slot->first);
+      }
+    }
+  }
+
+  /* the names are spread over the shards, return them in order */
+  std::sort(jobs.begin(),jobs.end());
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::get_job_names_page(std::vector<std::string> &jobs, std::string &cursor, const T_JOB_FILTER &filter, size_t limit)
+{
+  T_KIWIBES_ERROR             error = ERROR_NO_ERROR;
+  std::lock_guard<std::mutex> lock(ilock);
+
+  jobs.clear();
+
+  if(0 == limit)
+  {
+    error = ERROR_JOB_LIST_INVALID;
+  }
+  else if(JOB_ORDER_NAME == filter.order)
+  {
+    /* iterate over the smallest index that holds all the matching jobs */
+    const std::set<std::string> *base = &dbindexes.names;
+
+    if((true == filter.by_status) && (JOB_STATUS_RUNNING == filter.status))
+    {
+      base = &dbindexes.running;
+    }
+    else if(true == filter.pending)
+    {
+      base = &dbindexes.pending;
+    }
+
+    /* the names with the prefix are all together, starting with the prefix itself */
+    std::set<std::string>::const_iterator name = ((0 < cursor.size()) && (0 < cursor.compare(filter.prefix))) ? 
+                                                 base->upper_bound(cursor) : base->lower_bound(filter.prefix);
+
+    for(; (base->end() != name) && (limit > jobs.size()); name++)
+    {
+      if(0 != name->compare(0,filter.prefix.size(),filter.prefix))
+      {
+        break;
+      }
+
+      if(((false == filter.by_status) || ((JOB_STATUS_RUNNING == filter.status) == (0 < dbindexes.running.count(*name)))) &&
+         ((false == filter.pending) || (0 < dbindexes.pending.count(*name))))
+      {
+        jobs.push_back(*name);
+      }
+    }
+
+    cursor = ((limit == jobs.size()) && (base->end() != name)) ? jobs.back() : "";
+  }
+  else
+  {
+    std::pair<std::time_t,std::string> start(0,"");
+    char                               *end = nullptr;
+    size_t                             sep  = cursor.find(':');
+
+    if(0 < cursor.size())
+    {
+      start.first  = (std::time_t)std::strtoll(cursor.c_str(),&end,10);
+      start.second = (std::string::npos == sep) ? "" : cursor.substr(sep + 1);
+
+      if((std::string::npos == sep) || (cursor.c_str() + sep != end))
+      {
+        error = ERROR_JOB_LIST_INVALID;
+      }
+    }
+
+    if(ERROR_NO_ERROR == error)
+    {
+      std::set<std::pair<std::time_t,std::string> >::const_iterator next = (0 < cursor.size()) ? 
+                                                                           dbindexes.starts.upper_bound(start) : dbindexes.starts.begin();
+
+      for(; (dbindexes.starts.end() != next) && (limit > jobs.size()); next++)
+      {
+        if((0 == next->second.compare(0,filter.prefix.size(),filter.prefix)) &&
+           ((false == filter.by_status) || ((JOB_STATUS_RUNNING == filter.status) == (0 < dbindexes.running.count(next->second)))) &&
+           ((false == filter.pending) || (0 < dbindexes.pending.count(next->second))))
+        {
+          jobs.push_back(next->second);
+          start = *next;
+        }
+      }
+
+      cursor = ((limit == jobs.size()) && (dbindexes.starts.end() != next)) ? (std::to_string(start.first) + ":" + start.second) : "";
+    }
+  }
+
+  return error;
+}
+
+T_KIWIBES_ERROR KiwibesDatabase::get_job_description(nlohmann::json &job, const std::string &name)
+{
+  /* the created jobs are moved to the slots before they leave the fresh slots */
+  std::shared_ptr<const T_JOB_SLOTS> fresh = std::atomic_load(&dbshards[job_shard(name)].fresh);
+  std::shared_ptr<const T_JOB_SLOTS> slots = std::atomic_load(&dbshards[job_shard(name)].slots);
+  T_JOB_SLOTS::const_iterator        slot  = slots->find(name);
+  std::shared_ptr<const T_JOB_VIEW>  view;
+  T_KIWIBES_ERROR                    error = ERROR_NO_ERROR;
+
+  if(slots->end() != slot)
+  {
+    view = std::atomic_load(&slot->second->view);
+  }
+  else if(fresh->end() != (slot = fresh->find(name)))
+  {
+    view = std::atomic_load(&slot->second->view);
+  }
+
+  if(nullptr == view.get())
   {
-    LOG_CRIT << "cannot save database because it is NULL";
+    error = ERROR_JOB_NAME_UNKNOWN;
   }
   else
   {
-    std::ofstream dbfile((*dbpath));
-    dbfile << std::setw(4) << (*dbjobs) << std::endl;
+    /* the first reader of the view builds its description, the others wait for it */
+    std::call_once(view->described,job_to_json,&view->fields,&view->description);
+    job = view->description;
   }
+
+  return error;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::job_started(const std::string &name)
+void KiwibesDatabase::unsafe_stop_instance(T_JOB_SHARD *shard, T_JOB_RECORD *job, const T_JOB_RUN &run, bool timed_out, T_SHARD_LOCKS *locks)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  LOG_INFO << "has stopped, job '" << job->name << "'";
 
-  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  /* update the job status and its runtime statistics, and those of the server. The
+     job remains running until the last of its instances stops
+   */
+  job_add_run(job,run);
+  job->instances -= (0 < job->instances) ? 1 : 0;
 
-  if(0 == (*dbjobs).count(name))
+  if(0 == job->instances)
   {
-    LOG_CRIT << "could not find job '" << name << "'";
-    error = ERROR_JOB_NAME_UNKNOWN;
+    dbrunning--;
+    job->status        = JOB_STATUS_STOPPED;
+    job->start_time    = 0;
+    job->start_instant = 0;
   }
-  else if(std::string("running") == (*dbjobs)[name]["status"].get<std::string>())
+
+  if(true == timed_out)
   {
-    LOG_WARN << "job '" << name << "' is already running, cannot start it again";
-    error = ERROR_JOB_IS_RUNNING;    
+    job->nbr_timeouts++;
+    dbtimeouts++;
   }
-  else
+
   {
-    LOG_INFO << "has started, job '" << name << "'";
+    std::lock_guard<std::mutex> lock(slock);
 
-    (*dbjobs)[name]["status"]     = "running";
-    (*dbjobs)[name]["start-time"] = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    dbstats.add(run);
   }
 
-  return error; 
+  /* only the run is journaled, it is added to the job again when replayed */
+  unsafe_publish_job(shard,job);
+  journal_append_line(run_to_record(job->name,run,timed_out),locks);
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::job_stopped(const std::string &name)
+void KiwibesDatabase::get_stats(nlohmann::json &stats)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
-  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
-
-  if(0 == (*dbjobs).count(name))
   {
-    LOG_CRIT << "could not find job '" << name << "'";
-    error = ERROR_JOB_NAME_UNKNOWN;
+    std::lock_guard<std::mutex> lock(slock);
+
+    stats = dbstats.to_json(now);
   }
-  else if(std::string("stopped") == (*dbjobs)[name]["status"].get<std::string>())
+
+  stats["jobs"]          = dbcount.load();
+  stats["running"]       = dbrunning.load();
+  stats["pending-start"] = dbpending.load();
+  stats["timed-out-runs"] = dbtimeouts.load();
+}
+
+void KiwibesDatabase::unsafe_index_job(const T_JOB_RECORD *job, const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(ilock);
+
+  if(nullptr == job)
   {
-    LOG_WARN << "job '" << name << "' is already stopped, cannot stop it again";
-    error = ERROR_JOB_IS_NOT_RUNNING;    
+    dbindexes.names.erase(name);
+    dbindexes.running.erase(name);
+    dbindexes.pending.erase(name);
   }
-  else  
+  else
   {
-    LOG_INFO << "has stopped, job '" << name << "'";
-   
-    std::time_t       now     = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    std::time_t       runtime = now - (*dbjobs)[name]["start-time"].get<std::time_t>();
-    unsigned long int runs    = (*dbjobs)[name]["nbr-runs"].get<unsigned long int>() + 1;
-    double            avg     = (*dbjobs)[name]["avg-runtime"].get<double>();
-    double            var     = (*dbjobs)[name]["var-runtime"].get<double>();
-    double            delta   = 1.0*(runtime - avg); 
-   
-    avg += delta/runs; 
-    var += delta*(runtime - avg);
-
-    /* update the job status and its runtime statistics */
-    (*dbjobs)[name]["status"]      = "stopped";
-    (*dbjobs)[name]["start-time"]  = 0;
-    (*dbjobs)[name]["avg-runtime"] = avg;
-    (*dbjobs)[name]["var-runtime"] = var;
-    (*dbjobs)[name]["nbr-runs"]    = runs;
-
-    /* save the changes to the job description */
-    unsafe_save();
+    dbindexes.names.insert(name);
+
+    if(JOB_STATUS_RUNNING == job->status)
+    {
+      dbindexes.running.insert(name);
+    }
+    else
+    {
+      dbindexes.running.erase(name);
+    }
+
+    if(0 < job->pending_start)
+    {
+      dbindexes.pending.insert(name);
+    }
+    else
+    {
+      dbindexes.pending.erase(name);
+    }
   }
 
-  return error;
+  /* the next start is only kept while the job can be scheduled */
+  if((nullptr == job) || (0 == job->schedule.length()) || (nullptr == job->cron.get()) || (false == job->cron->is_valid()))
+  {
+    std::map<std::string,std::time_t>::iterator next = dbindexes.next.find(name);
+
+    if(dbindexes.next.end() != next)
+    {
+      dbindexes.starts.erase(std::make_pair(next->second,name));
+      dbindexes.next.erase(next);
+    }
+  }
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::job_incr_start_requests(const std::string &name)
+void KiwibesDatabase::index_next_start(const std::string &name, std::time_t next)
 {
-  std::lock_guard<std::mutex> lock(dblock);
-
-  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  std::lock_guard<std::mutex>                 lock(ilock);
+  std::map<std::string,std::time_t>::iterator entry = dbindexes.next.find(name);
 
-  if(0 == (*dbjobs).count(name))
+  if(dbindexes.next.end() != entry)
   {
-    LOG_CRIT << "could not find job '" << name << "'";
-    error = ERROR_JOB_NAME_UNKNOWN;
+    dbindexes.starts.erase(std::make_pair(entry->second,name));
+    dbindexes.next.erase(entry);
   }
-  else
-  {
-    LOG_INFO << "incremented start requests for job '" << name << "'";
 
-    signed int pending_start = (*dbjobs)[name]["pending-start"].get<signed int>();
-    pending_start++;
-    (*dbjobs)[name]["pending-start"] = pending_start;
+  if(0 != next)
+  {
+    dbindexes.next[name] = next;
+    dbindexes.starts.insert(std::make_pair(next,name));
   }
+}
 
-  return error; 
+T_KIWIBES_ERROR KiwibesDatabase::delete_job(const std::string &name)
+{
+  return delete_jobs(std::vector<std::string>(1,name));
 }
 
-signed int KiwibesDatabase::job_decr_start_requests(const std::string &name)
+T_KIWIBES_ERROR KiwibesDatabase::delete_jobs(const std::vector<std::string> &names)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  T_KIWIBES_ERROR       error = ERROR_NO_ERROR;
+  std::set<std::string> unique(names.begin(),names.end());
+  T_SHARD_LOCKS         locks;
 
-  signed int pending_start = -1;
+  lock_job_shards(unique,locks);
 
-  if(0 == (*dbjobs).count(name))
+  /* either all the jobs are deleted, or none is */
+  for(std::set<std::string>::iterator name = unique.begin(); (ERROR_NO_ERROR == error) && (name != unique.end()); name++)
   {
-    LOG_CRIT << "could not find job '" << name << "'";
+    T_JOB_RECORD *job = unsafe_find_job(&dbshards[job_shard(*name)],*name);
+
+    if(nullptr == job)
+    {
+      error = ERROR_JOB_NAME_UNKNOWN;
+    }
+    else if(JOB_STATUS_RUNNING == job->status)
+    {
+      error = ERROR_JOB_IS_RUNNING;
+    }
   }
-  else
+
+  if((ERROR_NO_ERROR == error) && (0 < unique.size()))
   {
-    pending_start = (*dbjobs)[name]["pending-start"].get<signed int>();
+    std::set<size_t> shards;
 
-    if(0 < pending_start)
+    for(std::set<std::string>::iterator name = unique.begin(); name != unique.end(); name++)
     {
-      LOG_INFO << "decremented start requests for job '" << name << "'";
-      pending_start--;
-      (*dbjobs)[name]["pending-start"] = pending_start;
+      T_JOB_SHARD *shard = &dbshards[job_shard(*name)];
+
+      unsafe_remove_job(shard,shard->index.find(*name));
+      shards.insert(job_shard(*name));
     }
-    else
+
+    /* the slots are published once for all the jobs deleted from a shard */
+    for(std::set<size_t>::iterator s = shards.begin(); s != shards.end(); s++)
     {
-      pending_start = -1;
+      if(dbshards[*s].dead > dbshards[*s].jobs.size())
+      {
+        unsafe_publish_slots(&dbshards[*s]);
+      }
     }
+
+    nlohmann::json record;
+    record["op"]    = "delete";
+    record["names"] = std::vector<std::string>(unique.begin(),unique.end());
+
+    journal_append(record,&locks);
   }
 
-  return pending_start;
+  return error;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::job_clear_start_requests(const std::string &name)
+T_KIWIBES_ERROR KiwibesDatabase::create_job(const std::string &name, const nlohmann::json &details)
 {
-  std::lock_guard<std::mutex> lock(dblock);
-
+  /* verify the details contain the necessary information */
   T_KIWIBES_ERROR error = ERROR_NO_ERROR;
 
-  if(0 == (*dbjobs).count(name))
+  if((0 == details.count("program")) ||
+     (0 == details.count("schedule")) ||
+     (0 == details.count("max-runtime")))
   {
-    LOG_CRIT << "could not find job '" << name << "'";
-    error = ERROR_JOB_NAME_UNKNOWN;
+    error = ERROR_JOB_DESCRIPTION_INVALID;
   }
-  else
+
+  if(ERROR_NO_ERROR == error)
   {
-    LOG_INFO << "reseted all start requests for job '" << name << "'";
+    T_SHARD_LOCKS locks;
+    T_JOB_SHARD   *shard = lock_shard(name,locks);
+
+    if(shard->index.end() != shard->index.find(name))
+    {
+      error = ERROR_JOB_NAME_TAKEN;
+    }
+    else
+    {
+      T_JOB_RECORD job;
+
+      job_from_details(name,details,&job);
 
-    (*dbjobs)[name]["pending-start"] = 0;
+      shard->index[name] = shard->jobs.size();
+      shard->jobs.push_back(std::move(job));
+      dbcount++;
+
+      unsafe_publish_slot(shard,&shard->jobs.back());
+      unsafe_publish_job(shard,&shard->jobs.back());
+      journal_job(&shard->jobs.back(),&locks);
+    }
   }
 
-  return error; 
+  return error;
 }
 
-void KiwibesDatabase::get_all_schedulable_jobs(std::vector<std::string> &jobs)
+T_KIWIBES_ERROR KiwibesDatabase::create_jobs(const std::map<std::string,nlohmann::json> &jobs)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  T_KIWIBES_ERROR       error = ERROR_NO_ERROR;
+  std::set<std::string> names;
+  T_SHARD_LOCKS         locks;
+
+  /* verify the details contain the necessary information */
+  for(std::map<std::string,nlohmann::json>::const_iterator job = jobs.begin(); job != jobs.end(); job++)
+  {
+    if((0 == job->second.count("program")) || 
+       (0 == job->second.count("schedule")) || 
+       (0 == job->second.count("max-runtime")))
+    {
+      error = ERROR_JOB_DESCRIPTION_INVALID;
+    }
+    names.insert(job->first);
+  }
 
-  for(nlohmann::json::iterator job = dbjobs->begin() ; job != dbjobs->end(); job++)
+  if((ERROR_NO_ERROR == error) && (0 < jobs.size()))
   {
-    /* don bother to check empty schedule strings */
-    if(0 < job.value()["schedule"].get<std::string>().length())
+    lock_job_shards(names,locks);
+
+    /* either all the jobs are created, or none is */
+    for(std::set<std::string>::iterator name = names.begin(); (ERROR_NO_ERROR == error) && (name != names.end()); name++)
     {
-      KiwibesCron cron(job.value()["schedule"].get<std::string>());
-    
-      if(true == cron.is_valid())
+      if(nullptr != unsafe_find_job(&dbshards[job_shard(*name)],*name))
       {
-        jobs.push_back(job.key());
+        error = ERROR_JOB_NAME_TAKEN;
       }
     }
   }
-}
 
-void KiwibesDatabase::get_all_job_names(std::vector<std::string> &jobs)
-{
-  std::lock_guard<std::mutex> lock(dblock);
+  if((ERROR_NO_ERROR == error) && (0 < jobs.size()))
+  {
+    nlohmann::json   record;
+    std::set<size_t> involved;
 
-  jobs.clear();
+    record["op"]   = "create";
+    record["jobs"] = nlohmann::json::object();
 
-  for(nlohmann::json::iterator job = dbjobs->begin() ; job != dbjobs->end(); job++)
-  {
-    jobs.push_back(job.key());
+    for(std::map<std::string,nlohmann::json>::const_iterator details = jobs.begin(); details != jobs.end(); details++)
+    {
+      T_JOB_SHARD  *shard = &dbshards[job_shard(details->first)];
+      T_JOB_RECORD job;
+
+      job_from_details(details->first,details->second,&job);
+
+      shard->index[details->first] = shard->jobs.size();
+      shard->jobs.push_back(std::move(job));
+      dbcount++;
+
+      unsafe_publish_job(shard,&shard->jobs.back());
+      job_to_json(&shard->jobs.back(),&record["jobs"][details->first]);
+      involved.insert(job_shard(details->first));
+    }
+
+    for(std::set<size_t>::iterator s = involved.begin(); s != involved.end(); s++)
+    {
+      unsafe_publish_slots(&dbshards[*s]);
+    }
+
+    journal_append(record,&locks);
   }
+
+  return error;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::get_job_description(nlohmann::json &job, const std::string &name)
+T_KIWIBES_ERROR KiwibesDatabase::edit_job(const std::string &name, const nlohmann::json &details)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  T_SHARD_LOCKS   locks;
+  T_JOB_SHARD     *shard = lock_shard(name,locks);
+  T_KIWIBES_ERROR error  = ERROR_NO_ERROR;
+  T_JOB_RECORD    *job   = unsafe_find_job(shard,name);
 
-  T_KIWIBES_ERROR          error = ERROR_NO_ERROR;
-  nlohmann::json::iterator iter  = dbjobs->find(name);
-
-  if(dbjobs->end() == iter)
+  if(nullptr == job)
   {
     error = ERROR_JOB_NAME_UNKNOWN;
   }
+  else if(JOB_STATUS_RUNNING == job->status)
+  {
+    error = ERROR_JOB_IS_RUNNING; 
+  }  
   else
   {
-    job = iter.value();
-  }
+    /* set the job details */
+    if(1 == details.count("program"))
+    {
+      job->program = details["program"].get<std::vector<std::string> >();   
+    }
+    
+    if(1 == details.count("schedule"))
+    {
+      job->schedule = details["schedule"].get<std::string>();   
+      job->cron.reset();
+
+      /* the next start of the previous schedule no longer applies */
+      index_next_start(name,0);
+    }
+    
+    if(1 == details.count("max-runtime"))
+    {
+      job->max_runtime = details["max-runtime"].get<unsigned long int>();   
+    }
+
+    if(1 == details.count("max-parallel"))
+    {
+      job->max_parallel = std::max(1u,details["max-parallel"].get<unsigned int>());   
+    }
+
+    if(1 == details.count("priority"))
+    {
+      job->priority = details["priority"].get<signed int>();   
+    }
+
+    if(1 == details.count("max-memory"))
+    {
+      job->max_memory = details["max-memory"].get<unsigned int>();   
+    }
+
+    if(1 == details.count("max-cpu"))
+    {
+      job->max_cpu = details["max-cpu"].get<unsigned int>();   
+    }
 
+    unsafe_publish_job(shard,job);
+    journal_job(job,&locks);
+  }  
+  
   return error;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::delete_job(const std::string &name)
+/*--------------------- Private Functions Definitions ------------------------------*/
+static void job_to_json(const T_JOB_FIELDS *job, nlohmann::json *description)
+{
+  *description = job->extra;
+
+  (*description)["program"]       = job->program;
+  (*description)["schedule"]      = job->schedule;
+  (*description)["max-runtime"]   = job->max_runtime;
+  (*description)["max-parallel"]  = job->max_parallel;
+  (*description)["priority"]      = job->priority;
+  (*description)["max-memory"]    = job->max_memory;
+  (*description)["max-cpu"]       = job->max_cpu;
+  (*description)["avg-runtime"]   = job->avg_runtime;
+  (*description)["var-runtime"]   = job->var_runtime;
+  (*description)["status"]        = (JOB_STATUS_RUNNING == job->status) ? "running" : "stopped";
+  (*description)["start-time"]    = job->start_time;
+  (*description)["nbr-runs"]      = job->nbr_runs;
+  (*description)["nbr-timeouts"]  = job->nbr_timeouts;
+  (*description)["pending-start"] = job->pending_start;
+
+  if(0 < job->sketch.count())
+  {
+    (*description)["runtime-sketch"]             = job->sketch.to_json();
+    (*description)["runtime-percentiles"]["p50"] = job->sketch.quantile(0.50);
+    (*description)["runtime-percentiles"]["p95"] = job->sketch.quantile(0.95);
+    (*description)["runtime-percentiles"]["p99"] = job->sketch.quantile(0.99);
+    (*description)["runs"]                       = job->runs.to_json();
+  }
+}
+
+static std::string run_to_record(const std::string &name, const T_JOB_RUN &run, bool timed_out)
 {
-  std::lock_guard<std::mutex> lock(dblock);
+  /* only the name needs escaping, the other fields are numbers */
+  return "{\"op\":\"run\",\"name\":" + nlohmann::json(name).dump() +
+         ",\"run\":{\"start\":"     + std::to_string(run.start) +
+         ",\"duration\":"           + std::to_string(run.duration) +
+         ",\"exit-status\":"        + std::to_string(run.exit_status) +
+         ",\"signal\":"             + std::to_string(run.signal) +
+         ",\"cpu-user\":"           + std::to_string(run.cpu_user) +
+         ",\"cpu-system\":"         + std::to_string(run.cpu_system) +
+         ",\"memory-peak\":"        + std::to_string(run.memory_peak) +
+         ",\"io-read\":"            + std::to_string(run.io_read) +
+         ",\"io-write\":"           + std::to_string(run.io_write) +
+         ",\"timed-out\":"          + ((true == timed_out) ? "true" : "false") + "}}\n";
+}
 
-  T_KIWIBES_ERROR          error = ERROR_NO_ERROR;
-  nlohmann::json::iterator iter  = dbjobs->find(name);
+static bool job_from_json(const std::string &name, const nlohmann::json &description, T_JOB_RECORD *job)
+{
+  bool success = true;
 
-  if(dbjobs->end() == iter)
+  try
   {
-    error = ERROR_JOB_NAME_UNKNOWN;
+    job->name          = name;
+    job->program       = description["program"].get<std::vector<std::string> >();
+    job->schedule      = description["schedule"].get<std::string>();
+    job->max_runtime   = description["max-runtime"].get<std::time_t>();
+    job->avg_runtime   = description["avg-runtime"].get<double>();
+    job->var_runtime   = description["var-runtime"].get<double>();
+    job->status        = (std::string("running") == description["status"].get<std::string>()) ? JOB_STATUS_RUNNING : JOB_STATUS_STOPPED;
+    job->start_time    = description["start-time"].get<std::time_t>();
+    job->nbr_runs      = description["nbr-runs"].get<unsigned long int>();
+    job->pending_start = description["pending-start"].get<signed int>();
+    job->start_instant = 1000*(int64_t)job->start_time;
+    job->nbr_timeouts  = (1 == description.count("nbr-timeouts")) ? description["nbr-timeouts"].get<unsigned long int>() : 0;
+    job->max_parallel  = (1 == description.count("max-parallel")) ? std::max(1u,description["max-parallel"].get<unsigned int>()) : 1;
+    job->priority      = (1 == description.count("priority")) ? description["priority"].get<signed int>() : 0;
+    job->max_memory    = (1 == description.count("max-memory")) ? description["max-memory"].get<unsigned int>() : 0;
+    job->max_cpu       = (1 == description.count("max-cpu")) ? description["max-cpu"].get<unsigned int>() : 0;
+    job->instances     = (JOB_STATUS_RUNNING == job->status) ? 1 : 0;
+
+    /* the history of the runs is optional, the percentiles are derived from it */
+    job->sketch = KiwibesRuntimeSketch();
+    job->runs   = KiwibesRunHistory();
+
+    if(1 == description.count("runtime-sketch"))
+    {
+      success = job->sketch.from_json(description["runtime-sketch"]);
+    }
+    if((true == success) && (1 == description.count("runs")))
+    {
+      success = job->runs.from_json(description["runs"]);
+    }
+
+    /* fields unknown to the server are kept, and saved back as they are */
+    job->extra = description;
+    for(size_t f = 0; f < sizeof(JOB_FIELDS)/sizeof(const char *); f++)
+    {
+      job->extra.erase(JOB_FIELDS[f]);
+    }
+    for(size_t f = 0; f < sizeof(HISTORY_FIELDS)/sizeof(const char *); f++)
+    {
+      job->extra.erase(HISTORY_FIELDS[f]);
+    }
+    for(size_t f = 0; f < sizeof(LIMITS_FIELDS)/sizeof(const char *); f++)
+    {
+      job->extra.erase(LIMITS_FIELDS[f]);
+    }
   }
-  else if(std::string("running") == iter.value()["status"].get<std::string>())
+  catch(nlohmann::detail::exception &e)
   {
-    error = ERROR_JOB_IS_RUNNING; 
+    success = false;
   }
-  else
-  {
-    /* delete the job by patching the database */
-    nlohmann::json remove = R"([ { "op": "remove", "path": ""} ])"_json;
 
-    remove[0]["path"] = std::string("/") + name;
+  return success;
+}
+
+static void job_from_details(const std::string &name, const nlohmann::json &details, T_JOB_RECORD *job)
+{
+  /* set the job details */
+  job->name        = name;
+  job->program     = details["program"].get<std::vector<std::string> >();
+  job->schedule    = details["schedule"].get<std::string>();
+  job->max_runtime = details["max-runtime"].get<std::time_t>();
+
+  /* the limits are optional, by default a single instance runs at once, without resource limits */
+  job->max_parallel = (1 == details.count("max-parallel")) ? std::max(1u,details["max-parallel"].get<unsigned int>()) : 1;
+  job->priority     = (1 == details.count("priority")) ? details["priority"].get<signed int>() : 0;
+  job->max_memory   = (1 == details.count("max-memory")) ? details["max-memory"].get<unsigned int>() : 0;
+  job->max_cpu      = (1 == details.count("max-cpu")) ? details["max-cpu"].get<unsigned int>() : 0;
+
+  /* reset the job parameters */
+  job->avg_runtime   = 0.0;
+  job->var_runtime   = 0.0;
+  job->status        = JOB_STATUS_STOPPED;
+  job->pending_start = 0;
+  job->start_time    = 0;
+  job->start_instant = 0;
+  job->instances     = 0;
+  job->nbr_runs      = 0;
+  job->nbr_timeouts  = 0;
+  job->extra         = nlohmann::json::object();
+  job->slot.reset(new T_JOB_SLOT());
+}
 
-    nlohmann::json *new_db = new nlohmann::json(dbjobs->patch(remove));
-    dbjobs.reset(new_db);
+static void job_add_run(T_JOB_RECORD *job, const T_JOB_RUN &run)
+{
+  /* the runtime in seconds is the same as when the start and stop instants were in seconds */
+  std::time_t runtime = (run.start + run.duration)/1000 - run.start/1000;
+  double      delta   = 1.0*(runtime - job->avg_runtime); 
 
-    unsafe_save();
-  }
+  job->nbr_runs++;
+  job->avg_runtime += delta/job->nbr_runs; 
+  job->var_runtime += delta*(runtime - job->avg_runtime);
 
-  return error;  
+  job->sketch.add(run.duration);
+  job->runs.add(run);
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::create_job(const std::string &name, const nlohmann::json &details)
+static bool has_job_fields(const nlohmann::json &description)
 {
-  /* verify the details contain the necessary information */
-  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  bool complete = description.is_object();
 
-  if((0 == details.count("program")) || 
-     (0 == details.count("schedule")) || 
-     (0 == details.count("max-runtime")))
+  for(size_t f = 0; (true == complete) && (f < sizeof(JOB_FIELDS)/sizeof(const char *)); f++)
   {
-    error = ERROR_JOB_DESCRIPTION_INVALID;
+    complete = (1 == description.count(JOB_FIELDS[f]));
   }
 
-  if(ERROR_NO_ERROR == error)
+  return complete;
+}
+
+static uint64_t contents_hash(const std::string &contents)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  for(size_t c = 0; c < contents.size(); c++)
   {
-    std::lock_guard<std::mutex> lock(dblock);
+    hash ^= (uint8_t)contents[c];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
 
-    nlohmann::json::iterator iter  = dbjobs->find(name);
+static bool write_all(int fd, const std::string &data)
+{
+  size_t written = 0;
+
+  while(written < data.size())
+  {
+    ssize_t n = write(fd,data.data() + written,data.size() - written);
 
-    if(dbjobs->end() != iter)
+    if(0 <= n)
     {
-      error = ERROR_JOB_NAME_TAKEN;
+      written += n;
     }
-    else
+    else if(EINTR != errno)
     {
-      /* set the job details */
-      (*dbjobs)[name]["program"]     = details["program"].get<std::vector<std::string> >(); 
-      (*dbjobs)[name]["schedule"]    = details["schedule"].get<std::string>(); 
-      (*dbjobs)[name]["max-runtime"] = details["max-runtime"].get<std::time_t>(); 
+      break;
+    }
+  }
+
+  return (written == data.size());
+}
 
-      /* reset the job parameters */
-      (*dbjobs)[name]["avg-runtime"]   = 0.0; 
-      (*dbjobs)[name]["var-runtime"]   = 0.0; 
-      (*dbjobs)[name]["status"]        = "stopped"; 
-      (*dbjobs)[name]["pending-start"] = 0; 
-      (*dbjobs)[name]["start-time"]    = 0; 
-      (*dbjobs)[name]["nbr-runs"]      = 0; 
+static int64_t file_mtime(const std::string &fname)
+{
+  struct stat info;
+  int64_t     mtime = 0;
 
-      unsafe_save();
-    }  
+  if(0 == stat(fname.c_str(),&info))
+  {
+    mtime = ((int64_t)info.st_mtim.tv_sec)*1000000000LL + info.st_mtim.tv_nsec;
   }
 
-  return error;
+  return mtime;
 }
 
-T_KIWIBES_ERROR KiwibesDatabase::edit_job(const std::string &name, const nlohmann::json &details)
+static void sync_directory(const std::string &fname)
 {
-  std::lock_guard<std::mutex> lock(dblock);
-
-  T_KIWIBES_ERROR          error = ERROR_NO_ERROR;
-  nlohmann::json::iterator iter  = dbjobs->find(name);
+  size_t      slash = fname.rfind('/');
+  std::string dname = (std::string::npos == slash) ? std::string(".") : fname.substr(0,slash + 1);
+  int         dir   = open(dname.c_str(),O_RDONLY | O_DIRECTORY | O_CLOEXEC);
 
-  if(dbjobs->end() == iter)
+  if(0 <= dir)
   {
-    error = ERROR_JOB_NAME_UNKNOWN;
+    fsync(dir);
+    close(dir);
   }
-  else if(std::string("running") == iter.value()["status"].get<std::string>())
+}
+
+static bool snapshot_write(const std::string &fname, const std::string &contents, int64_t *mtime)
+{
+  std::string tname   = fname + TEMP_SUFFIX;
+  int         tfile   = open(tname.c_str(),O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,0644);
+  bool        success = false;
+
+  if(0 > tfile)
   {
-    error = ERROR_JOB_IS_RUNNING; 
-  }  
+    LOG_CRIT << "cannot open the temporary database file: " << tname;
+  }
   else
   {
-    /* set the job details */
-    if(1 == details.count("program"))
+    /* the contents are written at once, and must be on disk before the rename */
+    success = write_all(tfile,contents) && (0 == fsync(tfile));
+    close(tfile);
+
+    if(true == success)
     {
-      (*dbjobs)[name]["program"] = details["program"].get<std::vector<std::string> >();   
+      *mtime  = file_mtime(tname);
+      success = (0 == rename(tname.c_str(),fname.c_str()));
     }
-    
-    if(1 == details.count("schedule"))
+
+    if(true == success)
     {
-      (*dbjobs)[name]["schedule"] = details["schedule"].get<std::string>();   
+      sync_directory(fname);
     }
-    
-    if(1 == details.count("max-runtime"))
+    else
     {
-      (*dbjobs)[name]["max-runtime"] = details["max-runtime"].get<unsigned long int>();   
+      LOG_CRIT << "failed to save the database file: " << fname;
+      std::remove(tname.c_str());
     }
+  }
 
-    unsafe_save();
-  }  
-  
-  return error;
+  return success;
+}
+
+static int journal_create(const std::string &fname, const nlohmann::json &header, const std::vector<std::string> &records, T_JOURNAL_SYNC sync)
+{
+  std::string contents = header.dump() + "\n";
+  int         fd       = open(fname.c_str(),O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,0644);
+
+  for(size_t r = 0; r < records.size(); r++)
+  {
+    contents += records[r];
+  }
+
+  if(0 > fd)
+  {
+    LOG_CRIT << "cannot open the journal: " << fname;
+  }
+  else if(false == write_all(fd,contents))
+  {
+    LOG_CRIT << "failed to write to the journal: " << fname;
+    close(fd);
+    fd = -1;
+  }
+  else if(JOURNAL_SYNC_ALWAYS == sync)
+  {
+    fdatasync(fd);
+  }
+
+  return fd;
+}
+
+static size_t job_shard(const std::string &name)
+{
+  return std::hash<std::string>()(name) % DATABASE_SHARDS;
 }
@@ -24,19 +24,185 @@
 
   This class implements the interface layer for the database.
   On disk, the database is stored in a JSON file. Which is then
-  loaded and modified in memory.
+  loaded to memory, where each job is kept as a typed record in a 
+  dense array, indexed by the job name. The jobs are only converted 
+  to JSON when they are saved, or returned to the caller. The changes to the jobs are appended
+  to a journal, one JSON record per line, which is merged into the 
+  JSON file once it has enough records. The journal starts with the 
+  hash and modification time of the JSON file it applies to, so that
+  a journal left over from another JSON file is ignored. The JSON file 
+  is replaced atomically by a background thread, while the new changes 
+  go to a fresh journal. The parsed schedule of each job is cached in 
+  its record, and only parsed again when the job is edited.
+
+  The jobs are partitioned in shards by the hash of their names, each
+  with its own lock, so that unrelated jobs change in parallel. Changes 
+  to a job are journaled while holding the lock of its shard, so the
+  journal has the changes of each job in order. Operations on the whole
+  database take the locks of all the shards, always in the same order.
+  The journal lock is only held to queue a record: the first writer to 
+  find the journal idle writes and syncs the records queued by all the
+  shards at once, without the journal lock, while the others wait for it
+  without the locks of their shards.
+  Each shard caches the JSON text of its jobs, which is only built again
+  when the shard was changed since the last save. With group commit, the
+  journal records are buffered and written by a background thread, with 
+  a single write and sync for all the changes made within a short delay.
+
+  Readers do not lock the database. Each change to a job publishes a 
+  new immutable view of it, a copy of its fields which is swapped 
+  atomically into the slot of the job. The JSON description of a view is
+  only built by the first reader asking for it, and kept with the view.
+  Deleting a job empties its slot, and the map of slots of its shard is
+  only published again once it has more deleted jobs than existing ones.
+  A created job takes back the slot of a deleted job with the same name,
+  or is added to a small map of the slots of the recently created jobs,
+  so that creating jobs one at a time does not copy the map of all slots.
+  Readers keep using the views they have loaded, which are released 
+  once the last reader drops them.
+
+  Secondary indexes of the job names, by status, by pending start requests
+  and by next start, are updated with each published view. They are sorted,
+  so that listings of the jobs are paginated with a cursor, and only cost
+  as much as the page they return. The number of running jobs and of 
+  pending start requests, and the statistics of the runs of all the jobs,
+  are kept up to date by each change, so that reading them does not 
+  depend on the number of jobs.
 */
 #ifndef __KIWIBES_DATABASE_H__
 #define __KIWIBES_DATABASE_H__
 
 #include "kiwibes_errors.h"
+#include "kiwibes_cron.h"
 
 #include "nlohmann/json.h"
+#include "kiwibes_job_history.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 #include <memory>
+#include <thread>
+
+/** Synchronization policy of the journal
+ */
+typedef enum {
+  JOURNAL_SYNC_NONE,      /* the operating system writes the journal to disk */
+  JOURNAL_SYNC_ALWAYS,    /* each journal record is synced to disk before returning */
+} T_JOURNAL_SYNC;
+
+/** Status of a job
+ */
+typedef enum {
+  JOB_STATUS_STOPPED,     /* the job is not running */
+  JOB_STATUS_RUNNING,     /* the job is running */
+} T_JOB_STATUS;
+
+/** Description of a job, as kept in memory
+ */
+typedef struct {
+  std::string                  name;           /* the name of the job */
+  std::vector<std::string>     program;        /* the program to run and its arguments */
+  std::string                  schedule;       /* the schedule of the job, as a cron expression */
+  std::time_t                  max_runtime;    /* maximum runtime of the job, in seconds */
+  unsigned int                 max_parallel;   /* maximum number of instances of the job running at once */
+  signed int                   priority;       /* priority of the start requests of the job, higher first */
+  unsigned int                 max_memory;     /* maximum memory of each instance of the job in MB, 0 if there is no limit */
+  unsigned int                 max_cpu;        /* maximum CPU of each instance of the job in percent of a CPU, 0 if there is no limit */
+  double                       avg_runtime;    /* average runtime of the job, in seconds */
+  double                       var_runtime;    /* running sum of squares of the runtime differences */
+  T_JOB_STATUS                 status;         /* the status of the job */
+  std::time_t                  start_time;     /* instant the job started, 0 if it is not running */
+  unsigned int                 instances;      /* number of instances of the job running */
+  int64_t                      start_instant;  /* instant the job started in milliseconds, 0 if it is not running */
+  unsigned long int            nbr_runs;       /* number of times the job has run */
+  unsigned long int            nbr_timeouts;   /* number of runs stopped for exceeding the maximum runtime */
+  signed int                   pending_start;  /* number of pending start requests */
+  KiwibesRuntimeSketch         sketch;         /* quantiles of the runtimes, in milliseconds */
+  KiwibesRunHistory            runs;           /* the latest runs of the job */
+  nlohmann::json               extra;          /* other fields of the JSON description, kept as they are */
+} T_JOB_FIELDS;
+
+/** Immutable view of a job, shared with the readers of the database.
+    Its JSON description is only built by the first reader asking for it.
+ */
+typedef struct {
+  T_JOB_FIELDS           fields;        /* the fields of the job when the view was published */
+  bool                   schedulable;   /* true if the job has a valid schedule */
+  mutable std::once_flag described;     /* set once the JSON description is built */
+  mutable nlohmann::json description;   /* the JSON description of the job, built on first read */
+} T_JOB_VIEW;
+
+/** Slot where the latest view of a job is published
+ */
+typedef struct {
+  std::shared_ptr<const T_JOB_VIEW> view;   /* the latest view, NULL if the job was deleted, only accessed with std::atomic_load/std::atomic_store */
+} T_JOB_SLOT;
+
+/** Slots of all the jobs, by name
+ */
+typedef std::map<std::string,std::shared_ptr<T_JOB_SLOT> > T_JOB_SLOTS;
+
+/** Record of a job, its fields with the state only needed by the writers
+ */
+typedef struct T_JOB_RECORD_S : public T_JOB_FIELDS {
+  std::unique_ptr<KiwibesCron> cron;           /* the parsed schedule, NULL until it is needed */
+  std::shared_ptr<T_JOB_SLOT>  slot;           /* where the views of the job are published to readers */
+} T_JOB_RECORD;
+
+/** Order of a listing of jobs
+ */
+typedef enum {
+  JOB_ORDER_NAME,         /* the jobs are listed by name */
+  JOB_ORDER_NEXT_START,   /* the scheduled jobs are listed by their next start, then by name */
+} T_JOB_ORDER;
+
+/** Filter and order of a listing of jobs
+ */
+typedef struct {
+  bool         by_status;   /* set to true to only list the jobs with the given status */
+  T_JOB_STATUS status;      /* the status of the listed jobs */
+  bool         pending;     /* set to true to only list the jobs with pending start requests */
+  std::string  prefix;      /* only list the jobs whose names start with it */
+  T_JOB_ORDER  order;       /* the order of the listing */
+} T_JOB_FILTER;
+
+/** Secondary indexes of the jobs, by name
+ */
+typedef struct {
+  std::set<std::string>                          names;     /* names of all the jobs */
+  std::set<std::string>                          running;   /* names of the running jobs */
+  std::set<std::string>                          pending;   /* names of the jobs with pending start requests */
+  std::set<std::pair<std::time_t,std::string> >  starts;    /* next start of the scheduled jobs, in order */
+  std::map<std::string,std::time_t>              next;      /* next start of each scheduled job */
+} T_JOB_INDEXES;
+
+/** Number of shards of the database
+ */
+#define DATABASE_SHARDS   (16)
+
+/** A shard of the database, with the jobs whose names hash to it
+ */
+typedef struct {
+  std::mutex                         lock;    /* synchronize access to the shard, taken before the journal lock */
+  std::vector<T_JOB_RECORD>          jobs;    /* the jobs of the shard, kept in memory */
+  std::map<std::string,size_t>       index;   /* position of each job in the shard, by name */
+  std::shared_ptr<const T_JOB_SLOTS> slots;   /* slots of the jobs published to readers, only accessed with std::atomic_load/std::atomic_store */
+  std::shared_ptr<const T_JOB_SLOTS> fresh;   /* slots of the jobs created since the slots were published, loaded by readers before the slots */
+  size_t                             dead;    /* number of published slots of deleted jobs */
+  bool                               dirty;   /* set to true when the shard changes, until it is saved */
+  std::string                        text;    /* JSON text of the jobs of the shard, when it was last saved */
+} T_JOB_SHARD;
+
+/** Locks of the shards taken by an operation
+ */
+typedef std::vector<std::unique_lock<std::mutex> > T_SHARD_LOCKS;
 
 class KiwibesDatabase {
 
@@ -45,8 +211,41 @@ public:
    */
   KiwibesDatabase();
 
+  /** Class destructor
+   */
+  ~KiwibesDatabase();
+
+  /** Set the synchronization policy of the journal
+
+    @param sync   the synchronization policy
+   */
+  void set_journal_sync(T_JOURNAL_SYNC sync);
+
+  /** Enable or disable the binary snapshot of the JSON file
+
+    When enabled, a binary copy of the JSON file is written next to it
+    each time the database is saved, and it is loaded instead of the 
+    JSON file for as long as the latter is not changed.
+
+    @param enabled  true to enable the binary snapshot
+   */
+  void set_binary_snapshot(bool enabled);
+
+  /** Set the maximum delay of the group commit of the journal
+
+    When not zero, the journal records are buffered, and written to the journal
+    by a background thread, at most the given delay after the first of them. 
+    Changes made within the delay are written, and synced, all at once.
+
+    @param delay  the maximum delay, in milliseconds, 0 writes each record at once
+   */
+  void set_group_commit(unsigned int delay);
+
   /** Load the job descriptions to memory
 
+    The changes in the journal are applied on top of the JSON file, or on
+    top of its binary snapshot if it is enabled and up to date.
+
     @param fname  full path to the JSON file containing the database
     @return ERROR_NO_ERROR if successfull, error code otherwise
   */
@@ -55,26 +254,71 @@ public:
   /** Save the job descriptions to file
 
     The database is the JSON file "kiwibes.json" located in
-    the home folder. 
+    the home folder, which is replaced atomically. The journal 
+    is emptied.
 
     @return ERROR_NO_ERROR if successfull, error code otherwise
   */
   T_KIWIBES_ERROR save(void);
 
-  /** Update the job status to running
+  /** Wait until all the changes made so far are on disk
+
+    The buffered journal records are written and the journal is synced,
+    regardless of the synchronization policy. If there is no journal, the
+    database is saved instead.
+
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR barrier(void);
+
+  /** Update the job status to running, or add an instance to a running job
+
+    A job can have up to its maximum number of parallel instances running,
+    it remains running until the last of them stops.
 
     @param name   the name of the job
     @return ERROR_NO_ERROR if successfull, error code otherwise
   */
   T_KIWIBES_ERROR job_started(const std::string &name);
 
-  /** Update the job status to stopped
+  /** Update the job status to stopped, as if its process exited with status 0
 
     @param name   the name of the job
     @return ERROR_NO_ERROR if successfull, error code otherwise
   */
   T_KIWIBES_ERROR job_stopped(const std::string &name);
 
+  /** Update the job status to stopped, and add the run to its history
+
+    @param name         the name of the job
+    @param exit_status  exit status of the process, -1 if it was killed by a signal
+    @param signal       signal that killed the process, 0 if it exited
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR job_stopped(const std::string &name, int exit_status, int signal);
+
+  /** Update the job status to stopped, and add the run to its history
+
+    @param name         the name of the job
+    @param exit_status  exit status of the process, -1 if it was killed by a signal
+    @param signal       signal that killed the process, 0 if it exited
+    @param timed_out    true if the process was stopped for exceeding the maximum runtime
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR job_stopped(const std::string &name, int exit_status, int signal, bool timed_out);
+
+  /** Stop an instance of the job, with the run measured by the caller
+
+    Used when several instances of the job run at once, since the job
+    only keeps the instant the first of them started.
+
+    @param name         the name of the job
+    @param run          the run of the instance
+    @param timed_out    true if the process was stopped for exceeding the maximum runtime
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR job_stopped(const std::string &name, const T_JOB_RUN &run, bool timed_out);
+
   /** Increment the pending start requests for this job
 
     @param name   the name of the job
@@ -96,19 +340,54 @@ public:
    */
   T_KIWIBES_ERROR job_clear_start_requests(const std::string &name);
 
-  /** Return the names of the jobs that can be scheduled
+  /** Return the names of the jobs that can be scheduled, without locking the database
 
     @param jobs   on return contains the names of the jobs that can be scheduled
    */
   void get_all_schedulable_jobs(std::vector<std::string> &jobs);
 
-  /** Return the names of all jobs
+  /** Return the instant of the next start of the given job
+
+   @param next  on return contains the first occurrence of the job schedule after from
+   @param name  the name of the job
+   @param from  the instant to start searching from
+   @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR get_job_next_start(std::time_t &next, const std::string &name, std::time_t from);
+
+  /** Return the start instants of all jobs inside a window of time
+
+   @param forecast  on return contains the start instants of each schedulable job
+   @param from      the start instants are strictly after this instant
+   @param to        the start instants are at, or before, this instant
+   @param max       maximum number of start instants per job
+  */
+  void get_all_jobs_forecast(std::map<std::string,std::vector<std::time_t> > &forecast, std::time_t from, std::time_t to, size_t max);
+
+  /** Return the names of all jobs, without locking the database
 
     @param jobs   on return contains the names of all jobs  
    */
   void get_all_job_names(std::vector<std::string> &jobs);  
 
-  /** Return the description of the given job
+  /** Return a page of the names of the jobs that match a filter
+    
+    The listing starts after the cursor, which is the name of the last 
+    job of the previous page, or its next start and name separated by a
+    colon when the jobs are listed by next start. The next start of a job 
+    is the one last computed for the scheduler, and jobs that are not 
+    scheduled are not listed in that order.
+
+   @param jobs    on return contains the names of the jobs of the page
+   @param cursor  where to start the page, empty for the first one, on return 
+                  contains the cursor of the next page, empty if it is the last one
+   @param filter  the filter and order of the listing
+   @param limit   maximum number of jobs in the page
+   @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR get_job_names_page(std::vector<std::string> &jobs, std::string &cursor, const T_JOB_FILTER &filter, size_t limit);
+
+  /** Return the description of the given job, without locking the database
 
    @param job   on return contains the JSON description of the job
    @param name  the name of the job 
@@ -116,6 +395,15 @@ public:
   */
   T_KIWIBES_ERROR get_job_description(nlohmann::json &job, const std::string &name);
 
+  /** Return the statistics of the server, without locking the database
+
+   The statistics of the runs cover the runs that ended since the database
+   was loaded.
+
+   @param stats  on return contains the JSON description of the statistics
+  */
+  void get_stats(nlohmann::json &stats);
+
   /** Delete the job with the given name 
 
    @param name  the name of the job
@@ -123,6 +411,15 @@ public:
   */
   T_KIWIBES_ERROR delete_job(const std::string &name);
 
+  /** Delete the jobs with the given names, with a single record in the journal
+
+   No job is deleted if any of them does not exist, or is running.
+
+   @param names the names of the jobs
+   @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR delete_jobs(const std::vector<std::string> &names);
+
   /** Create a new job with the given details
 
    @param name      the name of the job 
@@ -131,6 +428,16 @@ public:
   */
   T_KIWIBES_ERROR create_job(const std::string &name, const nlohmann::json &details);
 
+  /** Create many jobs, with a single record in the journal
+
+   No job is created if the details of any of them are invalid, or if
+   any of the names is taken.
+
+   @param jobs  the description of each job, by name
+   @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR create_jobs(const std::map<std::string,nlohmann::json> &jobs);
+
   /** Update the job with the new details
 
    @param name      the name of the job 
@@ -140,14 +447,226 @@ public:
   T_KIWIBES_ERROR edit_job(const std::string &name, const nlohmann::json &details);
 
 private:
+  /** Loop of the saver thread, which saves the database when requested
+   */
+  void saver_loop(void);
+
+  /** Loop of the flusher thread, which writes the buffered journal records
+   */
+  void flusher_loop(void);
+
   /** Save the database to file, without locking it first
+
+    The locks of all the shards and of the journal must be taken.
+
+    @param lock     if not NULL, the journal lock, which is released while the JSON file is written
+    @param shards   if not NULL, the locks of the shards, which are released once the jobs are encoded
+   */
+  void unsafe_save(std::unique_lock<std::mutex> *lock, T_SHARD_LOCKS *shards);
+
+  /** Take the lock of the shard of a job, or of all the shards if the 
+      database must be saved in full before changes can be journaled
+
+    @param name     the name of the job
+    @param locks    on return, contains the locks taken
+    @return the shard of the job
+   */
+  T_JOB_SHARD *lock_shard(const std::string &name, T_SHARD_LOCKS &locks);
+
+  /** Take the locks of the shards of the given jobs, in order, or of all the 
+      shards if the database must be saved in full before changes can be journaled
+
+    @param names    the names of the jobs
+    @param locks    on return, contains the locks taken
+   */
+  void lock_job_shards(const std::set<std::string> &names, T_SHARD_LOCKS &locks);
+
+  /** Take the locks of all the shards, in order
+
+    @param locks    on return, contains the locks taken
+   */
+  void lock_all_shards(T_SHARD_LOCKS &locks);
+
+  /** Apply the records of a journal to the database, without locking it first
+
+    The journal must start with the hash and modification time of the JSON file,
+    or with the hash of the JSON file that was being written when it was started.
+
+    @param fname    path to the journal
+    @param jobs     the loaded jobs, on which the records are applied
+    @param index    position of each loaded job, by name
+    @param valid    on return, contains the length of the valid part of the journal
+    @param recover  set to true if the journal was left by an interrupted save
+    @return true if the journal was applied, false otherwise
+   */
+  bool unsafe_replay_journal(const std::string &fname, std::vector<T_JOB_RECORD> *jobs, std::map<std::string,size_t> *index, int64_t *valid, bool *recover);
+
+  /** Load the jobs from the JSON file, without locking the database first
+
+    @param binary   path to the binary snapshot to write, empty if none should be written
+    @param jobs     on return, contains the loaded jobs
+    @param index    on return, contains the position of each loaded job, by name
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+   */
+  T_KIWIBES_ERROR unsafe_load_json(const std::string &binary, std::vector<T_JOB_RECORD> *jobs, std::map<std::string,size_t> *index);
+
+  /** Append a record with the description of a job to the journal
+
+    The lock of the shard of the job must be taken.
+
+    @param job    the job record
+    @param locks  the lock of the shard of the job, released once the record is queued
+   */
+  void journal_job(const T_JOB_RECORD *job, T_SHARD_LOCKS *locks);
+
+  /** Append a record to the journal
+
+    The locks of the shards of the jobs in the record must be taken. 
+    The database is saved to file when the journal has enough records.
+
+    @param record   the journal record
+    @param locks    the locks of the shards, released once the record is queued
+   */
+  void journal_append(const nlohmann::json &record, T_SHARD_LOCKS *locks);
+
+  /** Append a record to the journal, already serialized
+
+    The locks of the shards of the jobs in the record must be taken. 
+    The database is saved to file when the journal has enough records.
+    Without group commit, it returns once the record is written. The locks
+    of the shards are released before waiting, the order of the records of
+    each job is already set by the queue.
+
+    @param line   the journal record, as a line of JSON text
+    @param locks  the locks of the shards, released once the record is queued
+   */
+  void journal_append_line(const std::string &line, T_SHARD_LOCKS *locks);
+
+  /** Start a new journal for the current JSON file, without locking the database first
+   */
+  void unsafe_journal_start(void);
+
+  /** Write the buffered records to the journal, without locking it first
+
+    It waits for the records being written without the journal lock, so that
+    the journal can be closed or replaced afterwards.
+   */
+  void unsafe_journal_flush(void);
+
+  /** Write and sync the queued records to the journal, releasing the journal lock meanwhile
+
+    @param lock   the journal lock, taken by the caller
+   */
+  void unsafe_journal_commit(std::unique_lock<std::mutex> *lock);
+
+  /** Return the record of a job, without locking its shard first
+
+    @param shard  the shard of the job
+    @param name   the name of the job
+    @return the job record, NULL if the job does not exist
+   */
+  T_JOB_RECORD *unsafe_find_job(T_JOB_SHARD *shard, const std::string &name);
+
+  /** Return the parsed schedule of a job, without locking its shard first.
+      The schedule is parsed and cached the first time it is requested.
+
+    @param job    the job record
+   */
+  KiwibesCron *unsafe_get_cron(T_JOB_RECORD *job);
+
+  /** Publish a new view of a job to the readers, without locking its shard first
+
+    @param shard  the shard of the job
+    @param job    the job record
+   */
+  void unsafe_publish_job(T_JOB_SHARD *shard, T_JOB_RECORD *job);
+
+  /** Stop an instance of a running job and add its run, without locking its shard first
+
+    @param shard      the shard of the job
+    @param job        the job record
+    @param run        the run of the instance
+    @param timed_out  true if the process was stopped for exceeding the maximum runtime
+    @param locks      the lock of the shard, released once the run is journaled
+   */
+  void unsafe_stop_instance(T_JOB_SHARD *shard, T_JOB_RECORD *job, const T_JOB_RUN &run, bool timed_out, T_SHARD_LOCKS *locks);
+
+  /** Publish a new map of job slots of a shard to the readers, without locking the shard first
+
+    @param shard  the shard
+   */
+  void unsafe_publish_slots(T_JOB_SHARD *shard);
+
+  /** Publish the slot of a created job to the readers, without locking its shard first
+
+    The job takes back the published slot of a deleted job with the same name. Otherwise
+    its slot is added to the recently created ones, until they are too many and all
+    the slots of the shard are published again.
+
+    @param shard  the shard of the job
+    @param job    the job record, before its view is published
+   */
+  void unsafe_publish_slot(T_JOB_SHARD *shard, T_JOB_RECORD *job);
+
+  /** Remove a job from its shard, without locking the shard first
+
+    The slot of the job is emptied, so that readers no longer see it. The caller
+    publishes the map of slots again, once per batch of removed jobs, if the shard
+    has more deleted jobs than existing ones.
+
+    @param shard  the shard of the job
+    @param index  the position of the job in the index of the shard
+   */
+  void unsafe_remove_job(T_JOB_SHARD *shard, std::map<std::string,size_t>::iterator index);
+
+  /** Update the secondary indexes with a job, without locking its shard first
+    @param job    the job record, NULL if the job was deleted
+    @param name   the name of the job
+   */
+  void unsafe_index_job(const T_JOB_RECORD *job, const std::string &name);
+
+  /** Update the next start of a job in the secondary indexes
+    @param name   the name of the job
+    @param next   the next start of the job, 0 if it is not scheduled
    */
-  void unsafe_save(void);
+  void index_next_start(const std::string &name, std::time_t next);
   
 private:
-  std::unique_ptr<std::string>    dbpath;   /* path to the Kiwibes database file */                     
-  std::mutex                      dblock;   /* synchronize access to the database */
-  std::unique_ptr<nlohmann::json> dbjobs;   /* the jobs database, kept in memory */ 
+  std::unique_ptr<std::string>    dbpath;                    /* path to the Kiwibes database file */
+  T_JOB_SHARD                     dbshards[DATABASE_SHARDS]; /* the jobs database, partitioned by the hash of the job names */
+  std::atomic<size_t>             dbcount;                   /* number of jobs in the database */
+  std::atomic<bool>               dbunsaved;                 /* set to true if the database must be saved in full before changes can be journaled */
+  std::atomic<int64_t>            dbrunning;                 /* number of running jobs */
+  std::atomic<int64_t>            dbpending;                 /* number of pending start requests of all the jobs */
+  std::atomic<uint64_t>           dbtimeouts;                /* number of runs stopped for exceeding the maximum runtime */
+  std::mutex                      slock;                     /* synchronize access to the statistics of the runs, taken after the shard locks */
+  KiwibesRunStatistics            dbstats;                   /* statistics of the runs of all the jobs */
+  std::mutex                      ilock;                     /* synchronize access to the secondary indexes, taken after the shard locks */
+  T_JOB_INDEXES                   dbindexes;                 /* secondary indexes of the jobs */
+  std::mutex                      jlock;                     /* synchronize access to the journal and the files, taken after the shard locks */
+  uint64_t                        dbhash;                    /* hash of the contents of the JSON file */
+  int64_t                         dbmtime;                   /* modification time of the JSON file, in nanoseconds */
+  bool                            dbbinary;                  /* set to true if the binary snapshot is enabled */
+  int                             journal;                   /* file descriptor of the journal, -1 if not open */
+  size_t                          jrecords;                  /* number of records in the journal */
+  bool                            jrotated;                  /* set to true while the JSON file is written by the saver thread */
+  std::vector<std::string>        jtail;                     /* records appended while the JSON file is written */
+  T_JOURNAL_SYNC                  jsync;                     /* synchronization policy of the journal */
+  unsigned int                    jdelay;                    /* maximum delay of the group commit, in milliseconds */
+  std::string                     jbuffer;                   /* records not yet written to the journal */
+  std::chrono::steady_clock::time_point jdeadline;           /* instant the buffered records must be written */
+  std::mutex                      jwrite;                    /* held while writing to the journal, taken after the journal lock */
+  std::condition_variable         jwrote;                    /* wakes up the writers waiting for their records */
+  bool                            jwriting;                  /* set to true while queued records are written without the journal lock */
+  uint64_t                        jqueued;                   /* number of records queued to be written */
+  uint64_t                        jwritten;                  /* number of queued records already written */
+  std::mutex                      savelock;                  /* only one save at a time, taken before the shard locks */
+  std::condition_variable         saverwake;                 /* wakes up the saver thread */
+  bool                            saverequest;               /* set to true when the database should be saved */
+  bool                            saverexit;                 /* set to true when the saver and flusher threads should exit */
+  std::unique_ptr<std::thread>    saver;                     /* the saver thread */
+  std::condition_variable         flusherwake;               /* wakes up the flusher thread */
+  std::unique_ptr<std::thread>    flusher;                   /* the flusher thread */
 };
 
 #endif
@@ -0,0 +1,170 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_deadlines.h"
+
+#include <utility>
+
+#if defined(__linux__)
+  #include <signal.h>
+#endif
+
+KiwibesDeadlines::KiwibesDeadlines(int64_t grace)
+{
+  dgrace = grace;
+}
+
+bool KiwibesDeadlines::insert(T_PROCESS_HANDLER handle, int64_t deadline)
+{
+  bool success = false;
+
+  if((0 == dposition.count(handle)) && (0 == dexpired.count(handle)))
+  {
+    T_DEADLINE entry = { deadline, handle, false };
+
+    dheap.push_back(entry);
+    dposition[handle] = dheap.size() - 1;
+    sift_up(dheap.size() - 1);
+    success = true;
+  }
+
+  return success;
+}
+
+bool KiwibesDeadlines::remove(T_PROCESS_HANDLER handle)
+{
+  std::unordered_map<T_PROCESS_HANDLER,size_t>::iterator iter = dposition.find(handle);
+
+  if(dposition.end() != iter)
+  {
+    erase(iter->second);
+  }
+
+  return (0 < dexpired.erase(handle));
+}
+
+int KiwibesDeadlines::expire(int64_t now, T_PROCESS_HANDLER &handle)
+{
+  int signal = 0;
+
+  if((0 < dheap.size()) && (dheap[0].deadline <= now))
+  {
+    handle = dheap[0].handle;
+    dexpired.insert(handle);
+
+    if(false == dheap[0].terminated)
+    {
+      /* ask the process to terminate, and give it some time to do so */
+      signal                = SIGTERM;
+      dheap[0].terminated   = true;
+      dheap[0].deadline    += dgrace;
+      sift_down(0);
+    }
+    else
+    {
+      signal = SIGKILL;
+      erase(0);
+    }
+  }
+
+  return signal;
+}
+
+int64_t KiwibesDeadlines::next(void) const
+{
+  return (0 < dheap.size()) ? dheap[0].deadline : -1;
+}
+
+size_t KiwibesDeadlines::size(void) const
+{
+  return dheap.size();
+}
+
+void KiwibesDeadlines::sift_up(size_t position)
+{
+  while((0 < position) && (dheap[position].deadline < dheap[(position - 1)/2].deadline))
+  {
+    swap(position,(position - 1)/2);
+    position = (position - 1)/2;
+  }
+}
+
+void KiwibesDeadlines::sift_down(size_t position)
+{
+  size_t earliest = position;
+
+  do
+  {
+    position = earliest;
+
+    size_t left  = 2*position + 1;
+    size_t right = 2*position + 2;
+
+    if((left < dheap.size()) && (dheap[left].deadline < dheap[earliest].deadline))
+    {
+      earliest = left;
+    }
+    if((right < dheap.size()) && (dheap[right].deadline < dheap[earliest].deadline))
+    {
+      earliest = right;
+    }
+
+    swap(position,earliest);
+  }
+  while(earliest != position);
+}
+
+void KiwibesDeadlines::swap(size_t a, size_t b)
+{
+  if(a != b)
+  {
+    std::swap(dheap[a],dheap[b]);
+    dposition[dheap[a].handle] = a;
+    dposition[dheap[b].handle] = b;
+  }
+}
+
+void KiwibesDeadlines::erase(size_t position)
+{
+  /* replace the deadline with the last one, which is then moved to its place */
+  dposition.erase(dheap[position].handle);
+
+  if((dheap.size() - 1) != position)
+  {
+    T_PROCESS_HANDLER moved = dheap.back().handle;
+
+    dheap[position]  = dheap.back();
+    dposition[moved] = position;
+    dheap.pop_back();
+
+    sift_up(position);
+    sift_down(dposition[moved]);
+  }
+  else
+  {
+    dheap.pop_back();
+  }
+}
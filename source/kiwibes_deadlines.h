@@ -0,0 +1,128 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the deadlines of the running jobs, as a binary
+  min-heap of the instants at which each process exceeds its maximum
+  runtime. A process which expires is first asked to terminate and, if it
+  is still running after a grace period, it expires again and is killed.
+  The position of each process in the heap is kept, so that its deadline
+  is removed in O(log n) when it exits. The heap is not synchronized, the 
+  owner must lock it.
+*/
+#ifndef __KIWIBES_DEADLINES_H__
+#define __KIWIBES_DEADLINES_H__
+
+#include "kiwibes_process_table.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** A deadline of a process
+ */
+typedef struct {
+  int64_t           deadline;     /* instant the process expires, in milliseconds */
+  T_PROCESS_HANDLER handle;       /* the handle of the process */
+  bool              terminated;   /* true if the process was already asked to terminate */
+} T_DEADLINE;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesDeadlines {
+
+public:
+  /** Class constructor
+
+    @param grace  time a process is given to terminate before being killed, in milliseconds
+   */
+  KiwibesDeadlines(int64_t grace);
+
+  /** Add the deadline of a process
+
+    @param handle     the handle of the process
+    @param deadline   instant the process expires, in milliseconds
+    @return true if successfull, false if the process already has a deadline
+   */
+  bool insert(T_PROCESS_HANDLER handle, int64_t deadline);
+
+  /** Remove the process, usually because it has exited
+
+    @param handle   the handle of the process
+    @return true if the process had expired, false otherwise
+   */
+  bool remove(T_PROCESS_HANDLER handle);
+
+  /** Expire the earliest deadline, if it is not after the given instant
+
+    The first time a process expires its deadline is moved by the grace
+    period, the second time it is removed from the heap.
+
+    @param now      the instant, in milliseconds
+    @param handle   on return, contains the handle of the expired process
+    @return the signal to send to the process, 0 if no deadline has expired
+   */
+  int expire(int64_t now, T_PROCESS_HANDLER &handle);
+
+  /** Return the earliest deadline, in milliseconds, -1 if there are none
+   */
+  int64_t next(void) const;
+
+  /** Return the number of deadlines in the heap
+   */
+  size_t size(void) const;
+
+private:
+  /** Move the deadline at the given position up, until the heap is ordered
+
+    @param position   the position of the deadline in the heap
+   */
+  void sift_up(size_t position);
+
+  /** Move the deadline at the given position down, until the heap is ordered
+
+    @param position   the position of the deadline in the heap
+   */
+  void sift_down(size_t position);
+
+  /** Swap two deadlines, and update their positions
+
+    @param a  position of the first deadline
+    @param b  position of the second deadline
+   */
+  void swap(size_t a, size_t b);
+
+  /** Remove the deadline at the given position
+
+    @param position   the position of the deadline in the heap
+   */
+  void erase(size_t position);
+
+  int64_t                                       dgrace;     /* grace period before killing a process, in milliseconds */
+  std::vector<T_DEADLINE>                       dheap;      /* the deadlines, earliest first */
+  std::unordered_map<T_PROCESS_HANDLER,size_t>  dposition;  /* position of each process in the heap */
+  std::unordered_set<T_PROCESS_HANDLER>         dexpired;   /* processes which have expired and are still running */
+};  
+
+#endif
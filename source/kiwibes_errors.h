@@ -50,6 +50,14 @@ typedef enum{
   ERROR_DATA_STORE_FULL,                  /* no more space in the data store */ 
   ERROR_AUTHENTICATION_FAIL,              /* failed the authentication verification */
   ERROR_HTTPS_CERTS_FAIL,                 /* failed to load the server certificate or private key */
+  ERROR_CMDLINE_INV_JOURNAL_SYNC,         /* invalid database journal synchronization policy */
+  ERROR_CMDLINE_INV_BINARY_SNAPSHOT,      /* invalid database binary snapshot setting */
+  ERROR_JOURNAL_SYNC_FAIL,                /* failed to sync the database journal to disk */
+  ERROR_CMDLINE_INV_GROUP_COMMIT,         /* invalid database group commit delay */
+  ERROR_JOB_LIST_INVALID,                 /* the filter or cursor of a job listing is invalid */
+  ERROR_INVOCATION_UNKNOWN,               /* unknown start invocation, or it was forgotten */
+  ERROR_OUTPUT_UNKNOWN,                   /* the output of the run is not kept */
+  ERROR_CMDLINE_INV_JOB_OUTPUT,           /* invalid job output spill setting */
 } T_KIWIBES_ERROR;
 
 #endif
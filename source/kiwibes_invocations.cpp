@@ -0,0 +1,107 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_invocations.h"
+
+#include <chrono>
+
+KiwibesInvocations::KiwibesInvocations(size_t retained)
+{
+  iretained = retained;
+  inext     = 1;
+}
+
+uint64_t KiwibesInvocations::create(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(ilock);
+
+  T_INVOCATION &invocation = itable[inext];
+
+  invocation.id     = inext;
+  invocation.name   = name;
+  invocation.status = INVOCATION_QUEUED;
+  invocation.error  = ERROR_NO_ERROR;
+
+  return inext++;
+}
+
+void KiwibesInvocations::finish(uint64_t id, T_INVOCATION_STATUS status, T_KIWIBES_ERROR error)
+{
+  {
+    std::lock_guard<std::mutex> lock(ilock);
+
+    std::unordered_map<uint64_t,T_INVOCATION>::iterator invocation = itable.find(id);
+
+    if(itable.end() != invocation)
+    {
+      invocation->second.status = status;
+      invocation->second.error  = error;
+      ifinished.push_back(id);
+
+      /* forget the oldest handled invocations */
+      while(iretained < ifinished.size())
+      {
+        itable.erase(ifinished.front());
+        ifinished.pop_front();
+      }
+    }
+  }
+
+  ihandled.notify_all();
+}
+
+T_KIWIBES_ERROR KiwibesInvocations::get(T_INVOCATION &invocation, uint64_t id, unsigned int wait)
+{
+  std::unique_lock<std::mutex>          lock(ilock);
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait);
+  T_KIWIBES_ERROR                       error    = ERROR_INVOCATION_UNKNOWN;
+
+  std::unordered_map<uint64_t,T_INVOCATION>::iterator entry   = itable.find(id);
+  bool                                                expired = false;
+
+  while((itable.end() != entry) && (INVOCATION_QUEUED == entry->second.status) && (false == expired))
+  {
+    expired = (std::cv_status::timeout == ihandled.wait_until(lock,deadline));
+
+    /* the table may have changed, or the invocation been forgotten, while waiting */
+    entry = itable.find(id);
+  }
+
+  if(itable.end() != entry)
+  {
+    invocation = entry->second;
+    error      = ERROR_NO_ERROR;
+  }
+
+  return error;
+}
+
+size_t KiwibesInvocations::size(void)
+{
+  std::lock_guard<std::mutex> lock(ilock);
+
+  return itable.size();
+}
@@ -0,0 +1,110 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the table of the start invocations of the jobs.
+  Each start request gets an invocation as soon as it is received, which
+  is updated once the launcher thread has handled the request. Callers can
+  poll an invocation, or wait for it to be handled. Only the most recent
+  handled invocations are remembered, the older ones are forgotten. The 
+  table is synchronized, and its lock is only held for short lookups.
+*/
+#ifndef __KIWIBES_INVOCATIONS_H__
+#define __KIWIBES_INVOCATIONS_H__
+
+#include "kiwibes_errors.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** Status of a start invocation
+ */
+typedef enum {
+  INVOCATION_QUEUED,    /* waiting for the launcher thread */
+  INVOCATION_STARTED,   /* the job was started */
+  INVOCATION_PENDING,   /* the job will start once it is admitted, it was over the concurrency limits */
+  INVOCATION_FAILED,    /* the job could not be started */
+} T_INVOCATION_STATUS;
+
+/** A start invocation of a job
+ */
+typedef struct {
+  uint64_t            id;       /* the identifier of the invocation, never 0 */
+  std::string         name;     /* the name of the job */
+  T_INVOCATION_STATUS status;   /* the status of the invocation */
+  T_KIWIBES_ERROR     error;    /* the reason the job could not be started, ERROR_NO_ERROR otherwise */
+} T_INVOCATION;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesInvocations {
+
+public:
+  /** Class constructor
+
+    @param retained   number of handled invocations which are remembered
+   */
+  KiwibesInvocations(size_t retained);
+
+  /** Add a new queued invocation
+
+    @param name   the name of the job
+    @return the identifier of the invocation
+   */
+  uint64_t create(const std::string &name);
+
+  /** Set the outcome of an invocation, and wake up those waiting for it
+
+    @param id       the identifier of the invocation
+    @param status   the status of the invocation, other than queued
+    @param error    the reason the job could not be started, ERROR_NO_ERROR otherwise
+   */
+  void finish(uint64_t id, T_INVOCATION_STATUS status, T_KIWIBES_ERROR error);
+
+  /** Return an invocation, after waiting for it to be handled
+
+    @param invocation   on return, contains the invocation
+    @param id           the identifier of the invocation
+    @param wait         maximum time to wait while it is queued, in milliseconds
+    @return ERROR_NO_ERROR if successfull, ERROR_INVOCATION_UNKNOWN if there is no such invocation
+   */
+  T_KIWIBES_ERROR get(T_INVOCATION &invocation, uint64_t id, unsigned int wait);
+
+  /** Return the number of invocations in the table
+   */
+  size_t size(void);
+
+private:
+  size_t                                   iretained;  /* number of handled invocations which are remembered */
+  uint64_t                                 inext;      /* identifier of the next invocation */
+  std::mutex                               ilock;      /* exclusive access to the table */
+  std::condition_variable                  ihandled;   /* signaled when invocations are handled */
+  std::unordered_map<uint64_t,T_INVOCATION> itable;    /* the invocations, by identifier */
+  std::deque<uint64_t>                     ifinished;  /* the handled invocations, oldest first */
+};  
+
+#endif
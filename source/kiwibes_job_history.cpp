@@ -0,0 +1,413 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_job_history.h"
+
+#include <cmath>
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Relative accuracy of the quantiles of the sketch
+ */
+#define SKETCH_ACCURACY     (0.01)
+
+/** Maximum number of bins of the sketch. With 1% accuracy, 1024 bins cover
+    runtimes from 1 ms to over 8 days before the lowest bins are merged
+ */
+#define SKETCH_MAX_BINS     (1024)
+
+/** Runtimes shorter than this, in milliseconds, are not placed in a bin
+ */
+#define SKETCH_MIN_RUNTIME  (1.0)
+
+/** Ratio between the upper and lower bounds of each bin
+ */
+static const double SKETCH_GAMMA     = (1.0 + SKETCH_ACCURACY)/(1.0 - SKETCH_ACCURACY);
+static const double SKETCH_LOG_GAMMA = std::log(SKETCH_GAMMA);
+
+/** Upper bound of each bucket of the runtime histogram, in seconds, the last one has none
+ */
+static const int64_t RUN_STATS_BOUNDS[RUN_STATS_BUCKETS - 1] = { 1, 10, 60, 600, 3600 };
+
+/*--------------- Class Implemementation --------------------------------------*/
+KiwibesRuntimeSketch::KiwibesRuntimeSketch()
+{
+  szeros = 0;
+  scount = 0;
+}
+
+void KiwibesRuntimeSketch::add(double runtime)
+{
+  if(SKETCH_MIN_RUNTIME > runtime)
+  {
+    szeros++;
+  }
+  else
+  {
+    sbins[(int32_t)std::ceil(std::log(runtime)/SKETCH_LOG_GAMMA)]++;
+    collapse();
+  }
+  scount++;
+}
+
+void KiwibesRuntimeSketch::merge(const KiwibesRuntimeSketch &other)
+{
+  restore(other.szeros,other.sbins);
+}
+
+double KiwibesRuntimeSketch::quantile(double q) const
+{
+  double value = 0.0;
+
+  if((0 < scount) && (0.0 <= q) && (1.0 >= q))
+  {
+    /* the value of the bin holding the runtime with the given rank */
+    double   rank = q*(scount - 1);
+    uint64_t seen = szeros;
+
+    for(std::map<int32_t,uint64_t>::const_iterator bin = sbins.begin(); (rank >= seen) && (bin != sbins.end()); bin++)
+    {
+      seen += bin->second;
+      value = 2.0*std::pow(SKETCH_GAMMA,bin->first)/(SKETCH_GAMMA + 1.0);
+    }
+  }
+
+  return value;
+}
+
+uint64_t KiwibesRuntimeSketch::count(void) const
+{
+  return scount;
+}
+
+uint64_t KiwibesRuntimeSketch::zeros(void) const
+{
+  return szeros;
+}
+
+const std::map<int32_t,uint64_t> &KiwibesRuntimeSketch::bins(void) const
+{
+  return sbins;
+}
+
+void KiwibesRuntimeSketch::restore(uint64_t zeros, const std::map<int32_t,uint64_t> &bins)
+{
+  szeros += zeros;
+  scount += zeros;
+
+  for(std::map<int32_t,uint64_t>::const_iterator bin = bins.begin(); bin != bins.end(); bin++)
+  {
+    sbins[bin->first] += bin->second;
+    scount            += bin->second;
+  }
+  collapse();
+}
+
+nlohmann::json KiwibesRuntimeSketch::to_json(void) const
+{
+  nlohmann::json sketch;
+
+  sketch["zeros"] = szeros;
+  sketch["bins"]  = nlohmann::json::array();
+
+  for(std::map<int32_t,uint64_t>::const_iterator bin = sbins.begin(); bin != sbins.end(); bin++)
+  {
+    sketch["bins"].push_back({ bin->first, bin->second });
+  }
+
+  return sketch;
+}
+
+bool KiwibesRuntimeSketch::from_json(const nlohmann::json &sketch)
+{
+  std::map<int32_t,uint64_t> bins;
+  uint64_t                   zeros   = 0;
+  bool                       success = sketch.is_object() && (1 == sketch.count("zeros")) && (1 == sketch.count("bins"));
+
+  try
+  {
+    if(true == success)
+    {
+      zeros = sketch["zeros"].get<uint64_t>();
+
+      for(size_t b = 0; (true == success) && (b < sketch["bins"].size()); b++)
+      {
+        success = (2 == sketch["bins"][b].size());
+        if(true == success)
+        {
+          bins[sketch["bins"][b][0].get<int32_t>()] += sketch["bins"][b][1].get<uint64_t>();
+        }
+      }
+    }
+  }
+  catch(nlohmann::detail::exception &e)
+  {
+    success = false;
+  }
+
+  if(true == success)
+  {
+    sbins.clear();
+    szeros = 0;
+    scount = 0;
+    restore(zeros,bins);
+  }
+
+  return success;
+}
+
+void KiwibesRuntimeSketch::collapse(void)
+{
+  /* the lowest runtimes lose accuracy, so that the highest quantiles keep it */
+  while(SKETCH_MAX_BINS < sbins.size())
+  {
+    std::map<int32_t,uint64_t>::iterator lowest = sbins.begin();
+    uint64_t                             count  = lowest->second;
+
+    sbins.erase(lowest);
+    sbins.begin()->second += count;
+  }
+}
+
+KiwibesRunHistory::KiwibesRunHistory()
+{
+  hnext = 0;
+}
+
+void KiwibesRunHistory::add(const T_JOB_RUN &run)
+{
+  if(JOB_HISTORY_MAX_RUNS > hruns.size())
+  {
+    hruns.push_back(run);
+  }
+  else
+  {
+    hruns[hnext] = run;
+    hnext        = (hnext + 1) % JOB_HISTORY_MAX_RUNS;
+  }
+}
+
+size_t KiwibesRunHistory::size(void) const
+{
+  return hruns.size();
+}
+
+const T_JOB_RUN &KiwibesRunHistory::at(size_t position) const
+{
+  return hruns[(hnext + position) % hruns.size()];
+}
+
+nlohmann::json KiwibesRunHistory::to_json(void) const
+{
+  nlohmann::json runs = nlohmann::json::array();
+
+  for(size_t r = 0; r < hruns.size(); r++)
+  {
+    const T_JOB_RUN &run = at(r);
+    nlohmann::json   entry;
+
+    entry["start"]       = run.start;
+    entry["duration"]    = run.duration;
+    entry["exit-status"] = run.exit_status;
+    entry["signal"]      = run.signal;
+    entry["cpu-user"]    = run.cpu_user;
+    entry["cpu-system"]  = run.cpu_system;
+    entry["memory-peak"] = run.memory_peak;
+    entry["io-read"]     = run.io_read;
+    entry["io-write"]    = run.io_write;
+    runs.push_back(entry);
+  }
+
+  return runs;
+}
+
+bool KiwibesRunHistory::from_json(const nlohmann::json &runs)
+{
+  std::vector<T_JOB_RUN> history;
+  bool                   success = runs.is_array();
+
+  try
+  {
+    for(size_t r = 0; (true == success) && (r < runs.size()); r++)
+    {
+      T_JOB_RUN run;
+
+      success = (1 == runs[r].count("start")) && (1 == runs[r].count("duration")) &&
+                (1 == runs[r].count("exit-status")) && (1 == runs[r].count("signal"));
+
+      if(true == success)
+      {
+        run.start       = runs[r]["start"].get<int64_t>();
+        run.duration    = runs[r]["duration"].get<int64_t>();
+        run.exit_status = runs[r]["exit-status"].get<int32_t>();
+        run.signal      = runs[r]["signal"].get<int32_t>();
+
+        /* the resources are not known for the runs of older databases */
+        run.cpu_user    = (1 == runs[r].count("cpu-user"))    ? runs[r]["cpu-user"].get<int64_t>()    : 0;
+        run.cpu_system  = (1 == runs[r].count("cpu-system"))  ? runs[r]["cpu-system"].get<int64_t>()  : 0;
+        run.memory_peak = (1 == runs[r].count("memory-peak")) ? runs[r]["memory-peak"].get<int64_t>() : 0;
+        run.io_read     = (1 == runs[r].count("io-read"))     ? runs[r]["io-read"].get<int64_t>()     : 0;
+        run.io_write    = (1 == runs[r].count("io-write"))    ? runs[r]["io-write"].get<int64_t>()    : 0;
+        history.push_back(run);
+      }
+    }
+  }
+  catch(nlohmann::detail::exception &e)
+  {
+    success = false;
+  }
+
+  if(true == success)
+  {
+    hruns.clear();
+    hnext = 0;
+
+    for(size_t r = 0; r < history.size(); r++)
+    {
+      add(history[r]);
+    }
+  }
+
+  return success;
+}
+
+KiwibesRunStatistics::KiwibesRunStatistics()
+{
+  clear();
+}
+
+void KiwibesRunStatistics::add(const T_JOB_RUN &run)
+{
+  size_t  bucket = 0;
+  int64_t second = (run.start + run.duration)/1000;
+  size_t  slot   = (size_t)(second % RUN_STATS_WINDOW);
+
+  ssketch.add((double)run.duration);
+  sruns++;
+  sfailures += ((0 != run.exit_status) || (0 != run.signal)) ? 1 : 0;
+  stotal    += (double)run.duration;
+  scpu      += run.cpu_user + run.cpu_system;
+
+  while(((RUN_STATS_BUCKETS - 1) > bucket) && ((RUN_STATS_BOUNDS[bucket]*1000) < run.duration))
+  {
+    bucket++;
+  }
+  shistogram[bucket]++;
+
+  /* each slot of the window counts the runs of a single second, the latest one seen */
+  if(second > sseconds[slot])
+  {
+    sseconds[slot] = second;
+    sended[slot]   = 0;
+  }
+  if(second == sseconds[slot])
+  {
+    sended[slot]++;
+  }
+}
+
+void KiwibesRunStatistics::clear(void)
+{
+  ssketch   = KiwibesRuntimeSketch();
+  sruns     = 0;
+  sfailures = 0;
+  stotal    = 0.0;
+  scpu      = 0;
+
+  for(size_t b = 0; b < RUN_STATS_BUCKETS; b++)
+  {
+    shistogram[b] = 0;
+  }
+
+  for(size_t s = 0; s < RUN_STATS_WINDOW; s++)
+  {
+    sseconds[s] = -1;
+    sended[s]   = 0;
+  }
+}
+
+uint64_t KiwibesRunStatistics::runs(void) const
+{
+  return sruns;
+}
+
+uint64_t KiwibesRunStatistics::failures(void) const
+{
+  return sfailures;
+}
+
+double KiwibesRunStatistics::mean_runtime(void) const
+{
+  return (0 < sruns) ? stotal/sruns : 0.0;
+}
+
+int64_t KiwibesRunStatistics::cpu_time(void) const
+{
+  return scpu;
+}
+
+uint64_t KiwibesRunStatistics::recent_runs(int64_t now) const
+{
+  uint64_t runs   = 0;
+  int64_t  second = now/1000;
+
+  for(size_t s = 0; s < RUN_STATS_WINDOW; s++)
+  {
+    if((second >= sseconds[s]) && ((second - RUN_STATS_WINDOW) < sseconds[s]))
+    {
+      runs += sended[s];
+    }
+  }
+
+  return runs;
+}
+
+const KiwibesRuntimeSketch &KiwibesRunStatistics::sketch(void) const
+{
+  return ssketch;
+}
+
+nlohmann::json KiwibesRunStatistics::to_json(int64_t now) const
+{
+  nlohmann::json stats;
+
+  stats["runs"]                       = sruns;
+  stats["failed-runs"]                = sfailures;
+  stats["runs-per-minute"]            = recent_runs(now);
+  stats["avg-runtime"]                = mean_runtime()/1000.0;
+  stats["cpu-time"]                   = scpu/1000000.0;
+  stats["runtime-percentiles"]["p50"] = ssketch.quantile(0.50);
+  stats["runtime-percentiles"]["p95"] = ssketch.quantile(0.95);
+  stats["runtime-percentiles"]["p99"] = ssketch.quantile(0.99);
+
+  for(size_t b = 0; b < RUN_STATS_BUCKETS; b++)
+  {
+    std::string bound = ((RUN_STATS_BUCKETS - 1) > b) ? std::to_string(RUN_STATS_BOUNDS[b]) : std::string("+inf");
+
+    stats["runtime-histogram"][bound] = shistogram[b];
+  }
+
+  return stats;
+}
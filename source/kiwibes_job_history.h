@@ -0,0 +1,237 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  History of the runs of a job. The runtimes are summarized by a DDSketch,
+  which answers quantile queries within 1% of the true value, using at most
+  a fixed number of logarithmic bins. Sketches can be merged. The latest
+  runs are kept as they are, in a ring buffer.
+
+  The runs of all the jobs are also aggregated, in counters that are 
+  updated as each run is added: the number of runs and failures, the total
+  runtime and CPU time, a histogram and a sketch of the runtimes, and the 
+  runs that ended in each of the last seconds.
+*/
+#ifndef __KIWIBES_JOB_HISTORY_H__
+#define __KIWIBES_JOB_HISTORY_H__
+
+#include "nlohmann/json.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** Maximum number of runs kept for each job
+ */
+#define JOB_HISTORY_MAX_RUNS  (32)
+
+/** Number of seconds in the window of the recent runs
+ */
+#define RUN_STATS_WINDOW      (60)
+
+/** Number of buckets of the runtime histogram
+ */
+#define RUN_STATS_BUCKETS     (6)
+
+/** A run of a job
+ */
+typedef struct {
+  int64_t start;          /* instant the run started, in milliseconds since the epoch */
+  int64_t duration;       /* duration of the run, in milliseconds */
+  int32_t exit_status;    /* exit status of the process, -1 if it was killed by a signal */
+  int32_t signal;         /* signal that killed the process, 0 if it exited */
+  int64_t cpu_user;       /* CPU time spent in user mode, in microseconds */
+  int64_t cpu_system;     /* CPU time spent in kernel mode, in microseconds */
+  int64_t memory_peak;    /* peak memory usage, in bytes */
+  int64_t io_read;        /* number of bytes read from storage */
+  int64_t io_write;       /* number of bytes written to storage */
+} T_JOB_RUN;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesRuntimeSketch {
+
+public:
+  /** Class constructor
+   */
+  KiwibesRuntimeSketch();
+
+  /** Add a runtime to the sketch
+
+    @param runtime  the runtime, in milliseconds
+   */
+  void add(double runtime);
+
+  /** Add the runtimes of another sketch to this one
+
+    @param other  the other sketch
+   */
+  void merge(const KiwibesRuntimeSketch &other);
+
+  /** Return the runtime at the given quantile, 0 if the sketch is empty
+
+    @param q  the quantile, in the range [0,1]
+   */
+  double quantile(double q) const;
+
+  /** Return the number of runtimes in the sketch
+   */
+  uint64_t count(void) const;
+
+  /** Return the number of runtimes too short to be placed in a bin
+   */
+  uint64_t zeros(void) const;
+
+  /** Return the bins of the sketch, the count of each by its index
+   */
+  const std::map<int32_t,uint64_t> &bins(void) const;
+
+  /** Add runtimes straight into the sketch, as when restoring it
+
+    @param zeros  number of runtimes too short to be placed in a bin
+    @param bins   the count of runtimes of each bin, by its index
+   */
+  void restore(uint64_t zeros, const std::map<int32_t,uint64_t> &bins);
+
+  /** Return the JSON representation of the sketch
+   */
+  nlohmann::json to_json(void) const;
+
+  /** Set the sketch from its JSON representation
+
+    @param sketch   the JSON representation
+    @return true if successfull, false if it is invalid
+   */
+  bool from_json(const nlohmann::json &sketch);
+
+private:
+  /** Merge the lowest bins, until there are no more than the maximum number of them
+   */
+  void collapse(void);
+
+private:
+  std::map<int32_t,uint64_t> sbins;   /* count of runtimes in each bin, by index */
+  uint64_t                   szeros;  /* count of runtimes too short to be placed in a bin */
+  uint64_t                   scount;  /* total count of runtimes */
+};
+
+class KiwibesRunHistory {
+
+public:
+  /** Class constructor
+   */
+  KiwibesRunHistory();
+
+  /** Add a run, replacing the oldest one if the history is full
+
+    @param run  the run
+   */
+  void add(const T_JOB_RUN &run);
+
+  /** Return the number of runs in the history
+   */
+  size_t size(void) const;
+
+  /** Return a run, the oldest one is at position 0
+
+    @param position   the position of the run, less than size()
+   */
+  const T_JOB_RUN &at(size_t position) const;
+
+  /** Return the JSON representation of the history, oldest run first
+   */
+  nlohmann::json to_json(void) const;
+
+  /** Set the history from its JSON representation
+
+    @param runs   the JSON representation
+    @return true if successfull, false if it is invalid
+   */
+  bool from_json(const nlohmann::json &runs);
+
+private:
+  std::vector<T_JOB_RUN> hruns;   /* the runs, only grows until it is full */
+  size_t                 hnext;   /* position of the next run, once the history is full */
+};
+
+class KiwibesRunStatistics {
+
+public:
+  /** Class constructor
+   */
+  KiwibesRunStatistics();
+
+  /** Add a run to the statistics
+
+    @param run  the run
+   */
+  void add(const T_JOB_RUN &run);
+
+  /** Remove all the runs from the statistics
+   */
+  void clear(void);
+
+  /** Return the number of runs
+   */
+  uint64_t runs(void) const;
+
+  /** Return the number of runs that exited with an error, or were killed
+   */
+  uint64_t failures(void) const;
+
+  /** Return the mean runtime of the runs, in milliseconds, 0 if there are none
+   */
+  double mean_runtime(void) const;
+
+  /** Return the CPU time of the runs, user and kernel mode, in microseconds
+   */
+  int64_t cpu_time(void) const;
+
+  /** Return the number of runs that ended in the window before an instant
+
+    @param now  the instant, in milliseconds since the epoch
+   */
+  uint64_t recent_runs(int64_t now) const;
+
+  /** Return the sketch of the runtimes
+   */
+  const KiwibesRuntimeSketch &sketch(void) const;
+
+  /** Return the JSON representation of the statistics
+
+    @param now  the current instant, in milliseconds since the epoch
+   */
+  nlohmann::json to_json(int64_t now) const;
+
+private:
+  KiwibesRuntimeSketch ssketch;                        /* quantiles of the runtimes, in milliseconds */
+  uint64_t             sruns;                          /* number of runs */
+  uint64_t             sfailures;                      /* number of runs that failed */
+  double               stotal;                         /* sum of the runtimes, in milliseconds */
+  int64_t              scpu;                           /* sum of the CPU time of the runs, in microseconds */
+  uint64_t             shistogram[RUN_STATS_BUCKETS];  /* number of runs in each bucket of runtimes */
+  int64_t              sseconds[RUN_STATS_WINDOW];     /* second since the epoch counted in each slot of the window */
+  uint64_t             sended[RUN_STATS_WINDOW];       /* number of runs that ended in that second */
+};
+
+#endif
@@ -0,0 +1,354 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_job_output.h"
+
+#include "NanoLog/NanoLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/stat.h>
+#endif
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Maximum number of bytes read from a pipe each time it is drained, so that
+    a chatty job does not hold up the others
+ */
+#define OUTPUT_DRAIN_CHUNK  (65536)
+
+/*--------------- Class Implemementation --------------------------------------*/
+KiwibesJobOutput::KiwibesJobOutput(size_t ring_size, size_t max_runs)
+{
+  oring   = ring_size;
+  oruns   = max_runs;
+  oclosed = false;
+}
+
+KiwibesJobOutput::~KiwibesJobOutput()
+{
+  close_all();
+}
+
+void KiwibesJobOutput::set_spill_folder(const std::string &folder)
+{
+  std::lock_guard<std::mutex> lock(olock);
+
+#if defined(__linux__)
+  if((false == folder.empty()) && (0 != mkdir(folder.c_str(),0755)) && (EEXIST != errno))
+  {
+    LOG_CRIT << "Failed to create the jobs output folder " << folder << "(" << errno << "): " << strerror(errno);
+  }
+#endif
+
+  ofolder = folder;
+}
+
+uint64_t KiwibesJobOutput::capture(const std::string &name, int fd)
+{
+  std::lock_guard<std::mutex> lock(olock);
+
+  T_OUTPUT_JOB     &job = ojobs[name];
+  T_OUTPUT_CAPTURE capture;
+  T_OUTPUT_RUN     run;
+
+  /* the oldest run is forgotten, preferably one which already finished */
+  if(oruns <= job.runs.size())
+  {
+    std::deque<T_OUTPUT_RUN>::iterator oldest = job.runs.begin();
+
+    while((job.runs.end() != oldest) && (false == oldest->finished))
+    {
+      oldest++;
+    }
+    job.runs.erase((job.runs.end() != oldest) ? oldest : job.runs.begin());
+  }
+
+  run.id       = ++job.next;
+  run.written  = 0;
+  run.finished = false;
+  job.runs.push_back(run);
+
+  capture.name   = name;
+  capture.run    = run.id;
+  capture.spill  = -1;
+  capture.tee[0] = -1;
+  capture.tee[1] = -1;
+
+#if defined(__linux__)
+  if(false == ofolder.empty())
+  {
+    int64_t     start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string fname = ofolder + name + "." + std::to_string(start) + "." + std::to_string(run.id) + ".log";
+
+    capture.spill = open(fname.c_str(),O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,0644);
+
+    if((0 > capture.spill) || (0 != pipe2(capture.tee,O_CLOEXEC | O_NONBLOCK)))
+    {
+      LOG_WARN << "Failed to spill the output of job '" << name << "' to " << fname << "(" << errno << "): " << strerror(errno);
+      if(0 <= capture.spill)
+      {
+        close(capture.spill);
+      }
+      capture.spill  = -1;
+      capture.tee[0] = -1;
+      capture.tee[1] = -1;
+    }
+  }
+#endif
+
+  ocaptures[fd] = capture;
+
+  return run.id;
+}
+
+bool KiwibesJobOutput::drain(int fd)
+{
+  T_OUTPUT_CAPTURE capture;
+  bool             open = false;
+
+  {
+    std::lock_guard<std::mutex> lock(olock);
+
+    std::unordered_map<int,T_OUTPUT_CAPTURE>::iterator entry = ocaptures.find(fd);
+
+    if(ocaptures.end() != entry)
+    {
+      capture = entry->second;
+      open    = true;
+    }
+  }
+
+#if defined(__linux__)
+  char    buffer[OUTPUT_DRAIN_CHUNK];
+  ssize_t count   = -1;
+  bool    spilled = false;
+
+  if((true == open) && (0 <= capture.spill))
+  {
+    /* duplicate the output without consuming it, and move the copy into the file */
+    count   = tee(fd,capture.tee[1],OUTPUT_DRAIN_CHUNK,SPLICE_F_NONBLOCK);
+    spilled = (0 <= count) || (EAGAIN == errno);
+
+    for(ssize_t moved = 0; (true == spilled) && (moved < count); )
+    {
+      ssize_t spliced = splice(capture.tee[0],NULL,capture.spill,NULL,count - moved,SPLICE_F_MOVE);
+
+      spilled = (0 < spliced);
+      moved  += spilled ? spliced : 0;
+    }
+
+    if(false == spilled)
+    {
+      /* stop spilling the run, its output is still kept in memory */
+      LOG_WARN << "Failed to spill the output of job '" << capture.name << "'(" << errno << "): " << strerror(errno);
+
+      std::lock_guard<std::mutex> lock(olock);
+
+      close(capture.spill);
+      close(capture.tee[0]);
+      close(capture.tee[1]);
+      ocaptures[fd].spill = -1;
+    }
+    else if(0 < count)
+    {
+      /* the duplicated output is then read as usual */
+      count = ::read(fd,buffer,count);
+    }
+  }
+
+  if((true == open) && (false == spilled))
+  {
+    count = ::read(fd,buffer,OUTPUT_DRAIN_CHUNK);
+  }
+
+  if(true == open)
+  {
+    std::lock_guard<std::mutex> lock(olock);
+
+    if(0 < count)
+    {
+      unsafe_append(capture.name,capture.run,buffer,count);
+    }
+    else if((0 == count) || ((EAGAIN != errno) && (EINTR != errno)))
+    {
+      /* the job, and any process which inherited the pipe, closed it */
+      unsafe_close(fd);
+      open = false;
+    }
+  }
+#endif
+
+  return open;
+}
+
+void KiwibesJobOutput::close_all(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(olock);
+
+    while(false == ocaptures.empty())
+    {
+      unsafe_close(ocaptures.begin()->first);
+    }
+    oclosed = true;
+  }
+
+  owritten.notify_all();
+}
+
+T_KIWIBES_ERROR KiwibesJobOutput::read(std::string &data, bool &finished, const std::string &name, uint64_t &run, uint64_t &offset, size_t max, unsigned int wait)
+{
+  std::unique_lock<std::mutex>          lock(olock);
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait);
+  T_OUTPUT_RUN                          *output  = unsafe_find_run(name,run);
+  bool                                  expired  = false;
+
+  data.clear();
+
+  /* the latest run is resolved once, the offset belongs to it even if a newer run starts meanwhile */
+  if(nullptr != output)
+  {
+    run = output->id;
+  }
+
+  /* wait until the run writes more, finishes or is forgotten */
+  while((nullptr != output) && (offset >= output->written) && (false == output->finished) && (false == oclosed) && (false == expired))
+  {
+    expired = (std::cv_status::timeout == owritten.wait_until(lock,deadline));
+    output  = unsafe_find_run(name,run);
+  }
+
+  if(nullptr == output)
+  {
+    return ERROR_OUTPUT_UNKNOWN;
+  }
+
+  /* the bytes older than the ring are lost */
+  uint64_t first = (output->written > oring) ? output->written - oring : 0;
+
+  offset = std::max(offset,first);
+
+  if(offset < output->written)
+  {
+    size_t count    = (size_t)std::min((uint64_t)max,output->written - offset);
+    size_t position = (size_t)(offset % oring);
+    size_t head     = std::min(count,output->ring.size() - position);
+
+    data.assign(output->ring,position,head);
+    data.append(output->ring,0,count - head);
+    offset += count;
+  }
+
+  finished = ((true == output->finished) || (true == oclosed)) && (offset >= output->written);
+
+  return ERROR_NO_ERROR;
+}
+
+/*--------------- Private Methods --------------------------------------*/
+void KiwibesJobOutput::unsafe_append(const std::string &name, uint64_t run, const char *data, size_t size)
+{
+  T_OUTPUT_RUN *output = unsafe_find_run(name,run);
+
+  /* the run may have been forgotten while it was still writing */
+  if(nullptr != output)
+  {
+    for(size_t done = 0; done < size; )
+    {
+      size_t position = (size_t)(output->written % oring);
+      size_t count    = std::min(size - done,oring - position);
+
+      /* the ring grows with the output, up to its size */
+      if(output->ring.size() < position + count)
+      {
+        output->ring.resize(position + count);
+      }
+      output->ring.replace(position,count,data + done,count);
+
+      output->written += count;
+      done            += count;
+    }
+
+    owritten.notify_all();
+  }
+}
+
+T_OUTPUT_RUN *KiwibesJobOutput::unsafe_find_run(const std::string &name, uint64_t run)
+{
+  T_OUTPUT_RUN *output = nullptr;
+
+  std::unordered_map<std::string,T_OUTPUT_JOB>::iterator job = ojobs.find(name);
+
+  if((ojobs.end() != job) && (false == job->second.runs.empty()))
+  {
+    if(0 == run)
+    {
+      output = &job->second.runs.back();
+    }
+    else
+    {
+      for(std::deque<T_OUTPUT_RUN>::iterator r = job->second.runs.begin(); (nullptr == output) && (r != job->second.runs.end()); r++)
+      {
+        output = (run == r->id) ? &(*r) : nullptr;
+      }
+    }
+  }
+
+  return output;
+}
+
+void KiwibesJobOutput::unsafe_close(int fd)
+{
+  std::unordered_map<int,T_OUTPUT_CAPTURE>::iterator capture = ocaptures.find(fd);
+
+  if(ocaptures.end() != capture)
+  {
+    T_OUTPUT_RUN *output = unsafe_find_run(capture->second.name,capture->second.run);
+
+    if(nullptr != output)
+    {
+      output->finished = true;
+    }
+
+#if defined(__linux__)
+    if(0 <= capture->second.spill)
+    {
+      close(capture->second.spill);
+      close(capture->second.tee[0]);
+      close(capture->second.tee[1]);
+    }
+    close(fd);
+#endif
+
+    ocaptures.erase(capture);
+    owritten.notify_all();
+  }
+}
@@ -0,0 +1,163 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the store of the output of the jobs. The standard
+  output and error of each run are captured through a pipe, which the
+  watcher thread of the jobs manager drains as soon as it is readable. The
+  output of each run is kept in a ring of fixed size, holding its latest
+  bytes, and only the latest runs of each job are kept, so the memory of a
+  job is bounded no matter how much it writes. The complete output of each
+  run can also be spilled to a file: the pipe is duplicated with tee(2) and
+  spliced into the file, without being copied through the server. The 
+  store is synchronized, and readers can wait for more output.
+*/
+#ifndef __KIWIBES_JOB_OUTPUT_H__
+#define __KIWIBES_JOB_OUTPUT_H__
+
+#include "kiwibes_errors.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** The output of a run of a job
+ */
+typedef struct {
+  uint64_t    id;         /* the identifier of the run, unique for the job */
+  std::string ring;       /* the latest bytes of the output, it wraps around once full */
+  uint64_t    written;    /* number of bytes written by the run */
+  bool        finished;   /* true once the output of the run was closed */
+} T_OUTPUT_RUN;
+
+/** The output of the latest runs of a job
+ */
+typedef struct {
+  uint64_t                 next;   /* identifier of the next run */
+  std::deque<T_OUTPUT_RUN> runs;   /* the latest runs, oldest first */
+} T_OUTPUT_JOB;
+
+/** A pipe whose output is captured
+ */
+typedef struct {
+  std::string name;         /* the name of the job */
+  uint64_t    run;          /* the identifier of the run */
+  int         spill;        /* file where the output is spilled, -1 if it is not */
+  int         tee[2];       /* pipe where the output is duplicated before it is spilled */
+} T_OUTPUT_CAPTURE;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesJobOutput {
+
+public:
+  /** Class constructor
+
+    @param ring_size  maximum number of bytes kept for each run
+    @param max_runs   number of runs kept for each job
+   */
+  KiwibesJobOutput(size_t ring_size, size_t max_runs);
+
+  /** Class destructor, closes the pipes still captured
+   */
+  ~KiwibesJobOutput();
+
+  /** Set the folder where the output of each run is spilled
+
+    @param folder   the folder, ending with a separator, or empty to keep the output only in memory
+   */
+  void set_spill_folder(const std::string &folder);
+
+  /** Capture the output of a new run of the job, read from the given pipe
+
+    @param name   the name of the job
+    @param fd     the read end of the pipe, non-blocking, the store closes it
+    @return the identifier of the run
+   */
+  uint64_t capture(const std::string &name, int fd);
+
+  /** Read the pending output of a captured pipe
+
+    @param fd   the read end of the pipe
+    @return true while the pipe is open, false once it was closed and its run finished
+   */
+  bool drain(int fd);
+
+  /** Close all the captured pipes, finishing their runs
+   */
+  void close_all(void);
+
+  /** Read the output of a run of the job, after waiting for it to write more
+
+    Once the run writes more than the ring holds, the oldest bytes are lost
+    and the offset skips over them.
+
+    @param data       on return, contains the output read
+    @param finished   on return, true if the run finished and all of its output was read
+    @param name       the name of the job
+    @param run        the identifier of the run, 0 for the latest. On return, contains the identifier
+    @param offset     position of the output to read. On return, contains the position after the data
+    @param max        maximum number of bytes to read
+    @param wait       maximum time to wait for more output, in milliseconds
+    @return ERROR_NO_ERROR if successfull, ERROR_OUTPUT_UNKNOWN if the run is not kept
+   */
+  T_KIWIBES_ERROR read(std::string &data, bool &finished, const std::string &name, uint64_t &run, uint64_t &offset, size_t max, unsigned int wait);
+
+private:
+  /** Add output to a run, without locking the store first
+
+    @param name   the name of the job
+    @param run    the identifier of the run
+    @param data   the output
+    @param size   the size of the output
+   */
+  void unsafe_append(const std::string &name, uint64_t run, const char *data, size_t size);
+
+  /** Return a run of the job, without locking the store first
+
+    @param name   the name of the job
+    @param run    the identifier of the run, 0 for the latest
+    @return the run, nullptr if it is not kept
+   */
+  T_OUTPUT_RUN *unsafe_find_run(const std::string &name, uint64_t run);
+
+  /** Close a captured pipe and finish its run, without locking the store first
+
+    @param fd   the read end of the pipe
+   */
+  void unsafe_close(int fd);
+
+  size_t                                          oring;      /* maximum number of bytes kept for each run */
+  size_t                                          oruns;      /* number of runs kept for each job */
+  std::string                                     ofolder;    /* folder where the output is spilled, empty if it is not */
+  bool                                            oclosed;    /* true once all the pipes were closed */
+  std::mutex                                      olock;      /* exclusive access to the store */
+  std::condition_variable                         owritten;   /* signaled when a run writes or finishes */
+  std::unordered_map<std::string,T_OUTPUT_JOB>    ojobs;      /* the output of the jobs, by name */
+  std::unordered_map<int,T_OUTPUT_CAPTURE>        ocaptures;  /* the captured pipes, by file descriptor */
+};  
+
+#endif
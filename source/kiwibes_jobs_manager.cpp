@@ -28,6 +28,8 @@
 
 #include "NanoLog/NanoLog.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <chrono>
@@ -36,94 +38,528 @@
 #include <cstdlib>
 
 #if defined(__linux__)
+  #include <sched.h>
   #include <signal.h>
   #include <wait.h>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <sys/syscall.h>
+  #include <sys/timerfd.h>
+  #include <sys/resource.h>
+  #include <fcntl.h>
+  #include <time.h>
+  #include <unistd.h>
+
+  #if !defined(SYS_pidfd_open)
+    #define SYS_pidfd_open 434
+  #endif
 #endif 
 
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Maximum time the watcher thread waits before polling for exited child 
+    processes, in milliseconds. It is used only when the kernel does not
+    support process file descriptors.
+ */
+#define WATCHER_POLL_PERIOD_MS  (250)
+
+/** Maximum number of events handled by each iteration of the watcher thread
+ */
+#define WATCHER_MAX_EVENTS      (64)
+
+/** Event data of the deadlines timer. The wake up event uses 0, and the 
+    processes never have a handle of 1, so it cannot be mistaken for them
+ */
+#define WATCHER_DEADLINE_EVENT  (1)
+
+/** Flag in the event data of the output pipes, together with their file 
+    descriptor. The processes use the lower 63 bits only, so it cannot be
+    mistaken for them
+ */
+#define WATCHER_OUTPUT_EVENT    (1ULL << 63)
+
+/** Maximum number of bytes of the output kept for each run of a job
+ */
+#define OUTPUT_RING_SIZE        (64*1024)
+
+/** Number of runs of each job whose output is kept
+ */
+#define OUTPUT_MAX_RUNS         (4)
+
+/** Time a job which exceeds its maximum runtime is given to terminate, 
+    before it is killed, in milliseconds
+ */
+#define DEADLINE_GRACE_MS       (5000)
+
+/** Number of handled start invocations which are remembered, so that their
+    callers can still poll them
+ */
+#define LAUNCHER_MAX_INVOCATIONS  (4096)
+
+/** Size of the stack of the child process of a job, until it executes the 
+    program of the job
+ */
+#define LAUNCH_STACK_SIZE       (64*1024)
+
+/** Set to true if the watcher thread must poll for exited child processes, 
+    because the kernel does not support process file descriptors or it was
+    not possible to open one for a child process
+ */
+static std::atomic<bool> watcher_polling(false);
+
+#if defined(__linux__)
+/** Arguments of the child process of a job, which shares the memory of the
+    server until it executes the program of the job
+ */
+typedef struct {
+  const char  *program;     /* path of the program of the job */
+  char *const *arguments;   /* arguments of the program, terminated by NULL */
+  int          output;      /* write end of the pipe of the output, -1 if it is not captured */
+  int          group;       /* folder of the cgroup the child must join, -1 if none */
+  sigset_t     mask;        /* signal mask of the server, restored in the child */
+  bool         joined;      /* on return, true if the child joined its cgroup */
+  int          error;       /* on return, the error which prevented executing the program, 0 if none */
+} T_LAUNCH_ARGS;
+#endif
+
 /*----------------- Private Functions Declarations -----------------------------*/
 /** Launch the job in a separate process
 
-  @param job    the job description
+  The process is created without copying the address space of the server,
+  and the arguments are prepared before creating it. Its standard output 
+  and error are both redirected to a pipe. When the job has a cgroup, the
+  process joins it before executing the program of the job, so all its 
+  children are accounted and limited.
+
+  @param name     the name of the job
+  @param job      the job description
+  @param group    the folder of the cgroup of the process, -1 if none
+  @param output   on return, the non-blocking read end of the pipe, -1 if the output is not captured
+  @param joined   on return, true if the process is in the cgroup
   @return the new process handle
  */
-static T_PROCESS_HANDLER launch_job_process(nlohmann::json &job);
+static T_PROCESS_HANDLER launch_job_process(const std::string &name, nlohmann::json &job, int group, int *output, bool *joined);
+
+#if defined(__linux__)
+/** Run the child process of a job until it executes the program of the job
+
+  It shares the memory of the server, so it only uses system calls.
+
+  @param args   the arguments of the child process, a T_LAUNCH_ARGS
+  @return the exit status of the child, if it cannot execute the program
+ */
+static int launch_job_child(void *args);
+#endif
+
+/** Watch the pipe of the output of a process, so it is drained by the watcher thread
+
+  @param poll     the epoll instance of the watcher thread
+  @param fd       the read end of the pipe
+ */
+static void watch_job_output(int poll, int fd);
+
+/** Watch the process for exit
+
+  Opens a process file descriptor for the child process and adds it to
+  the watcher epoll instance, so that the watcher thread is woken up as
+  soon as the process exits.
+
+  @param poll     the epoll instance of the watcher thread
+  @param wake     the event used to wake up the watcher thread
+  @param handle   the child process handle
+  @return the process file descriptor, -1 if the process is reaped by polling
+ */
+static int watch_job_process(int poll, int wake, T_PROCESS_HANDLER handle);
+
+/** Stop watching a process, once it has been reaped
+
+  The process file descriptor is removed from the epoll instance and closed,
+  whichever way the process was reaped. Otherwise it would keep waking up 
+  the watcher thread, and be matched to a new process with the same handle.
+
+  @param poll     the epoll instance of the watcher thread
+  @param pidfd    the process file descriptor, -1 if the process was not watched
+ */
+static void unwatch_job_process(int poll, int pidfd);
+
+/** Return the current instant of the monotonic clock, in milliseconds
+ */
+static int64_t monotonic_ms(void);
+
+/** Add the deadline of the process, if the job has a maximum runtime
+
+  The timer is only armed again if the process has the earliest deadline.
+
+  @param deadlines  deadlines of the active jobs
+  @param timer      timer armed at the earliest deadline
+  @param handle     the child process handle
+  @param job        the job description
+ */
+static void add_job_deadline(KiwibesDeadlines *deadlines, int timer, T_PROCESS_HANDLER handle, nlohmann::json &job);
+
+/** Arm the timer at the earliest deadline, or disarm it if there are none
+
+  @param deadlines  deadlines of the active jobs
+  @param timer      timer armed at the earliest deadline
+ */
+static void arm_deadline_timer(const KiwibesDeadlines *deadlines, int timer);
+
+/** Signal the processes whose deadline has expired
+
+  A process is first terminated and then, if it does not exit within the
+  grace period, killed. Must be called with the lock of the table of active 
+  jobs taken.
+
+  @param deadlines  deadlines of the active jobs
+  @param timer      timer armed at the earliest deadline
+ */
+static void expire_job_deadlines(KiwibesDeadlines *deadlines, int timer);
+
+/** Launch an instance of the job and start watching it
+
+  If the job then runs its maximum number of instances, its queued start
+  requests are blocked. Must be called with the lock of the table of active 
+  jobs taken.
+
+  @param database     pointer to the database object
+  @param active_jobs  table of active jobs
+  @param deadlines    deadlines of the active jobs
+  @param admission    start requests waiting for the active jobs to exit
+  @param output       output of the jobs
+  @param cgroups      cgroups of the running jobs
+  @param poll         the epoll instance of the watcher thread
+  @param wake         the event used to wake up the watcher thread
+  @param timer        timer armed at the earliest deadline
+  @param name         the name of the job
+  @param job          the job description
+  @return ERROR_NO_ERROR if successfull, error code otherwise
+ */
+static T_KIWIBES_ERROR start_job_instance(KiwibesDatabase *database,
+                                          KiwibesProcessTable *active_jobs,
+                                          KiwibesDeadlines *deadlines,
+                                          KiwibesAdmissionQueue *admission,
+                                          KiwibesJobOutput *output,
+                                          KiwibesCgroups *cgroups,
+                                          int poll,
+                                          int wake,
+                                          int timer,
+                                          const std::string &name,
+                                          nlohmann::json &job);
+
+/** Start the queued requests, for as long as jobs can be admitted
+
+  Must be called with the lock of the table of active jobs taken.
+
+  @param database     pointer to the database object
+  @param active_jobs  table of active jobs
+  @param deadlines    deadlines of the active jobs
+  @param admission    start requests waiting for the active jobs to exit
+  @param output       output of the jobs
+  @param cgroups      cgroups of the running jobs
+  @param poll         the epoll instance of the watcher thread
+  @param wake         the event used to wake up the watcher thread
+  @param timer        timer armed at the earliest deadline
+ */
+static void admit_queued_jobs(KiwibesDatabase *database,
+                              KiwibesProcessTable *active_jobs,
+                              KiwibesDeadlines *deadlines,
+                              KiwibesAdmissionQueue *admission,
+                              KiwibesJobOutput *output,
+                              KiwibesCgroups *cgroups,
+                              int poll,
+                              int wake,
+                              int timer);
+
+/** Handle the exit of a child process
+
+  Updates the database and starts the queued requests which can now be
+  admitted. Must be called with the lock of the table of active jobs taken.
+
+  @param database     pointer to the database object
+  @param active_jobs  table of active jobs
+  @param deadlines    deadlines of the active jobs
+  @param admission    start requests waiting for the active jobs to exit
+  @param output       output of the jobs
+  @param cgroups      cgroups of the running jobs
+  @param poll         the epoll instance of the watcher thread
+  @param wake         the event used to wake up the watcher thread
+  @param timer        timer armed at the earliest deadline
+  @param pid          the handle of the process which exited
+  @param wstatus      the status of the process, as returned by wait4
+  @param usage        the resources used by the process, as returned by wait4
+ */
+static void job_process_exited(KiwibesDatabase *database,
+                               KiwibesProcessTable *active_jobs,
+                               KiwibesDeadlines *deadlines,
+                               KiwibesAdmissionQueue *admission,
+                               KiwibesJobOutput *output,
+                               KiwibesCgroups *cgroups,
+                               int poll,
+                               int wake,
+                               int timer,
+                               T_PROCESS_HANDLER pid,
+                               int wstatus,
+                               const struct rusage *usage);
 
 /** Watcher Thread 
 
-  This function waits for the processes in the map of active jobs to finish.
+  This function waits for the processes in the table of active jobs to finish.
+  It sleeps on the epoll instance until either a child process exits, one
+  of the deadlines expires, a job writes to its output or the thread is 
+  asked to exit.
 
   @param database     pointer to the database object
-  @param active_jobs  map of active jobs
-  @param jobs_lock    access lock for the map of active jobs
+  @param active_jobs  table of active jobs
+  @param deadlines    deadlines of the active jobs
+  @param admission    start requests waiting for the active jobs to exit
+  @param output       output of the jobs
+  @param cgroups      cgroups of the running jobs
+  @param jobs_lock    access lock for the table of active jobs
   @param exitFlag     set to true when the thread should exit 
+  @param poll         the epoll instance to wait on
+  @param wake         the event used to wake up the thread
+  @param timer        timer armed at the earliest deadline
  */
 static void watcher_thread(KiwibesDatabase *database,
-                           std::map<std::string, T_PROCESS_HANDLER> *active_jobs,
+                           KiwibesProcessTable *active_jobs,
+                           KiwibesDeadlines *deadlines,
+                           KiwibesAdmissionQueue *admission,
+                           KiwibesJobOutput *output,
+                           KiwibesCgroups *cgroups,
                            std::mutex *jobs_lock,
-                           bool *exitFlag);
+                           bool *exitFlag,
+                           int poll,
+                           int wake,
+                           int timer);
+
+/** Launcher Thread 
+
+  This function starts the jobs whose requests were handed over to it, in
+  the order they were received, and updates their invocations. It sleeps
+  on the wake up event until there are requests or it is asked to exit.
+
+  @param manager      the jobs manager
+  @param launches     start requests handed over to the thread
+  @param invocations  start invocations of the jobs
+  @param exitFlag     set to true when the thread should exit 
+  @param wake         the event used to wake up the thread
+ */
+static void launcher_thread(KiwibesJobsManager *manager,
+                            KiwibesLaunchQueue *launches,
+                            KiwibesInvocations *invocations,
+                            bool *exitFlag,
+                            int wake);
 
 /*--------------- Class Implemementation --------------------------------------*/  
-KiwibesJobsManager::KiwibesJobsManager(KiwibesDatabase *database)
+KiwibesJobsManager::KiwibesJobsManager(KiwibesDatabase *database) : deadlines(DEADLINE_GRACE_MS), output(OUTPUT_RING_SIZE,OUTPUT_MAX_RUNS), invocations(LAUNCHER_MAX_INVOCATIONS)
 {
   this->database = database;
   watcherExit    = false;
+  launcherExit   = false;
+
+  /* the watcher thread sleeps on the epoll instance, the event file 
+     descriptor is used to wake it up when it should exit
+   */
+  watcherPoll = epoll_create1(EPOLL_CLOEXEC);
+  watcherWake = eventfd(0,EFD_CLOEXEC | EFD_NONBLOCK);
+
+  struct epoll_event wake;
+  wake.events   = EPOLLIN;
+  wake.data.u64 = 0;
+  epoll_ctl(watcherPoll,EPOLL_CTL_ADD,watcherWake,&wake);
+
+  /* the timer is armed at the earliest deadline of the running jobs, so the
+     watcher thread stops them exactly when they exceed their maximum runtime
+   */
+  watcherTimer = timerfd_create(CLOCK_MONOTONIC,TFD_CLOEXEC | TFD_NONBLOCK);
+
+  struct epoll_event timer;
+  timer.events   = EPOLLIN;
+  timer.data.u64 = WATCHER_DEADLINE_EVENT;
+  epoll_ctl(watcherPoll,EPOLL_CTL_ADD,watcherTimer,&timer);
+
+  /* verify that the kernel supports process file descriptors, otherwise
+     fallback to polling for exited child processes
+   */
+  int pidfd = syscall(SYS_pidfd_open,getpid(),0);
+
+  if(0 > pidfd)
+  {
+    LOG_WARN << "Process file descriptors not available(" << errno << "): " << strerror(errno);
+    LOG_WARN << "Polling for exited jobs every " << WATCHER_POLL_PERIOD_MS << " ms";
+    watcher_polling = true;
+  }
+  else
+  {
+    watcher_polling = false;
+    close(pidfd);
+  }
+
+  /* each job runs in its own cgroup, which accounts for the resources it uses */
+  if(false == cgroups.enable(""))
+  {
+    LOG_WARN << "cgroup v2 not available, the resources of the jobs are taken from wait4";
+  }
 
   /* start the watcher thread */
-  watcher.reset(new std::thread(watcher_thread,database,&active_jobs,&jobs_lock,&watcherExit));
+  watcher.reset(new std::thread(watcher_thread,database,&active_jobs,&deadlines,&admission,&output,&cgroups,&jobs_lock,&watcherExit,watcherPoll,watcherWake,watcherTimer));
+
+  /* start the launcher thread, it blocks on its event until there are requests */
+  launcherWake = eventfd(0,EFD_CLOEXEC);
+  launcher.reset(new std::thread(launcher_thread,this,&launches,&invocations,&launcherExit,launcherWake));
 }
 
 KiwibesJobsManager::~KiwibesJobsManager()
 {
+  /* stop the launcher thread first, so that no more jobs are started */
+  launcherExit = true;
+  LOG_INFO << "waiting for the jobs launcher thread to finish"; 
+
+  uint64_t launch = 1;
+  if(sizeof(launch) != write(launcherWake,&launch,sizeof(launch)))
+  {
+    LOG_CRIT << "Failed to wake up the launcher thread(" << errno << "): "<< strerror(errno);
+  }
+
+  launcher->join();
+  LOG_INFO << "the jobs launcher thread has finished";
+  close(launcherWake);
+
   /* stop all jobs and also the watcher thread */
   stop_all_jobs();
 
   watcherExit = true;
   LOG_INFO << "waiting for the jobs watcher thread to finish"; 
+
+  uint64_t wake = 1;
+  if(sizeof(wake) != write(watcherWake,&wake,sizeof(wake)))
+  {
+    LOG_CRIT << "Failed to wake up the watcher thread(" << errno << "): "<< strerror(errno);
+  }
+
   watcher->join();
   LOG_INFO << "the jobs watcher thread has finished";
+
+#if defined(__linux__)
+  /* the jobs the watcher thread did not reap are reaped here, since the cgroup
+     of a job cannot be removed while its process is a zombie. Those admitted
+     from the queue after all jobs were killed are killed as well
+   */
+  while(0 < active_jobs.size())
+  {
+    std::string       name;
+    T_PROCESS_HANDLER handle = active_jobs.running().begin()->second;
+    T_JOB_RUN         run;
+
+    kill(handle,SIGKILL);
+    waitpid(handle,NULL,0);
+    cgroups.collect(handle,run);
+    unwatch_job_process(watcherPoll,active_jobs.get_watch(handle));
+    active_jobs.remove(name,handle);
+  }
+#endif
+
+  /* the output of the jobs still running is no longer drained */
+  output.close_all();
+
+  close(watcherTimer);
+  close(watcherWake);
+  close(watcherPoll);
 }
 
-T_KIWIBES_ERROR KiwibesJobsManager::start_job(const std::string &name)
+void KiwibesJobsManager::set_max_running(size_t max_running)
 {
   std::lock_guard<std::mutex> lock(jobs_lock);
 
+  admission.set_capacity(max_running);
+
+  /* a higher limit may admit the queued requests right away */
+  admit_queued_jobs(database,&active_jobs,&deadlines,&admission,&output,&cgroups,watcherPoll,watcherWake,watcherTimer);
+}
+
+T_KIWIBES_ERROR KiwibesJobsManager::start_job(const std::string &name)
+{
+  bool queued = false;
+
+  return start_job(name,queued);
+}
+
+T_KIWIBES_ERROR KiwibesJobsManager::start_job(const std::string &name, bool &queued)
+{
   T_KIWIBES_ERROR error = ERROR_NO_ERROR;
-  
-  if(1 == active_jobs.count(name))
+  nlohmann::json  job;
+
+  /* the description is copied before taking the lock, the table of active jobs
+     is also needed by the watcher thread
+   */
+  error  = database->get_job_description(job,name);
+  queued = false;
+
+  std::lock_guard<std::mutex> lock(jobs_lock);
+
+  if(ERROR_NO_ERROR != error)
   {
-    LOG_INFO << "Job '" << name << "' is already running, queueing it";
-    error = database->job_incr_start_requests(name);
+    LOG_WARN << "No job with name '" << name << "' was found in the database";  
+  }
+  else if((active_jobs.instances(name) < job["max-parallel"].get<unsigned int>()) && 
+          (true == admission.admissible(active_jobs.size())) &&
+          (0 == admission.count(name)))
+  {
+    /* the job does not overtake its own queued requests */
+    error = start_job_instance(database,&active_jobs,&deadlines,&admission,&output,&cgroups,watcherPoll,watcherWake,watcherTimer,name,job);
   }
   else
   {
-    nlohmann::json job;
-    error = database->get_job_description(job,name);
+    LOG_INFO << "Job '" << name << "' cannot start now, queueing it";
+    admission.push(name,job["priority"].get<signed int>());
+    error  = database->job_incr_start_requests(name);
+    queued = true;
+  }
 
-    if(ERROR_NO_ERROR != error)
-    {
-      LOG_WARN << "No job with name '" << name << "' was found in the database";  
-    }
-    else
-    {
-      T_PROCESS_HANDLER handle = launch_job_process(job);
+  return error;
+}
 
-      if(INVALID_PROCESS_HANDLE != handle)
-      {
-        active_jobs.insert(std::pair<std::string,T_PROCESS_HANDLER>(name,handle));
-        database->job_started(name);
-        LOG_INFO << "Started job '" << name << "'";
-      }    
-      else
-      {
-        LOG_CRIT << "Failed to launch process for job '" << name << "'";  
-        error = ERROR_PROCESS_LAUNCH_FAILED;
-      }
+T_KIWIBES_ERROR KiwibesJobsManager::start_job_async(const std::string &name, uint64_t &id)
+{
+  nlohmann::json  job;
+  T_KIWIBES_ERROR error = database->get_job_description(job,name);
+
+  id = 0;
+
+  /* the job may still be deleted before the launcher thread starts it, then the invocation fails */
+  if(ERROR_NO_ERROR != error)
+  {
+    LOG_WARN << "No job with name '" << name << "' was found in the database";
+  }
+  else
+  {
+    id = invocations.create(name);
+    launches.push(id,name);
+
+    uint64_t launch = 1;
+    if(sizeof(launch) != write(launcherWake,&launch,sizeof(launch)))
+    {
+      LOG_CRIT << "Failed to wake up the launcher thread(" << errno << "): "<< strerror(errno);
     }
   }
 
   return error;
 }
 
+T_KIWIBES_ERROR KiwibesJobsManager::get_invocation(T_INVOCATION &invocation, uint64_t id, unsigned int wait)
+{
+  return invocations.get(invocation,id,wait);
+}
+
+void KiwibesJobsManager::set_output_folder(const std::string &folder)
+{
+  output.set_spill_folder(folder);
+}
+
+T_KIWIBES_ERROR KiwibesJobsManager::read_job_output(std::string &data, bool &finished, const std::string &name, uint64_t &run, uint64_t &offset, size_t max, unsigned int wait)
+{
+  return output.read(data,finished,name,run,offset,max,wait);
+}
+
 T_KIWIBES_ERROR KiwibesJobsManager::stop_job(const std::string &name)
 {
   std::lock_guard<std::mutex> lock(jobs_lock);
@@ -137,20 +573,21 @@ T_KIWIBES_ERROR KiwibesJobsManager::stop_job(const std::string &name)
   {
       LOG_WARN << "No job with name '" << name << "' was found in the database";  
   }
+  else if(false == active_jobs.is_running(name))
+  {
+    LOG_WARN << "Job '" << name << "' is not running, not stopping it";
+    error = ERROR_JOB_IS_NOT_RUNNING;
+  }
   else
   {
-    std::map<std::string,T_PROCESS_HANDLER>::iterator iter = active_jobs.find(name);
+    typedef std::multimap<std::string,T_PROCESS_HANDLER>::const_iterator T_ITER;
+    std::pair<T_ITER,T_ITER> instances = active_jobs.running().equal_range(name);
 
-    if(active_jobs.end() == iter)
-    {
-      LOG_WARN << "Job '" << name << "' is not running, not stopping it";
-      error = ERROR_JOB_IS_NOT_RUNNING;
-    }
-    else
+    for(T_ITER iter = instances.first; iter != instances.second; iter++)
     {
 #if defined(__linux__)
       /* kill the child process and let the watcher thread to handle its exit */
-      LOG_INFO << "Killing process for job '" << name << "'";
+      LOG_INFO << "Killing process " << (*iter).second << " for job '" << name << "'";
       kill((*iter).second,SIGKILL);
 #endif    
     }
@@ -163,7 +600,7 @@ void KiwibesJobsManager::stop_all_jobs(void)
 {
   std::lock_guard<std::mutex> lock(jobs_lock);
 
-  for(std::map<std::string,T_PROCESS_HANDLER>::iterator iter = active_jobs.begin(); iter != active_jobs.end(); iter++)
+  for(std::multimap<std::string,T_PROCESS_HANDLER>::const_iterator iter = active_jobs.running().begin(); iter != active_jobs.running().end(); iter++)
   {
 #if defined(__linux__)
     /* kill the child process and let the watcher thread to handle its exit */
@@ -173,105 +610,534 @@ void KiwibesJobsManager::stop_all_jobs(void)
   }
 }
 
+T_KIWIBES_ERROR KiwibesJobsManager::clear_start_requests(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(jobs_lock);
+
+  size_t removed = admission.clear(name);
+
+  LOG_INFO << "Removed " << removed << " queued start requests of job '" << name << "'";
+
+  return database->job_clear_start_requests(name);
+}
+
 /*------------------ Private Functions Definitions ----------------------*/
-static T_PROCESS_HANDLER launch_job_process(nlohmann::json &job)
+static T_PROCESS_HANDLER launch_job_process(const std::string &name, nlohmann::json &job, int group, int *output, bool *joined)
 {
   T_PROCESS_HANDLER handle = INVALID_PROCESS_HANDLE;
 
+  *output = -1;
+  *joined = false;
+
 #if defined(__linux__)
-  handle = fork();
-  
-  if(0 == handle)
+  /* prepare the command line before creating the process, since the child
+     shares the memory of the server until it executes the program
+   */
+  std::vector<std::string> program(job["program"].get<std::vector<std::string> >());
+  std::vector<char *>      arguments;
+
+  for(unsigned int a = 0; a < program.size(); a++)
   {
-    /* child process, start the process with the given command line */
-    std::vector<std::string> program(job["program"].get<std::vector<std::string> >());
+    arguments.push_back((char *)program[a].c_str());
+  }
+  arguments.push_back(NULL);
+
+  if(0 == program.size())
+  {
+    LOG_CRIT << "Job '" << name << "' has an empty program";
+  }
+  else
+  {
+    /* the child shares the memory of the server, like with vfork, so neither
+       the page tables nor the memory of the server are copied into it
+     */
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    /* the output of the job goes to a pipe instead of the console of the server. Both
+       ends are closed on exec, the child only keeps its copies of the write end
+     */
+    std::vector<char> stack(LAUNCH_STACK_SIZE);
+    T_LAUNCH_ARGS     args;
+    int               pipefd[2] = { -1, -1 };
+    sigset_t          all;
 
-    char **arguments = (char **)malloc(sizeof(char *)*(1 + program.size()));
-    for(unsigned int a = 0; a < program.size(); a++)
+    if(0 != pipe2(pipefd,O_CLOEXEC))
     {
-      arguments[a] = (char *)program[a].c_str();
+      LOG_WARN << "Failed to capture the output of job '" << name << "'(" << errno << "): "<< strerror(errno);
+      pipefd[0] = -1;
+      pipefd[1] = -1;
     }
-    arguments[program.size()] = NULL;
 
-    execv(program[0].c_str(),(char *const *)arguments);
+    args.program   = program[0].c_str();
+    args.arguments = arguments.data();
+    args.output    = pipefd[1];
+    args.group     = group;
+    args.joined    = false;
+    args.error     = 0;
 
-    /* should not reach here */
-    return INVALID_PROCESS_HANDLE;
-  }
-  else if(0 > handle)    
-  {
-    /* an error occurred */
-    LOG_CRIT << "Failed to fork new process(" << errno << "): "<< strerror(errno);
+    /* no signal handler of the server may run in the child, it restores the mask before exec */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK,&all,&args.mask);
+
+    /* the child joins its cgroup itself, before executing the program */
+    long result = clone(launch_job_child,stack.data() + stack.size(),CLONE_VM | CLONE_VFORK | SIGCHLD,&args);
+
+    result = (0 < result) ? result : -errno;
+
+    pthread_sigmask(SIG_SETMASK,&args.mask,NULL);
+
+    std::chrono::microseconds latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    if(0 <= pipefd[1])
+    {
+      close(pipefd[1]);
+    }
+
+    /* the child exited without executing the program, it is reaped here under the lock of the jobs */
+    if((0 < result) && (0 != args.error))
+    {
+      waitpid(result,NULL,0);
+      result = -args.error;
+    }
+
+    if(0 >= result)
+    {
+      LOG_CRIT << "Failed to spawn new process(" << -result << "): "<< strerror(-result);
+
+      if(0 <= pipefd[0])
+      {
+        close(pipefd[0]);
+      }
+    }
+    else
+    {
+      LOG_INFO << "Launched job '" << name << "' in " << latency.count() << " us";
+
+      handle  = result;
+      *joined = args.joined;
+
+      if(0 <= pipefd[0])
+      {
+        fcntl(pipefd[0],F_SETFL,O_NONBLOCK);
+        *output = pipefd[0];
+      }
+    }
   }
 #endif 
 
   return handle; 
 }
 
-static void watcher_thread(KiwibesDatabase *database, std::map<std::string, T_PROCESS_HANDLER> *active_jobs, std::mutex *jobs_lock, bool *exitFlag)
+#if defined(__linux__)
+static int launch_job_child(void *args)
 {
-  while(false == *exitFlag)
+  T_LAUNCH_ARGS   *launch = (T_LAUNCH_ARGS *)args;
+  struct sigaction action;
+
+  if(0 <= launch->group)
   {
-    /* wait a little before attempting to get the lock */
-    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    launch->joined = KiwibesCgroups::join(launch->group);
+  }
+
+  /* the handlers of the server are replaced by the default ones, the ignored signals stay ignored */
+  for(int s = 1; s < NSIG; s++)
+  {
+    if((0 == sigaction(s,NULL,&action)) && (SIG_IGN != action.sa_handler) && (SIG_DFL != action.sa_handler))
+    {
+      action.sa_handler = SIG_DFL;
+      action.sa_flags   = 0;
+      sigaction(s,&action,NULL);
+    }
+  }
+  sigprocmask(SIG_SETMASK,&launch->mask,NULL);
 
-    /* check if any of the processes has exited, an if so update the database
-       information and remove it from the map of active jobs 
+  if((0 > launch->output) || ((0 <= dup2(launch->output,STDOUT_FILENO)) && (0 <= dup2(launch->output,STDERR_FILENO))))
+  {
+    execve(launch->program,launch->arguments,environ);
+  }
+
+  /* the server resumes only after the child exited, so it sees the error */
+  launch->error = errno;
+  _exit(127);
+}
+#endif
+
+static int watch_job_process(int poll, int wake, T_PROCESS_HANDLER handle)
+{
+  int pidfd = -1;
+
+#if defined(__linux__)
+  pidfd = syscall(SYS_pidfd_open,handle,0);
+
+  if(0 > pidfd)
+  {
+    /* the process cannot be watched, e.g. there are no more file descriptors
+       available. Switch the watcher thread to polling and wake it up, so the 
+       process is reaped when it exits
+     */
+    if(false == watcher_polling.exchange(true))
+    {
+      LOG_WARN << "Failed to open the process " << handle << "(" << errno << "): "<< strerror(errno);
+      LOG_WARN << "Polling for exited jobs every " << WATCHER_POLL_PERIOD_MS << " ms";
+
+      uint64_t event = 1;
+      if(sizeof(event) != write(wake,&event,sizeof(event)))
+      {
+        LOG_CRIT << "Failed to wake up the watcher thread(" << errno << "): "<< strerror(errno);
+      }
+    }
+  }
+  else
+  {
+    /* the event data holds both the process handle and its file descriptor,
+       so that the watcher thread can reap the process and then close it
      */
-    jobs_lock->lock();
+    struct epoll_event event;
+    event.events   = EPOLLIN;
+    event.data.u64 = (((uint64_t)pidfd) << 32) | (uint32_t)handle;
+
+    if(0 != epoll_ctl(poll,EPOLL_CTL_ADD,pidfd,&event))
+    {
+      LOG_CRIT << "Failed to watch process " << handle << "(" << errno << "): "<< strerror(errno);
+      close(pidfd);
+      pidfd = -1;
+    }
+  }
+#endif
+
+  return pidfd;
+}
 
+static void unwatch_job_process(int poll, int pidfd)
+{
 #if defined(__linux__)
-    int               wstatus = 0;
-    T_PROCESS_HANDLER pid     = waitpid(-1,&wstatus,WNOHANG);
+  if(0 <= pidfd)
+  {
+    if(0 != epoll_ctl(poll,EPOLL_CTL_DEL,pidfd,NULL))
+    {
+      LOG_WARN << "Failed to stop watching the process file descriptor " << pidfd << "(" << errno << "): "<< strerror(errno);
+    }
+    close(pidfd);
+  }
+#endif
+}
+
+static void watch_job_output(int poll, int fd)
+{
+#if defined(__linux__)
+  struct epoll_event event;
+  event.events   = EPOLLIN;
+  event.data.u64 = WATCHER_OUTPUT_EVENT | (uint32_t)fd;
+
+  if(0 != epoll_ctl(poll,EPOLL_CTL_ADD,fd,&event))
+  {
+    LOG_CRIT << "Failed to watch the output pipe " << fd << "(" << errno << "): "<< strerror(errno);
+  }
+#endif
+}
+
+static int64_t monotonic_ms(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC,&now);
+
+  return 1000*(int64_t)now.tv_sec + now.tv_nsec/1000000;
+}
+
+static void add_job_deadline(KiwibesDeadlines *deadlines, int timer, T_PROCESS_HANDLER handle, nlohmann::json &job)
+{
+  int64_t max_runtime = job["max-runtime"].get<int64_t>();
 
-    while(0 < pid)
+  /* a maximum runtime of zero means the job can run for as long as it needs */
+  if(0 < max_runtime)
+  {
+    int64_t deadline = monotonic_ms() + 1000*max_runtime;
+
+    if((true == deadlines->insert(handle,deadline)) && (deadline == deadlines->next()))
     {
-      if(WIFEXITED(wstatus) || WIFSIGNALED(wstatus))
+      arm_deadline_timer(deadlines,timer);
+    }
+  }
+}
+
+static void arm_deadline_timer(const KiwibesDeadlines *deadlines, int timer)
+{
+#if defined(__linux__)
+  struct itimerspec expiry;
+  int64_t           next = deadlines->next();
+
+  /* a zero expiry disarms the timer, and one already past fires it immediately */
+  memset(&expiry,0,sizeof(expiry));
+  if(0 <= next)
+  {
+    expiry.it_value.tv_sec  = next/1000;
+    expiry.it_value.tv_nsec = (next % 1000)*1000000;
+  }
+
+  if(0 != timerfd_settime(timer,TFD_TIMER_ABSTIME,&expiry,NULL))
+  {
+    LOG_CRIT << "Failed to arm the deadlines timer(" << errno << "): "<< strerror(errno);
+  }
+#endif
+}
+
+static void expire_job_deadlines(KiwibesDeadlines *deadlines, int timer)
+{
+#if defined(__linux__)
+  /* clear the timer, it may also have been armed for a process that has since exited */
+  uint64_t expirations;
+  if((sizeof(expirations) != read(timer,&expirations,sizeof(expirations))) && (EAGAIN != errno))
+  {
+    LOG_WARN << "Failed to clear the deadlines timer";
+  }
+
+  int64_t           now    = monotonic_ms();
+  T_PROCESS_HANDLER handle = INVALID_PROCESS_HANDLE;
+  int               signal = deadlines->expire(now,handle);
+
+  while(0 != signal)
+  {
+    /* the process is only reaped by this thread, so the handle was not reused */
+    LOG_WARN << "Process " << handle << " exceeded the maximum runtime, sending signal " << signal;
+    kill(handle,signal);
+
+    signal = deadlines->expire(now,handle);
+  }
+
+  arm_deadline_timer(deadlines,timer);
+#endif
+}
+
+static T_KIWIBES_ERROR start_job_instance(KiwibesDatabase *database, KiwibesProcessTable *active_jobs, KiwibesDeadlines *deadlines, KiwibesAdmissionQueue *admission, KiwibesJobOutput *output, KiwibesCgroups *cgroups, int poll, int wake, int timer, const std::string &name, nlohmann::json &job)
+{
+  T_KIWIBES_ERROR   error  = ERROR_NO_ERROR;
+  int               pipefd = -1;
+  int               group  = cgroups->create(name,job["max-memory"].get<unsigned int>(),job["max-cpu"].get<unsigned int>());
+  bool              joined = false;
+  T_PROCESS_HANDLER handle = launch_job_process(name,job,group,&pipefd,&joined);
+
+  /* the process is only reaped under the same lock, so it is still there to be attached */
+  cgroups->attach((true == joined) ? handle : INVALID_PROCESS_HANDLE,group);
+
+  if(INVALID_PROCESS_HANDLE != handle)
+  {
+    active_jobs->insert(name,handle);
+    active_jobs->set_watch(handle,watch_job_process(poll,wake,handle));
+
+    if(0 <= pipefd)
+    {
+      output->capture(name,pipefd);
+      watch_job_output(poll,pipefd);
+    }
+
+    add_job_deadline(deadlines,timer,handle,job);
+    database->job_started(name);
+    LOG_INFO << "Started job '" << name << "'";
+
+    /* the queued requests of the job wait for one of its instances to exit */
+    if(job["max-parallel"].get<unsigned int>() <= active_jobs->instances(name))
+    {
+      admission->block(name);
+    }
+  }    
+  else
+  {
+    LOG_CRIT << "Failed to launch process for job '" << name << "'";  
+    error = ERROR_PROCESS_LAUNCH_FAILED;
+  }
+
+  return error;
+}
+
+static void admit_queued_jobs(KiwibesDatabase *database, KiwibesProcessTable *active_jobs, KiwibesDeadlines *deadlines, KiwibesAdmissionQueue *admission, KiwibesJobOutput *output, KiwibesCgroups *cgroups, int poll, int wake, int timer)
+{
+  std::string name;
+
+  while((true == admission->admissible(active_jobs->size())) && (true == admission->pop(name)))
+  {
+    nlohmann::json job;
+
+    /* the job may have been deleted while its request was queued */
+    if(ERROR_NO_ERROR == database->get_job_description(job,name))
+    {
+      LOG_INFO << "Job '" << name << "' has pending start requests, starting it again";
+      database->job_decr_start_requests(name);
+      start_job_instance(database,active_jobs,deadlines,admission,output,cgroups,poll,wake,timer,name,job);
+    }
+  }
+}
+
+static void job_process_exited(KiwibesDatabase *database, KiwibesProcessTable *active_jobs, KiwibesDeadlines *deadlines, KiwibesAdmissionQueue *admission, KiwibesJobOutput *output, KiwibesCgroups *cgroups, int poll, int wake, int timer, T_PROCESS_HANDLER pid, int wstatus, const struct rusage *usage)
+{
+  std::string name;
+  bool        timed_out = deadlines->remove(pid);
+  T_JOB_RUN   run;
+
+  /* each instance of the job is measured from the instant its own process started */
+  run.start    = active_jobs->get_start(pid);
+  run.duration = std::max((int64_t)0,std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - run.start);
+
+  /* the usage of the process, and of the children it waited for, unless its cgroup accounts for them.
+     Its maximum resident set is the one of the server, whose memory it shared until it executed
+     the program of the job, so the peak memory is unknown without the cgroup */
+  run.cpu_user    = (int64_t)usage->ru_utime.tv_sec*1000000 + usage->ru_utime.tv_usec;
+  run.cpu_system  = (int64_t)usage->ru_stime.tv_sec*1000000 + usage->ru_stime.tv_usec;
+  run.memory_peak = 0;
+  run.io_read     = (int64_t)usage->ru_inblock*512;
+  run.io_write    = (int64_t)usage->ru_oublock*512;
+  cgroups->collect(pid,run);
+
+  /* the process is reaped, whether through its file descriptor or by polling */
+  unwatch_job_process(poll,active_jobs->get_watch(pid));
+
+  /* remove the job from the table of active jobs and then notify the
+     database that the job has finished
+   */
+  if(false == active_jobs->remove(name,pid))
+  {
+    LOG_WARN << "Process " << pid << " does not belong to any job";
+  }
+  else
+  {
+    if(true == timed_out)
+    {
+      LOG_WARN << "Job '" << name << "' was stopped for exceeding its maximum runtime";
+    }
+
+    if(WIFSIGNALED(wstatus))
+    {
+      run.exit_status = -1;
+      run.signal      = WTERMSIG(wstatus);
+    }
+    else
+    {
+      run.exit_status = WEXITSTATUS(wstatus);
+      run.signal      = 0;
+    }
+    database->job_stopped(name,run,timed_out);
+
+    /* the job has a free instance, and the server a free slot, for the queued requests */
+    admission->unblock(name);
+    admit_queued_jobs(database,active_jobs,deadlines,admission,output,cgroups,poll,wake,timer);
+  }
+}
+
+static void watcher_thread(KiwibesDatabase *database, KiwibesProcessTable *active_jobs, KiwibesDeadlines *deadlines, KiwibesAdmissionQueue *admission, KiwibesJobOutput *output, KiwibesCgroups *cgroups, std::mutex *jobs_lock, bool *exitFlag, int poll, int wake, int timer)
+{
+#if defined(__linux__)
+  struct epoll_event events[WATCHER_MAX_EVENTS];
+
+  while(false == *exitFlag)
+  {
+    /* sleep until a child process exits, a deadline expires, or the thread is asked to exit */
+    int timeout = (true == watcher_polling) ? WATCHER_POLL_PERIOD_MS : -1;
+    int count   = epoll_wait(poll,events,WATCHER_MAX_EVENTS,timeout);
+
+    if((0 > count) && (EINTR != errno))
+    {
+      LOG_CRIT << "Failed to wait for the jobs processes(" << errno << "): "<< strerror(errno);
+      break;
+    }
+
+    /* check which of the processes has exited, and for each update the
+       database information and remove it from the table of active jobs 
+     */
+    std::lock_guard<std::mutex> lock(*jobs_lock);
+
+    for(int e = 0; e < count; e++)
+    {
+      if(0 == events[e].data.u64)
+      {
+        /* wake up event, clear it. The exit flag is checked by the loop */
+        uint64_t value;
+        if(sizeof(value) != read(wake,&value,sizeof(value)))
+        {
+          LOG_WARN << "Failed to clear the watcher wake up event";
+        }
+      }
+      else if(WATCHER_DEADLINE_EVENT == events[e].data.u64)
+      {
+        expire_job_deadlines(deadlines,timer);
+      }
+      else if(0 != (WATCHER_OUTPUT_EVENT & events[e].data.u64))
+      {
+        /* the pipe is closed, and so removed from the epoll instance, once the job closes it */
+        output->drain((int)(events[e].data.u64 & 0xFFFFFFFF));
+      }
+      else
       {
-        for(std::map<std::string, T_PROCESS_HANDLER>::iterator iter = active_jobs->begin(); iter != active_jobs->end(); iter++)
+        int               pidfd   = (int)(events[e].data.u64 >> 32);
+        T_PROCESS_HANDLER pid     = (T_PROCESS_HANDLER)(events[e].data.u64 & 0xFFFFFFFF);
+        int               wstatus = 0;
+        struct rusage     usage;
+        T_PROCESS_HANDLER reaped  = wait4(pid,&wstatus,WNOHANG,&usage);
+
+        if((pid == reaped) && (WIFEXITED(wstatus) || WIFSIGNALED(wstatus)))
+        {
+          /* this also stops watching the process */
+          job_process_exited(database,active_jobs,deadlines,admission,output,cgroups,poll,wake,timer,pid,wstatus,&usage);
+        }
+        else if(0 > reaped)
         {
-          if(pid == (*iter).second)
-          {
-            /* notify the database that the job has finished and then remove 
-               the job from the map of active jobs
-             */
-            std::string name = std::string((*iter).first);
-
-            database->job_stopped(name);
-            active_jobs->erase(iter);
-
-            /* if there are queued start requests for this job, run it again */
-            if(0 <= database->job_decr_start_requests(name))
-            {
-              LOG_INFO << "Job '" << name << "' has pending start requests, starting it again";
-
-              nlohmann::json job;
-              if(ERROR_NO_ERROR == database->get_job_description(job,name))
-              {
-                T_PROCESS_HANDLER handle = launch_job_process(job);
-
-                if(INVALID_PROCESS_HANDLE != handle)
-                {
-                  active_jobs->insert(std::pair<std::string,T_PROCESS_HANDLER>(name,handle));
-                  database->job_started(name);
-                  LOG_INFO << "Started job '" << name << "'";
-                }    
-                else
-                {
-                  LOG_CRIT << "Failed to launch process for job '" << name << "'";  
-                }
-              }
-            }
-            break;
-          }
+          /* not a child process, it should have been unwatched when it was reaped */
+          LOG_WARN << "Process " << pid << " was watched after being reaped";
+          unwatch_job_process(poll,pidfd);
         }
       }
+    }
+
+    if(true == watcher_polling)
+    {
+      /* without process file descriptors, reap any of the child processes */
+      int               wstatus = 0;
+      struct rusage     usage;
+      T_PROCESS_HANDLER pid     = wait4(-1,&wstatus,WNOHANG,&usage);
 
-      /* next job */
-      pid = waitpid(-1,&wstatus,WNOHANG);
+      while(0 < pid)
+      {
+        if(WIFEXITED(wstatus) || WIFSIGNALED(wstatus))
+        {
+          job_process_exited(database,active_jobs,deadlines,admission,output,cgroups,poll,wake,timer,pid,wstatus,&usage);
+        }
+
+        /* next job */
+        pid = wait4(-1,&wstatus,WNOHANG,&usage);
+      }
     }
+  }
 #endif 
+}
+
+static void launcher_thread(KiwibesJobsManager *manager, KiwibesLaunchQueue *launches, KiwibesInvocations *invocations, bool *exitFlag, int wake)
+{
+#if defined(__linux__)
+  while(false == *exitFlag)
+  {
+    /* sleep until there are requests, or the thread is asked to exit */
+    uint64_t value;
+    if((sizeof(value) != read(wake,&value,sizeof(value))) && (EINTR != errno))
+    {
+      LOG_CRIT << "Failed to wait for the start requests(" << errno << "): "<< strerror(errno);
+      break;
+    }
+
+    T_LAUNCH_REQUEST request;
 
-    jobs_lock->unlock();    
+    while((false == *exitFlag) && (true == launches->pop(request)))
+    {
+      bool            queued = false;
+      T_KIWIBES_ERROR error  = manager->start_job(request.name,queued);
+
+      if(ERROR_NO_ERROR != error)
+      {
+        invocations->finish(request.invocation,INVOCATION_FAILED,error);
+      }
+      else
+      {
+        invocations->finish(request.invocation,(true == queued) ? INVOCATION_PENDING : INVOCATION_STARTED,error);
+      }
+    }
   }
+#endif 
 }
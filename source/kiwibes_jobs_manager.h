@@ -23,31 +23,47 @@
   -------
 
   This class implements the jobs manager, responsible for starting
-  and stopping jobs.
+  and stopping jobs. Child processes are reaped by a watcher thread
+  that sleeps on an epoll instance, woken up by a process file 
+  descriptor (pidfd) as soon as one of the jobs exits. The same thread
+  stops the jobs which exceed their maximum runtime, woken up by a timer
+  armed at the earliest of their deadlines.
+
+  The number of jobs running at once can be limited, as well as the
+  number of instances of each job. The start requests over either of 
+  the limits wait in the admission queue, and are admitted as soon as
+  the running jobs exit.
+
+  Start requests can also be handed over to a launcher thread, so that
+  the caller never waits for the job to be spawned. Each request then
+  gets an invocation, which the caller can poll or wait for.
+
+  The standard output and error of the jobs are captured through pipes,
+  drained by the watcher thread into the bounded output of each job.
+
+  Each job runs in its own cgroup, when available, which enforces its 
+  memory and CPU limits. The resources used by each run are recorded
+  in its history when it exits.
 */
 #ifndef __KIWIBES_JOBS_MANAGER_H__
 #define __KIWIBES_JOBS_MANAGER_H__
 
+#include "kiwibes_admission_queue.h"
+#include "kiwibes_cgroups.h"
 #include "kiwibes_database.h"
+#include "kiwibes_deadlines.h"
 #include "kiwibes_errors.h"
+#include "kiwibes_invocations.h"
+#include "kiwibes_job_output.h"
+#include "kiwibes_launch_queue.h"
+#include "kiwibes_process_table.h"
 
 #include "nlohmann/json.h"
 
-#include <map>
 #include <string>
 #include <mutex>
 #include <thread>
 
-#if defined(__linux__)
-  #include <sys/types.h>
-  #include <unistd.h>
-
-  typedef pid_t T_PROCESS_HANDLER;
-  #define INVALID_PROCESS_HANDLE (-1)
-#else
-  #error "OS not supported"
-#endif 
-
 class KiwibesJobsManager {
 
 public:
@@ -61,14 +77,70 @@ public:
    */
   ~KiwibesJobsManager();
 
+  /** Set the maximum number of jobs running at once
+
+    @param max_running  the maximum number of jobs, 0 if there is no limit
+   */
+  void set_max_running(size_t max_running);
+
   /** Start the job with the given name
 
+    If either the job runs its maximum number of instances or too many jobs
+    are running, the request is queued and the job starts later.
+
     @param name   name of the job to start
     @return ERROR_NO_ERROR if successfull, error code otherwise
   */
   T_KIWIBES_ERROR start_job(const std::string &name);
+
+  /** Start the job with the given name
+
+    @param name     name of the job to start
+    @param queued   on return, true if the request was queued instead of starting the job
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR start_job(const std::string &name, bool &queued);
+
+  /** Hand over the start of the job with the given name to the launcher thread
+
+    The job is looked up at once, so only the requests for known jobs are 
+    handed over and get an invocation.
+
+    @param name   name of the job to start
+    @param id     on return, the identifier of the invocation, 0 if the request was refused
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR start_job_async(const std::string &name, uint64_t &id);
+
+  /** Return an invocation, after waiting for the launcher thread to handle it
+
+    @param invocation   on return, contains the invocation
+    @param id           the identifier of the invocation
+    @param wait         maximum time to wait, in milliseconds, 0 to return at once
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR get_invocation(T_INVOCATION &invocation, uint64_t id, unsigned int wait);
+
+  /** Set the folder where the complete output of each run is spilled
+
+    @param folder   the folder, ending with a separator, or empty to keep the output only in memory
+   */
+  void set_output_folder(const std::string &folder);
+
+  /** Read the output of a run of the job, after waiting for it to write more
+
+    @param data       on return, contains the output read
+    @param finished   on return, true if the run finished and all of its output was read
+    @param name       the name of the job
+    @param run        the identifier of the run, 0 for the latest. On return, contains the identifier
+    @param offset     position of the output to read. On return, contains the position after the data
+    @param max        maximum number of bytes to read
+    @param wait       maximum time to wait for more output, in milliseconds
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR read_job_output(std::string &data, bool &finished, const std::string &name, uint64_t &run, uint64_t &offset, size_t max, unsigned int wait);
   
-  /** Stop the job with the given name
+  /** Stop all the instances of the job with the given name
 
     @param name   name of the job to stop
     @return ERROR_NO_ERROR if successfull, error code otherwise
@@ -79,12 +151,31 @@ public:
    */
   void stop_all_jobs(void);
 
+  /** Remove the queued start requests of the job with the given name
+
+    @param name   name of the job
+    @return ERROR_NO_ERROR if successfull, error code otherwise
+  */
+  T_KIWIBES_ERROR clear_start_requests(const std::string &name);
+
 private:
   KiwibesDatabase                          *database;    /* private pointer to the database */
-  std::map<std::string, T_PROCESS_HANDLER> active_jobs;  /* active jobs */
+  KiwibesProcessTable                      active_jobs;  /* active jobs */
+  KiwibesDeadlines                         deadlines;    /* deadlines of the active jobs */
+  KiwibesAdmissionQueue                    admission;    /* start requests waiting for the active jobs to exit */
+  KiwibesJobOutput                         output;       /* output of the latest runs of the jobs */
+  KiwibesCgroups                           cgroups;      /* cgroups of the running jobs */
   std::mutex                               jobs_lock;    /* exclusive access to the list of running jobs */
   std::unique_ptr<std::thread>             watcher;      /* thread that waits for child processes to exit */
   bool                                     watcherExit;  /* flag to indicate when the watcher thread should exit */
+  int                                      watcherPoll;  /* epoll instance where the watcher thread waits */
+  int                                      watcherWake;  /* event used to wake up the watcher thread */
+  int                                      watcherTimer; /* timer armed at the earliest deadline of the active jobs */
+  KiwibesLaunchQueue                       launches;     /* start requests handed over to the launcher thread */
+  KiwibesInvocations                       invocations;  /* start invocations of the jobs */
+  std::unique_ptr<std::thread>             launcher;     /* thread that starts the requested jobs */
+  bool                                     launcherExit; /* flag to indicate when the launcher thread should exit */
+  int                                      launcherWake; /* event used to wake up the launcher thread */
 };  
 
 #endif
@@ -0,0 +1,82 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_launch_queue.h"
+
+#include <utility>
+
+KiwibesLaunchQueue::KiwibesLaunchQueue()
+{
+  /* the list always starts with a request that was already popped */
+  T_LAUNCH_NODE *stub = new T_LAUNCH_NODE;
+
+  stub->next.store(nullptr,std::memory_order_relaxed);
+  lhead.store(stub,std::memory_order_relaxed);
+  ltail = stub;
+}
+
+KiwibesLaunchQueue::~KiwibesLaunchQueue()
+{
+  while(nullptr != ltail)
+  {
+    T_LAUNCH_NODE *next = ltail->next.load(std::memory_order_acquire);
+
+    delete ltail;
+    ltail = next;
+  }
+}
+
+void KiwibesLaunchQueue::push(uint64_t invocation, const std::string &name)
+{
+  T_LAUNCH_NODE *node = new T_LAUNCH_NODE;
+
+  node->next.store(nullptr,std::memory_order_relaxed);
+  node->request.invocation = invocation;
+  node->request.name       = name;
+
+  /* the request becomes the head first, and is then linked to the previous one */
+  T_LAUNCH_NODE *previous = lhead.exchange(node,std::memory_order_acq_rel);
+
+  previous->next.store(node,std::memory_order_release);
+}
+
+bool KiwibesLaunchQueue::pop(T_LAUNCH_REQUEST &request)
+{
+  bool          success = false;
+  T_LAUNCH_NODE *next   = ltail->next.load(std::memory_order_acquire);
+
+  if(nullptr != next)
+  {
+    /* the popped request takes the place of the first one */
+    request = std::move(next->request);
+
+    delete ltail;
+    ltail   = next;
+    success = true;
+  }
+
+  return success;
+}
@@ -0,0 +1,90 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the queue of start requests handed over to the
+  launcher thread of the jobs manager. Any thread can push requests, and
+  only the launcher thread pops them. Pushing exchanges the head of a
+  singly linked list of requests, so it never waits for other threads
+  and never takes a lock, and popping only follows the links from the 
+  tail. A request being pushed is only visible after it was linked to 
+  the previous one, so a pop may briefly miss it, in which case the
+  producer wakes up the consumer once more.
+*/
+#ifndef __KIWIBES_LAUNCH_QUEUE_H__
+#define __KIWIBES_LAUNCH_QUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** A start request of a job
+ */
+typedef struct {
+  uint64_t    invocation;   /* the invocation of the request */
+  std::string name;         /* the name of the job */
+} T_LAUNCH_REQUEST;
+
+/** A request in the queue, linked to the one pushed after it
+ */
+typedef struct T_LAUNCH_NODE {
+  std::atomic<struct T_LAUNCH_NODE *> next;      /* the next request, NULL if there is none yet */
+  T_LAUNCH_REQUEST                    request;   /* the start request */
+} T_LAUNCH_NODE;
+
+/*-------------------------- Class Definitions -------------------------------*/
+class KiwibesLaunchQueue {
+
+public:
+  /** Class constructor
+   */
+  KiwibesLaunchQueue();
+
+  /** Class destructor, the requests left in the queue are dropped
+   */
+  ~KiwibesLaunchQueue();
+
+  /** Add a start request to the queue, can be called from any thread
+
+    @param invocation   the invocation of the request
+    @param name         the name of the job
+   */
+  void push(uint64_t invocation, const std::string &name);
+
+  /** Remove the oldest start request of the queue, must only be called by a single thread
+
+    @param request  on return, contains the start request
+    @return true if a request was removed, false if the queue is empty
+   */
+  bool pop(T_LAUNCH_REQUEST &request);
+
+private:
+  KiwibesLaunchQueue(const KiwibesLaunchQueue &) = delete;
+  KiwibesLaunchQueue &operator=(const KiwibesLaunchQueue &) = delete;
+
+  std::atomic<T_LAUNCH_NODE *>  lhead;   /* the request pushed last, producers only */
+  T_LAUNCH_NODE                 *ltail;  /* the request popped last, whose successor is the oldest, consumer only */
+};  
+
+#endif
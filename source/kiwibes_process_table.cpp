@@ -0,0 +1,140 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_process_table.h"
+
+#include <chrono>
+
+KiwibesProcessTable::KiwibesProcessTable()
+{
+}
+
+bool KiwibesProcessTable::insert(const std::string &name, T_PROCESS_HANDLER handle)
+{
+  bool success = false;
+
+  if(0 == by_handle.count(handle))
+  {
+    T_PROCESS_ENTRY entry;
+
+    entry.name  = name;
+    entry.start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    entry.watch = -1;
+
+    by_name.insert(std::pair<std::string,T_PROCESS_HANDLER>(name,handle));
+    by_handle.insert(std::pair<T_PROCESS_HANDLER,T_PROCESS_ENTRY>(handle,entry));
+    success = true;
+  }
+
+  return success;
+}
+
+bool KiwibesProcessTable::remove(std::string &name, T_PROCESS_HANDLER handle)
+{
+  bool success = false;
+  std::unordered_map<T_PROCESS_HANDLER,T_PROCESS_ENTRY>::iterator iter = by_handle.find(handle);
+
+  if(by_handle.end() != iter)
+  {
+    std::pair<std::multimap<std::string,T_PROCESS_HANDLER>::iterator,std::multimap<std::string,T_PROCESS_HANDLER>::iterator> range;
+
+    name  = iter->second.name;
+    range = by_name.equal_range(name);
+
+    for(std::multimap<std::string,T_PROCESS_HANDLER>::iterator process = range.first; process != range.second; process++)
+    {
+      if(handle == process->second)
+      {
+        by_name.erase(process);
+        break;
+      }
+    }
+
+    by_handle.erase(iter);
+    success = true;
+  }
+
+  return success;
+}
+
+T_PROCESS_HANDLER KiwibesProcessTable::get_handle(const std::string &name) const
+{
+  T_PROCESS_HANDLER handle = INVALID_PROCESS_HANDLE;
+  std::multimap<std::string,T_PROCESS_HANDLER>::const_iterator iter = by_name.find(name);
+
+  if(by_name.end() != iter)
+  {
+    handle = iter->second;
+  }
+
+  return handle;
+}
+
+int64_t KiwibesProcessTable::get_start(T_PROCESS_HANDLER handle) const
+{
+  std::unordered_map<T_PROCESS_HANDLER,T_PROCESS_ENTRY>::const_iterator iter = by_handle.find(handle);
+
+  return (by_handle.end() != iter) ? iter->second.start : 0;
+}
+
+bool KiwibesProcessTable::set_watch(T_PROCESS_HANDLER handle, int watch)
+{
+  std::unordered_map<T_PROCESS_HANDLER,T_PROCESS_ENTRY>::iterator iter = by_handle.find(handle);
+
+  if(by_handle.end() != iter)
+  {
+    iter->second.watch = watch;
+  }
+
+  return (by_handle.end() != iter);
+}
+
+int KiwibesProcessTable::get_watch(T_PROCESS_HANDLER handle) const
+{
+  std::unordered_map<T_PROCESS_HANDLER,T_PROCESS_ENTRY>::const_iterator iter = by_handle.find(handle);
+
+  return (by_handle.end() != iter) ? iter->second.watch : -1;
+}
+
+size_t KiwibesProcessTable::instances(const std::string &name) const
+{
+  return by_name.count(name);
+}
+
+bool KiwibesProcessTable::is_running(const std::string &name) const
+{
+  return (by_name.end() != by_name.find(name));
+}
+
+size_t KiwibesProcessTable::size(void) const
+{
+  return by_handle.size();
+}
+
+const std::multimap<std::string, T_PROCESS_HANDLER> &KiwibesProcessTable::running(void) const
+{
+  return by_name;
+}
@@ -0,0 +1,134 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the table of running jobs, indexed both by
+  the job name and by the handle of its processes, since a job can 
+  have several instances running at once. This way the processes
+  of a job are found in O(log n), and the job of an exited process 
+  in O(1). The table is not synchronized, the owner must lock it.
+*/
+#ifndef __KIWIBES_PROCESS_TABLE_H__
+#define __KIWIBES_PROCESS_TABLE_H__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#if defined(__linux__)
+  #include <sys/types.h>
+  #include <unistd.h>
+
+  typedef pid_t T_PROCESS_HANDLER;
+  #define INVALID_PROCESS_HANDLE (-1)
+#else
+  #error "OS not supported"
+#endif 
+
+/** A running process of a job
+ */
+typedef struct {
+  std::string name;   /* the name of the job */
+  int64_t     start;  /* instant the process started, in milliseconds since the epoch */
+  int         watch;  /* file descriptor watching the exit of the process, -1 if none */
+} T_PROCESS_ENTRY;
+
+class KiwibesProcessTable {
+
+public:
+  /** Class constructor
+   */
+  KiwibesProcessTable();
+
+  /** Add a running instance of a job to the table, started now
+
+    @param name     the name of the job
+    @param handle   the handle of the job process
+    @return true if successfull, false if the process is already in the table
+   */
+  bool insert(const std::string &name, T_PROCESS_HANDLER handle);
+
+  /** Remove the job with the given process from the table
+
+    @param name     on return, contains the name of the job
+    @param handle   the handle of the job process
+    @return true if successfull, false if the process is not in the table
+   */
+  bool remove(std::string &name, T_PROCESS_HANDLER handle);
+
+  /** Return the process handle of the given job, the oldest if it has several instances
+
+    @param name   the name of the job
+    @return the process handle, INVALID_PROCESS_HANDLE if the job is not running
+   */
+  T_PROCESS_HANDLER get_handle(const std::string &name) const;
+
+  /** Return the instant the given process started, in milliseconds since the epoch
+
+    @param handle   the handle of the job process
+    @return the instant, 0 if the process is not in the table
+   */
+  int64_t get_start(T_PROCESS_HANDLER handle) const;
+
+  /** Set the file descriptor watching the exit of the given process
+
+    @param handle   the handle of the job process
+    @param watch    the file descriptor
+    @return true if successfull, false if the process is not in the table
+   */
+  bool set_watch(T_PROCESS_HANDLER handle, int watch);
+
+  /** Return the file descriptor watching the exit of the given process
+
+    @param handle   the handle of the job process
+    @return the file descriptor, -1 if the process is not watched or not in the table
+   */
+  int get_watch(T_PROCESS_HANDLER handle) const;
+
+  /** Return the number of running instances of the given job
+
+    @param name   the name of the job
+   */
+  size_t instances(const std::string &name) const;
+
+  /** Return true if the given job is running, false otherwise
+
+    @param name   the name of the job
+   */
+  bool is_running(const std::string &name) const;
+
+  /** Return the number of running processes
+   */
+  size_t size(void) const;
+
+  /** Return all the running processes, ordered by the name of their job
+   */
+  const std::multimap<std::string, T_PROCESS_HANDLER> &running(void) const;
+
+private:
+  std::multimap<std::string, T_PROCESS_HANDLER>          by_name;     /* processes of each running job, oldest first */
+  std::unordered_map<T_PROCESS_HANDLER, T_PROCESS_ENTRY> by_handle;   /* job of each running process */
+};  
+
+#endif
@@ -29,7 +29,48 @@
 #include "NanoLog/NanoLog.hpp"
 #include "nlohmann/json.h"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+
 /*--------------------------Private Data Definitions -------------------------------*/
+/** Default window of time of the jobs forecast, in seconds
+ */
+#define FORECAST_DEFAULT_WINDOW   (24*3600)
+
+/** Maximum window of time of the jobs forecast, in seconds
+ */
+#define FORECAST_MAX_WINDOW       (31*24*3600)
+
+/** Maximum number of start instants listed per job in the forecast
+ */
+#define FORECAST_MAX_STARTS       (10000)
+
+/** Number of jobs in each chunk of the streamed export
+ */
+#define EXPORT_CHUNK_JOBS         (256)
+
+/** Maximum time a caller can wait for a start invocation, in milliseconds
+ */
+#define INVOCATION_MAX_WAIT       (30000)
+
+/** Maximum number of bytes of output in each chunk, time to wait for more 
+    output when following a run, and longest silence before the stream is
+    ended, in milliseconds
+ */
+#define OUTPUT_CHUNK_BYTES        (64*1024)
+#define OUTPUT_FOLLOW_WAIT        (1000)
+#define OUTPUT_FOLLOW_SILENCE     (30000)
+
+/** Default, and maximum, number of jobs in a page of the jobs listing
+ */
+#define LIST_DEFAULT_LIMIT        (100)
+#define LIST_MAX_LIMIT            (1000)
+
 /** Private pointers to the Kiwibes components
  */
 static KiwibesDatabase       *pDatabase;
@@ -75,6 +116,13 @@ static void rest_post_edit_job(const httplib::Request& req, httplib::Response& r
  */
 static void rest_post_delete_job(const httplib::Request& req, httplib::Response& res);
 
+/** REST: Delete many jobs at once
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_post_delete_jobs(const httplib::Request& req, httplib::Response& res);
+
 /** REST: Clear all pending start requests for this job
 
   @param req  the incoming HTTP request
@@ -89,13 +137,37 @@ static void rest_post_clear_pending_job(const httplib::Request& req, httplib::Re
  */
 static void rest_get_get_job(const httplib::Request& req, httplib::Response& res);
 
-/** REST: List the name of all jobs
+/** REST: Get a start invocation, after waiting for it to be handled
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_get_invocation(const httplib::Request& req, httplib::Response& res);
+
+/** REST: Get the output of a run of a job, or follow it until the run finishes
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_get_job_output(const httplib::Request& req, httplib::Response& res);
+
+/** REST: List the name of all jobs, or a page of the jobs that match a filter
 
   @param req  the incoming HTTP request
   @param res  the outgoing HTTP response
  */
 static void rest_get_jobs_list(const httplib::Request& req, httplib::Response& res);
 
+/** Parse the filter, cursor and limit of a jobs listing
+
+  @param filter   on return, contains the filter and order of the listing
+  @param cursor   on return, contains the cursor of the page
+  @param limit    on return, contains the maximum number of jobs in the page
+  @param req      the incoming HTTP request
+  @return ERROR_NO_ERROR if successfull, error code otherwise
+ */
+static T_KIWIBES_ERROR parse_jobs_list(T_JOB_FILTER &filter, std::string &cursor, size_t &limit, const httplib::Request& req);
+
 /** REST: List the name of all jobs currently scheduled to run
 
   @param req  the incoming HTTP request
@@ -103,6 +175,65 @@ static void rest_get_jobs_list(const httplib::Request& req, httplib::Response& r
  */
 static void rest_get_scheduled_jobs(const httplib::Request& req, httplib::Response& res);
 
+/** REST: List the start instants of all scheduled jobs inside a window of time
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_get_jobs_forecast(const httplib::Request& req, httplib::Response& res);
+
+/** REST: Create many jobs at once, either all of them or none
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_post_import_jobs(const httplib::Request& req, httplib::Response& res);
+
+/** REST: Stream the descriptions of all jobs, one JSON object per line
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_get_export_jobs(const httplib::Request& req, httplib::Response& res);
+
+/** REST: Return the statistics of the server
+
+  @param req  the incoming HTTP request
+  @param res  the outgoing HTTP response
+ */
+static void rest_get_stats(const httplib::Request& req, httplib::Response& res);
+
+/** Parse and validate the jobs of an import request
+
+  The body is either a JSON array of jobs, or one JSON job per line. Each
+  job is an object with its name, program, schedule and max-runtime.
+
+  @param jobs   on return, contains the details of each job, by name
+  @param body   the body of the request
+  @return ERROR_NO_ERROR if successfull, error code otherwise
+ */
+static T_KIWIBES_ERROR parse_import_jobs(std::map<std::string,nlohmann::json> &jobs, const std::string &body);
+
+/** Return the next chunk of the streamed export
+
+  @param names    the names of the jobs to export
+  @param next     position of the next job to export
+  @param offset   number of bytes sent so far
+  @return the descriptions of the next jobs, one per line, empty once all were sent
+ */
+static std::string export_chunk(std::shared_ptr<std::vector<std::string> > names, std::shared_ptr<size_t> next, uint64_t offset);
+
+/** Return the next chunk of the followed output of a run, after waiting for the job to write it
+
+  @param name     the name of the job
+  @param run      the identifier of the run
+  @param next     position of the next byte of output to send
+  @param offset   number of bytes sent so far
+  @return the next bytes of output, empty once the run finished and all of its output was sent,
+          or once the run stayed silent for OUTPUT_FOLLOW_SILENCE
+ */
+static std::string output_chunk(const std::string &name, std::shared_ptr<uint64_t> run, std::shared_ptr<uint64_t> next, uint64_t offset);
+
 /** Read the job parameters from the POST request
 
   @param params   on return, contains the POST job parameters
@@ -180,6 +311,8 @@ void setup_rest_interface(httplib::SSLServer *https,
   https->Post("/rest/job/delete/([a-zA-Z_0-9]+)",rest_post_delete_job);    
   https->Post("/rest/job/clear_pending/([a-zA-Z_0-9]+)",rest_post_clear_pending_job);    
   https->Get( "/rest/job/details/([a-zA-Z_0-9]+)",rest_get_get_job);
+  https->Get( "/rest/job/invocation/([0-9]+)",rest_get_invocation);
+  https->Get( "/rest/job/output/([a-zA-Z_0-9]+)",rest_get_job_output);
 
   https->Post("/rest/ping",rest_post_ping);
 
@@ -191,6 +324,12 @@ void setup_rest_interface(httplib::SSLServer *https,
   
   https->Get("/rest/jobs/list",rest_get_jobs_list);
   https->Get("/rest/jobs/scheduled",rest_get_scheduled_jobs);
+  https->Get("/rest/jobs/forecast",rest_get_jobs_forecast);
+  https->Post("/rest/jobs/delete",rest_post_delete_jobs);
+  https->Post("/rest/jobs/import",rest_post_import_jobs);
+  https->Get("/rest/jobs/export",rest_get_export_jobs);
+
+  https->Get("/rest/stats",rest_get_stats);
 }
 
 /*--------------------------Private Function Definitions -------------------------------*/
@@ -206,10 +345,27 @@ static void rest_post_start_job(const httplib::Request& req, httplib::Response&
   }
   else
   {
-    error = pManager->start_job(req.matches[1]);
+    /* the job is started by the launcher thread, the caller gets the invocation to follow it */
+    uint64_t id;
+
+    error = pManager->start_job_async(req.matches[1],id);
+
+    if(ERROR_NO_ERROR == error)
+    {
+      nlohmann::json invocation;
+
+      invocation["invocation"] = id;
+      res.set_content(invocation.dump(),"application/json");
+    }
   }
   
   set_return_code(res,error); 
+
+  /* the request is accepted, but the job is not started yet */
+  if(ERROR_NO_ERROR == error)
+  {
+    res.status = 202;
+  }
 }
 
 static void rest_post_stop_job(const httplib::Request& req, httplib::Response& res)
@@ -344,6 +500,43 @@ static void rest_post_delete_job(const httplib::Request& req, httplib::Response&
   set_return_code(res,error);    
 }
 
+static void rest_post_delete_jobs(const httplib::Request& req, httplib::Response& res)
+{
+  T_KIWIBES_ERROR          error = ERROR_NO_ERROR;
+  std::vector<std::string> names;
+
+  if((true != req.has_param("auth")) ||
+     (true != pAuthentication->verify_auth_token(req.get_param_value("auth")))
+    )
+  {
+    error  = ERROR_AUTHENTICATION_FAIL;
+  }
+  else if(true != req.has_param("name"))
+  {
+    error = ERROR_EMPTY_REST_REQUEST;
+  }
+  else
+  {
+    for(size_t n = 0; n < req.get_param_value_count("name"); n++)
+    {
+      names.push_back(req.get_param_value("name",n));  
+    }
+
+    error = pDatabase->delete_jobs(names);    
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    /* unschedule the jobs, if they were previously scheduled */
+    for(size_t n = 0; n < names.size(); n++)
+    {
+      pScheduler->unschedule_job(names[n]);  
+    }
+  }
+
+  set_return_code(res,error);    
+}
+
 static void rest_post_clear_pending_job(const httplib::Request& req, httplib::Response& res)
 {
   T_KIWIBES_ERROR error = ERROR_NO_ERROR;
@@ -356,7 +549,7 @@ static void rest_post_clear_pending_job(const httplib::Request& req, httplib::Re
   }
   else
   {  
-    error = pDatabase->job_clear_start_requests(req.matches[1]);
+    error = pManager->clear_start_requests(req.matches[1]);
   }
 
   set_return_code(res,error); 
@@ -385,15 +578,150 @@ static void rest_get_get_job(const httplib::Request& req, httplib::Response& res
   }
 }
 
+static void rest_get_invocation(const httplib::Request& req, httplib::Response& res)
+{
+  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  T_INVOCATION    invocation;
+
+  if((true != req.has_param("auth")) ||
+     (true != pAuthentication->verify_auth_token(req.get_param_value("auth")))
+    )
+  {
+    error = ERROR_AUTHENTICATION_FAIL;
+  }
+  else
+  {
+    try
+    {
+      uint64_t  id   = std::stoull(req.matches[1]);
+      long long wait = (true == req.has_param("wait")) ? std::stoll(req.get_param_value("wait")) : 0;
+
+      error = pManager->get_invocation(invocation,id,(unsigned int)std::max(0LL,std::min((long long)INVOCATION_MAX_WAIT,wait)));
+    }
+    catch(std::exception &e)
+    {
+      error = ERROR_INVOCATION_UNKNOWN;
+    }
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    const char     *status[] = { "queued", "started", "pending", "failed" };
+    nlohmann::json description;
+
+    description["invocation"] = invocation.id;
+    description["job"]        = invocation.name;
+    description["status"]     = status[invocation.status];
+    description["error"]      = invocation.error;
+    res.set_content(description.dump(),"application/json");
+  }
+
+  set_return_code(res,error);
+}
+
+static void rest_get_job_output(const httplib::Request& req, httplib::Response& res)
+{
+  T_KIWIBES_ERROR           error    = ERROR_NO_ERROR;
+  std::shared_ptr<uint64_t> run(new uint64_t(0));
+  std::shared_ptr<uint64_t> next(new uint64_t(0));
+  std::string               output;
+  bool                      finished = false;
+
+  if((true != req.has_param("auth")) ||
+     (true != pAuthentication->verify_auth_token(req.get_param_value("auth")))
+    )
+  {
+    error = ERROR_AUTHENTICATION_FAIL;
+  }
+  else
+  {
+    try
+    {
+      *run = (true == req.has_param("run")) ? std::stoull(req.get_param_value("run")) : 0;
+      *next = (true == req.has_param("offset")) ? std::stoull(req.get_param_value("offset")) : 0;
+
+      /* resolves the run and skips to the oldest output still kept */
+      error = pManager->read_job_output(output,finished,req.matches[1],*run,*next,0,0);
+    }
+    catch(std::exception &e)
+    {
+      error = ERROR_OUTPUT_UNKNOWN;
+    }
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    res.set_header("X-Kiwibes-Run",std::to_string(*run).c_str());
+
+    if((true == req.has_param("follow")) && ("1" == req.get_param_value("follow")))
+    {
+      /* the output is sent as the job writes it, a chunk at a time */
+      res.status   = 200;
+      res.set_header("Content-Type","text/plain");
+      res.streamcb = std::bind(output_chunk,std::string(req.matches[1]),run,next,std::placeholders::_1);
+    }
+    else
+    {
+      std::string body;
+
+      do
+      {
+        body  += output;
+        error  = pManager->read_job_output(output,finished,req.matches[1],*run,*next,OUTPUT_CHUNK_BYTES,0);
+      }
+      while((ERROR_NO_ERROR == error) && (false == output.empty()));
+
+      res.set_content(body,"text/plain");
+      set_return_code(res,error);
+    }
+  }
+  else
+  {
+    set_return_code(res,error);
+  }
+}
+
 static void rest_get_jobs_list(const httplib::Request& req, httplib::Response& res)
 {
   std::vector<std::string> jobs;
 
-  pDatabase->get_all_job_names(jobs);
-  
-  nlohmann::json names(jobs); 
-  res.status = 200;
-  res.set_content(names.dump(),"application/json");    
+  /* without any of the paging parameters, all the names are listed */
+  if((false == req.has_param("status")) && (false == req.has_param("pending")) &&
+     (false == req.has_param("prefix")) && (false == req.has_param("order")) &&
+     (false == req.has_param("limit")) && (false == req.has_param("cursor")))
+  {
+    pDatabase->get_all_job_names(jobs);
+    
+    nlohmann::json names(jobs); 
+    res.status = 200;
+    res.set_content(names.dump(),"application/json");    
+  }
+  else
+  {
+    T_JOB_FILTER    filter;
+    std::string     cursor;
+    size_t          limit = LIST_DEFAULT_LIMIT;
+    T_KIWIBES_ERROR error = parse_jobs_list(filter,cursor,limit,req);
+
+    if(ERROR_NO_ERROR == error)
+    {
+      error = pDatabase->get_job_names_page(jobs,cursor,filter,limit);
+    }
+
+    if(ERROR_NO_ERROR == error)
+    {
+      nlohmann::json page;
+
+      page["jobs"]   = jobs;
+      page["cursor"] = cursor;
+      res.status = 200;
+      res.set_content(page.dump(),"application/json");    
+    }
+    else
+    {
+      set_return_code(res,error);
+    }
+  }
 }
 
 static void rest_get_scheduled_jobs(const httplib::Request& req, httplib::Response& res)
@@ -412,6 +740,126 @@ static void rest_get_scheduled_jobs(const httplib::Request& req, httplib::Respon
   res.set_content(names.dump(),"application/json");    
 }
 
+static void rest_get_jobs_forecast(const httplib::Request& req, httplib::Response& res)
+{
+  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  std::time_t     from  = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::time_t     to    = from + FORECAST_DEFAULT_WINDOW;
+
+  /* the window is optional, by default it is the next 24 hours */
+  try
+  {
+    if(true == req.has_param("from"))
+    {
+      from = (std::time_t)std::stoll(req.get_param_value("from"));
+      to   = from + FORECAST_DEFAULT_WINDOW;
+    }
+
+    if(true == req.has_param("to"))
+    {
+      to = (std::time_t)std::stoll(req.get_param_value("to"));
+    }
+  }
+  catch(std::exception &e)
+  {
+    error = ERROR_EMPTY_REST_REQUEST;
+  }
+
+  if((ERROR_NO_ERROR == error) && ((to < from) || ((to - from) > FORECAST_MAX_WINDOW)))
+  {
+    error = ERROR_EMPTY_REST_REQUEST;
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    std::map<std::string,std::vector<std::time_t> > forecast;
+
+    pDatabase->get_all_jobs_forecast(forecast,from,to,FORECAST_MAX_STARTS);
+
+    nlohmann::json starts(forecast);
+    res.status = 200;
+    res.set_content(starts.dump(),"application/json");
+  }
+
+  set_return_code(res,error);
+}
+
+static void rest_get_stats(const httplib::Request& req, httplib::Response& res)
+{
+  nlohmann::json stats;
+
+  pDatabase->get_stats(stats);
+
+  res.status = 200;
+  res.set_content(stats.dump(),"application/json");    
+}
+
+static void rest_post_import_jobs(const httplib::Request& req, httplib::Response& res)
+{
+  T_KIWIBES_ERROR                       error = ERROR_NO_ERROR;
+  std::map<std::string,nlohmann::json> jobs;
+
+  if((true != req.has_param("auth")) ||
+     (true != pAuthentication->verify_auth_token(req.get_param_value("auth")))
+    )
+  {
+    error = ERROR_AUTHENTICATION_FAIL;
+  }
+  else
+  {
+    error = parse_import_jobs(jobs,req.body);
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    error = pDatabase->create_jobs(jobs);
+  }
+
+  if(ERROR_NO_ERROR == error)
+  {
+    /* the jobs with a schedule are added to the scheduler all at once */
+    std::vector<std::string> scheduled;
+    nlohmann::json           imported;
+
+    for(std::map<std::string,nlohmann::json>::iterator job = jobs.begin(); job != jobs.end(); job++)
+    {
+      if(0 < job->second["schedule"].get<std::string>().size())
+      {
+        scheduled.push_back(job->first);
+      }
+    }
+    pScheduler->schedule_jobs(scheduled);
+
+    LOG_INFO << "imported " << jobs.size() << " jobs";
+    imported["imported"] = jobs.size();
+    res.set_content(imported.dump(),"application/json");
+  }
+
+  set_return_code(res,error);
+}
+
+static void rest_get_export_jobs(const httplib::Request& req, httplib::Response& res)
+{
+  if((true != req.has_param("auth")) ||
+     (true != pAuthentication->verify_auth_token(req.get_param_value("auth")))
+    )
+  {
+    set_return_code(res,ERROR_AUTHENTICATION_FAIL); 
+  }
+  else
+  {
+    /* the descriptions are read while the response is sent, a chunk at a time */
+    std::shared_ptr<std::vector<std::string> > names(new std::vector<std::string>());
+    std::shared_ptr<size_t>                    next(new size_t(0));
+
+    pDatabase->get_all_job_names(*names);
+
+    res.status   = 200;
+    res.set_header("Content-Type","application/x-ndjson");
+    res.streamcb = std::bind(export_chunk,names,next,std::placeholders::_1);
+  }
+}
+
 static void rest_post_write_data(const httplib::Request& req, httplib::Response& res)
 {
   T_KIWIBES_ERROR error = ERROR_NO_ERROR;
@@ -555,6 +1003,12 @@ static bool read_job_parameters(nlohmann::json &params, const httplib::Request &
     - program     : a string array 
     - schedule    : a string 
     - max-runtime : an unsigned long integer 
+
+     and optionally:
+    - max-parallel : an unsigned integer, at least 1
+    - priority     : a signed integer
+    - max-memory   : an unsigned integer, in MB
+    - max-cpu      : an unsigned integer, in percent of a CPU
    */
   if(true == req.has_param("max-runtime"))
   {
@@ -574,6 +1028,35 @@ static bool read_job_parameters(nlohmann::json &params, const httplib::Request &
     success = false;
   }
 
+  if(true == req.has_param("max-parallel"))
+  {
+    long int max_parallel = std::stol(req.get_param_value("max-parallel"));
+
+    params["max-parallel"] = (unsigned int)max_parallel;
+    success = success && (0 < max_parallel);
+  }
+
+  if(true == req.has_param("priority"))
+  {
+    params["priority"] = (signed int)std::stoi(req.get_param_value("priority"));
+  }
+
+  if(true == req.has_param("max-memory"))
+  {
+    long int max_memory = std::stol(req.get_param_value("max-memory"));
+
+    params["max-memory"] = (unsigned int)max_memory;
+    success = success && (0 <= max_memory);
+  }
+
+  if(true == req.has_param("max-cpu"))
+  {
+    long int max_cpu = std::stol(req.get_param_value("max-cpu"));
+
+    params["max-cpu"] = (unsigned int)max_cpu;
+    success = success && (0 <= max_cpu);
+  }
+
   if(true == req.has_param("program"))
   {
     std::vector<std::string> program;
@@ -592,6 +1075,239 @@ static bool read_job_parameters(nlohmann::json &params, const httplib::Request &
   return success; 
 }
 
+static T_KIWIBES_ERROR parse_import_jobs(std::map<std::string,nlohmann::json> &jobs, const std::string &body)
+{
+  T_KIWIBES_ERROR             error = ERROR_NO_ERROR;
+  std::vector<nlohmann::json> entries;
+  size_t                      start = body.find_first_not_of(" \t\r\n");
+
+  try
+  {
+    if(std::string::npos == start)
+    {
+      error = ERROR_EMPTY_REST_REQUEST;
+    }
+    else if('[' == body[start])
+    {
+      nlohmann::json array = nlohmann::json::parse(body);
+
+      entries.reserve(array.size());
+      for(size_t e = 0; e < array.size(); e++)
+      {
+        entries.push_back(std::move(array[e]));
+      }
+    }
+    else
+    {
+      /* one job per line, empty lines are skipped */
+      std::istringstream lines(body);
+      std::string        line;
+
+      while(std::getline(lines,line))
+      {
+        if(std::string::npos != line.find_first_not_of(" \t\r"))
+        {
+          entries.push_back(nlohmann::json::parse(line));
+        }
+      }
+    }
+  }
+  catch(nlohmann::detail::exception &e)
+  {
+    LOG_INFO << "invalid jobs to import: " << e.what();
+    error = ERROR_JOB_DESCRIPTION_INVALID;
+  }
+
+  for(size_t e = 0; (ERROR_NO_ERROR == error) && (e < entries.size()); e++)
+  {
+    nlohmann::json &entry = entries[e];
+    std::string    name;
+    bool           valid  = (true == entry.is_object()) &&
+                            (1 == entry.count("name")) && (true == entry["name"].is_string()) &&
+                            (1 == entry.count("program")) && (true == entry["program"].is_array()) &&
+                            (1 == entry.count("schedule")) && (true == entry["schedule"].is_string()) &&
+                            (1 == entry.count("max-runtime")) && (true == entry["max-runtime"].is_number_unsigned()) &&
+                            ((0 == entry.count("max-parallel")) || ((true == entry["max-parallel"].is_number_unsigned()) && (0 < entry["max-parallel"].get<unsigned int>()))) &&
+                            ((0 == entry.count("priority")) || (true == entry["priority"].is_number_integer())) &&
+                            ((0 == entry.count("max-memory")) || (true == entry["max-memory"].is_number_unsigned())) &&
+                            ((0 == entry.count("max-cpu")) || (true == entry["max-cpu"].is_number_unsigned()));
+
+    for(size_t p = 0; (true == valid) && (p < entry["program"].size()); p++)
+    {
+      valid = entry["program"][p].is_string();
+    }
+
+    /* the names follow the same rules as in the other job REST calls */
+    if(true == valid)
+    {
+      name  = entry["name"].get<std::string>();
+      valid = (0 < name.size());
+
+      for(size_t c = 0; (true == valid) && (c < name.size()); c++)
+      {
+        valid = (0 != std::isalnum((unsigned char)name[c])) || ('_' == name[c]);
+      }
+    }
+
+    if(false == valid)
+    {
+      error = ERROR_JOB_DESCRIPTION_INVALID;
+    }
+    else if(0 < jobs.count(name))
+    {
+      error = ERROR_JOB_NAME_TAKEN;
+    }
+    else if((0 < entry["schedule"].get<std::string>().size()) && (false == KiwibesCron(entry["schedule"].get<std::string>()).is_valid()))
+    {
+      error = ERROR_JOB_SCHEDULE_INVALID;
+    }
+    else
+    {
+      nlohmann::json &details = jobs[name];
+
+      details["program"]     = entry["program"];
+      details["schedule"]    = entry["schedule"];
+      details["max-runtime"] = entry["max-runtime"];
+
+      if(1 == entry.count("max-parallel"))
+      {
+        details["max-parallel"] = entry["max-parallel"];
+      }
+      if(1 == entry.count("priority"))
+      {
+        details["priority"] = entry["priority"];
+      }
+      if(1 == entry.count("max-memory"))
+      {
+        details["max-memory"] = entry["max-memory"];
+      }
+      if(1 == entry.count("max-cpu"))
+      {
+        details["max-cpu"] = entry["max-cpu"];
+      }
+    }
+  }
+
+  return error;
+}
+
+static T_KIWIBES_ERROR parse_jobs_list(T_JOB_FILTER &filter, std::string &cursor, size_t &limit, const httplib::Request& req)
+{
+  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+
+  filter.by_status = req.has_param("status");
+  filter.status    = JOB_STATUS_STOPPED;
+  filter.pending   = false;
+  filter.prefix    = req.get_param_value("prefix");
+  filter.order     = JOB_ORDER_NAME;
+  cursor           = req.get_param_value("cursor");
+
+  if(true == filter.by_status)
+  {
+    std::string status = req.get_param_value("status");
+
+    if(0 == status.compare("running"))
+    {
+      filter.status = JOB_STATUS_RUNNING;
+    }
+    else if(0 != status.compare("stopped"))
+    {
+      error = ERROR_JOB_LIST_INVALID;
+    }
+  }
+
+  if(true == req.has_param("pending"))
+  {
+    std::string pending = req.get_param_value("pending");
+
+    if(0 == pending.compare("true"))
+    {
+      filter.pending = true;
+    }
+    else if(0 != pending.compare("false"))
+    {
+      error = ERROR_JOB_LIST_INVALID;
+    }
+  }
+
+  if(true == req.has_param("order"))
+  {
+    std::string order = req.get_param_value("order");
+
+    if(0 == order.compare("next-start"))
+    {
+      filter.order = JOB_ORDER_NEXT_START;
+    }
+    else if(0 != order.compare("name"))
+    {
+      error = ERROR_JOB_LIST_INVALID;
+    }
+  }
+
+  if(true == req.has_param("limit"))
+  {
+    try
+    {
+      long long value = std::stoll(req.get_param_value("limit"));
+
+      if((0 >= value) || (LIST_MAX_LIMIT < value))
+      {
+        error = ERROR_JOB_LIST_INVALID;
+      }
+      else
+      {
+        limit = (size_t)value;
+      }
+    }
+    catch(std::exception &e)
+    {
+      error = ERROR_JOB_LIST_INVALID;
+    }
+  }
+
+  return error;
+}
+
+static std::string export_chunk(std::shared_ptr<std::vector<std::string> > names, std::shared_ptr<size_t> next, uint64_t offset)
+{
+  std::string chunk;
+  size_t      count = 0;
+
+  /* jobs deleted since the export started are skipped */
+  for(; (EXPORT_CHUNK_JOBS > count) && ((*next) < names->size()); (*next)++)
+  {
+    nlohmann::json job;
+
+    if(ERROR_NO_ERROR == pDatabase->get_job_description(job,(*names)[*next]))
+    {
+      job["name"] = (*names)[*next];
+      chunk      += job.dump() + "\n";
+      count++;
+    }
+  }
+
+  return chunk;
+}
+
+static std::string output_chunk(const std::string &name, std::shared_ptr<uint64_t> run, std::shared_ptr<uint64_t> next, uint64_t offset)
+{
+  T_KIWIBES_ERROR error    = ERROR_NO_ERROR;
+  std::string     chunk;
+  bool            finished = false;
+  auto            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(OUTPUT_FOLLOW_SILENCE);
+
+  /* an empty chunk ends the response, so wait until there is output or the run is over,
+     but a silent run must not hold the worker thread forever: the client follows again
+     from the bytes it already received */
+  do
+  {
+    error = pManager->read_job_output(chunk,finished,name,*run,*next,OUTPUT_CHUNK_BYTES,OUTPUT_FOLLOW_WAIT);
+  }
+  while((ERROR_NO_ERROR == error) && (true == chunk.empty()) && (false == finished) && (std::chrono::steady_clock::now() < deadline));
+
+  return chunk;
+}
+
 static void set_return_code(httplib::Response& res, T_KIWIBES_ERROR error)
 {
   nlohmann::json description; 
@@ -612,6 +1328,14 @@ static void set_return_code(httplib::Response& res, T_KIWIBES_ERROR error)
       description["message"] = "Data key not found";
       break;
 
+    case ERROR_INVOCATION_UNKNOWN:
+      description["message"] = "Invocation not found";
+      break;
+
+    case ERROR_OUTPUT_UNKNOWN:
+      description["message"] = "Output not found";
+      break;
+
     case ERROR_DATA_STORE_FULL:
       description["message"] = "Not enough space in the data storage";
       break;
@@ -630,6 +1354,7 @@ static void set_return_code(httplib::Response& res, T_KIWIBES_ERROR error)
 
     case ERROR_JOB_DESCRIPTION_INVALID:
     case ERROR_EMPTY_REST_REQUEST:
+    case ERROR_JOB_LIST_INVALID:
       description["message"] = "Bad request";
       break; 
 
@@ -25,8 +25,8 @@
   See the respective header file for details.
 */
 #include "kiwibes_scheduler.h"
-#include "kiwibes_cron.h"
 #include "NanoLog/NanoLog.hpp"
+#include <algorithm>
 #include <chrono>
 #include <vector>
 
@@ -35,17 +35,23 @@
 
   This function implements the scheduler thread, which manages
   the execution of scheduled jobs. The function will run in a non-stop
-  loop until the exit event is received
+  loop until it is asked to exit. It sleeps until the first event
+  of the queue is due, then it re-schedules all the due jobs and starts
+  them after releasing the events queue lock.
 
   @param database   pointer to the database
   @param manager    pointer to the jobs manager
   @param qlock      the events queue lock   
+  @param qwake      condition signaled when the events queue changes
+  @param exitFlag   set to true when the thread should exit
   @param events     events queue
  */
-static void scheduler_thread(KiwibesDatabase    *database,
-                             KiwibesJobsManager *manager,
-                             std::mutex         *qlock,
-                             std::priority_queue<KiwibesSchedulerEvent *> *events);
+static void scheduler_thread(KiwibesDatabase         *database,
+                             KiwibesJobsManager      *manager,
+                             std::mutex              *qlock,
+                             std::condition_variable *qwake,
+                             bool                    *exitFlag,
+                             KiwibesSchedulerQueue   *events);
 
 /** Unsafe job schedule
 
@@ -54,26 +60,9 @@ static void scheduler_thread(KiwibesDatabase    *database,
   @param name       name of the job to schedule
   @param database   pointer to the database
   @param events     events queue
+  @param from       the job is scheduled for its first occurrence after this instant
  */
-static T_KIWIBES_ERROR unsafe_job_schedule(const std::string &name, KiwibesDatabase *database, std::priority_queue<KiwibesSchedulerEvent *> &events);
-
-/*--------------------- Modified Piority Queue -------------------------------*/
-/** Returns the underlying container of the priority queue
-    Based on the solution from here: https://stackoverflow.com/a/12886393
- */    
-template <class T, class S, class C> S& Container(std::priority_queue<T, S, C>& q)
-{
-  struct HackedQueue : private std::priority_queue<T, S, C>
-  {
-    static S& Container(std::priority_queue<T, S, C>& q)
-    {
-      return q.*&HackedQueue::c;
-    }
-  };
-  
-  return HackedQueue::Container(q);
-}
-
+static T_KIWIBES_ERROR unsafe_job_schedule(const std::string &name, KiwibesDatabase *database, KiwibesSchedulerQueue &events, std::time_t from);
 
 /*--------------- Class Implemementation --------------------------------------*/  
 KiwibesScheduler::KiwibesScheduler(KiwibesDatabase *database, KiwibesJobsManager *manager)
@@ -82,23 +71,19 @@ KiwibesScheduler::KiwibesScheduler(KiwibesDatabase *database, KiwibesJobsManager
   this->manager  = manager;
   scheduler.reset(nullptr);
   is_running = false;
+  exiting    = false;
 }
 
 KiwibesScheduler::~KiwibesScheduler()
 {
   stop();
-  
-  while(!events.empty())
-  {
-    delete events.top();
-    events.pop();
-  }
 }
 
 void KiwibesScheduler::start(void)
 {
   LOG_INFO << "starting the scheduler thread";
-  scheduler.reset(new std::thread(scheduler_thread,database,manager,&qlock,&events));
+  exiting = false;
+  scheduler.reset(new std::thread(scheduler_thread,database,manager,&qlock,&qwake,&exiting,&events));
   is_running = true;
 }
 
@@ -106,17 +91,16 @@ void KiwibesScheduler::stop(void)
 {
   if(true == is_running)
   {
-    /* push the exit event to the queue, then wait for the thread to stop */
+    /* ask the thread to exit, then wait for it to stop */
     {
       std::lock_guard<std::mutex> lock(qlock);
 
       LOG_INFO << "asking the scheduler thread to finish";
-
-      std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-      
-      events.push(new KiwibesSchedulerEvent(EVENT_EXIT_SCHEDULER,now,std::string("")));
+      exiting = true;
     }
 
+    qwake.notify_one();
+
     LOG_INFO << "waiting for the scheduler thread to finish";
     scheduler->join();
     is_running = false;
@@ -130,128 +114,155 @@ void KiwibesScheduler::stop(void)
 
 T_KIWIBES_ERROR KiwibesScheduler::schedule_job(const std::string &name)
 {
-  std::lock_guard<std::mutex> lock(qlock);
+  T_KIWIBES_ERROR error = ERROR_NO_ERROR;
+  std::time_t     now   = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+  {
+    std::lock_guard<std::mutex> lock(qlock);
   
-  return unsafe_job_schedule(name,database,events);
+    error = unsafe_job_schedule(name,database,events,now);
+  }
+
+  /* the job might be due before the event the scheduler thread is waiting for */
+  qwake.notify_one();
+
+  return error;
 }
 
-void KiwibesScheduler::unschedule_job(const std::string &name)
+T_KIWIBES_ERROR KiwibesScheduler::schedule_jobs(const std::vector<std::string> &names)
 {
-  /* go through the scheduled jobs and change the event type of
-     the events which match the job name. We do not change the
-     occurrence time because that would require a re-ordering
-     of the events in the priory queue
-   */
-  std::lock_guard<std::mutex> lock(qlock);
+  T_KIWIBES_ERROR                    error = ERROR_NO_ERROR;
+  std::time_t                        now   = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::vector<KiwibesSchedulerEvent> batch;
 
-  std::vector<KiwibesSchedulerEvent *> &vEvents = Container(events);
-
-  for(unsigned int e = 0; e < vEvents.size(); e++)
+  /* the next starts are found before taking the lock of the events queue */
+  for(size_t n = 0; n < names.size(); n++)
   {
-    if(0 == name.compare(*(vEvents[e]->job_name)))
+    std::time_t     next   = 0;
+    T_KIWIBES_ERROR status = database->get_job_next_start(next,names[n],now);
+
+    if(ERROR_NO_ERROR != status)
     {
-      vEvents[e]->type = EVENT_STOP_JOB;
+      LOG_CRIT << "cannot schedule job '" << names[n] << "'";
+      error = status;
     }
+    else
+    {
+      batch.emplace_back(EVENT_START_JOB,next,names[n]);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(qlock);
+
+    events.push_all(batch);
+    LOG_INFO << "scheduled " << batch.size() << " jobs";
   }
 
-  LOG_INFO << "unscheduled job '" << name << "'";        
+  /* some of the jobs might be due before the event the scheduler thread is waiting for */
+  qwake.notify_one();
+
+  return error;
 }
 
-void KiwibesScheduler::get_all_scheduled_job_names(std::vector<std::string> &jobs)
+void KiwibesScheduler::unschedule_job(const std::string &name)
 {
   std::lock_guard<std::mutex> lock(qlock);
-  
-  jobs.clear();
 
-  std::vector<KiwibesSchedulerEvent *> &vEvents = Container(events);
-
-  for(unsigned int e = 0; e < vEvents.size(); e++)
+  if(true == events.remove(name))
   {
-    if(EVENT_START_JOB == vEvents[e]->type)
-    {
-      jobs.push_back(std::string(*(vEvents[e]->job_name)));
-    }
+    LOG_INFO << "unscheduled job '" << name << "'";
   }
 }
+
+void KiwibesScheduler::get_all_scheduled_job_names(std::vector<std::string> &jobs)
+{
+  std::lock_guard<std::mutex> lock(qlock);
+  
+  events.get_all_job_names(jobs);
+}
 /*--------------------- Private Functions Definitions ------------------------------*/
-static void scheduler_thread(KiwibesDatabase *database, KiwibesJobsManager *manager,std::mutex *qlock,std::priority_queue<KiwibesSchedulerEvent *> *events)
+static void scheduler_thread(KiwibesDatabase *database, KiwibesJobsManager *manager, std::mutex *qlock, std::condition_variable *qwake, bool *exitFlag, KiwibesSchedulerQueue *events)
 {
-  /* run in an infinite loop until the exit event is received */
-  bool exit_event_received = false;
+  std::unique_lock<std::mutex> lock(*qlock);
 
-  while(false == exit_event_received)
+  /* run in an infinite loop until asked to exit */
+  while(false == *exitFlag)
   {
-    /* verify if the first waiting event has occurred */
-    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    /* sleep until the first event is due, or the events queue changes */
+    if(events->empty())
+    {
+      qwake->wait(lock);
+    }
+    else
+    {
+      qwake->wait_until(lock,std::chrono::system_clock::from_time_t(events->top().t0));
+    }
 
-    qlock->lock();
+    /* collect all the due jobs, and re-schedule them while the lock is taken so
+       that they can be unscheduled while they are being started. They are 
+       re-scheduled after the occurrence that fired, to prevent firing it twice.
+     */
+    std::time_t              now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::vector<std::string> due;
 
-    while((false == exit_event_received) && !(events->empty()) && (now >= events->top()->t0))
+    while((false == *exitFlag) && !(events->empty()) && (now >= events->top().t0))
     {
-      KiwibesSchedulerEvent *event = events->top();
+      std::string  name = events->top().job_name;
+      T_EVENT_TYPE type = events->top().type;
+      std::time_t  t0   = events->top().t0;
+
+      /* if the job cannot be re-scheduled, it is no longer in the queue */
+      events->pop();
 
-      switch(event->type)
+      switch(type)
       {
         case EVENT_START_JOB:
-          /* start the job, then re-schedule it again */
-          {
-            manager->start_job(*(event->job_name));
-            /* snooze a little so the job is not scheduled immediately again */
-            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
-            unsafe_job_schedule(*(event->job_name),database,*events);
-          }
-          break;
-
-        case EVENT_STOP_JOB:
-          /* nothing to do, simply ignore it */
-          LOG_INFO << "not re-scheduling job '" << *(event->job_name) << "'";
-          break;
-
-        case EVENT_EXIT_SCHEDULER:
-          LOG_INFO << "scheduler asked to stop";
-          exit_event_received = true;
+          due.push_back(name);
+          unsafe_job_schedule(name,database,*events,std::max(now,t0));
           break;
 
         default:
-          LOG_CRIT << "ignoring unknown event type: " << event->type;
+          LOG_CRIT << "ignoring unknown event type: " << type;
           break;
       }
-
-      events->pop();
-      delete event;
     }
 
-    qlock->unlock();
+    /* start the due jobs without holding the lock */
+    if(0 < due.size())
+    {
+      lock.unlock();
 
-    /* snooze a little to give the main thread a change at inserting events in the queue */
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      for(unsigned int j = 0; j < due.size(); j++)
+      {
+        manager->start_job(due[j]);
+      }
+
+      lock.lock();
+    }
   }
+
+  LOG_INFO << "scheduler asked to stop";
 }
 
-static T_KIWIBES_ERROR unsafe_job_schedule(const std::string &name, KiwibesDatabase *database, std::priority_queue<KiwibesSchedulerEvent *> &events)
+static T_KIWIBES_ERROR unsafe_job_schedule(const std::string &name, KiwibesDatabase *database, KiwibesSchedulerQueue &events, std::time_t from)
 {
-  nlohmann::json  job;
-  T_KIWIBES_ERROR error = database->get_job_description(job,name);
+  std::time_t     next  = 0;
+  T_KIWIBES_ERROR error = database->get_job_next_start(next,name,from);
 
-  if(ERROR_NO_ERROR != error)
+  if(ERROR_JOB_NAME_UNKNOWN == error)
   {
     LOG_CRIT << "cannot find a job with name '" << name << "'";
   } 
+  else if(ERROR_NO_ERROR != error)
+  {
+    LOG_CRIT << "job '" << name << "' has an invalid schedule";
+  }
   else
   {
-    KiwibesCron cron(job["schedule"].get<std::string>());
-
-    if(false == cron.is_valid())
-    {
-      LOG_CRIT << "job '" << name << "' has an invalid schedule";
-      error = ERROR_JOB_SCHEDULE_INVALID;
-    }
-    else
-    {
-      events.push(new KiwibesSchedulerEvent(EVENT_START_JOB,cron.next(),name));
-      LOG_INFO << "scheduled job '" << name << "'";     
-    }
+    events.push(EVENT_START_JOB,next,name);
+    LOG_INFO << "scheduled job '" << name << "'";     
   }
 
   return error; 
-}
\ No newline at end of file
+}
@@ -24,17 +24,19 @@
 
   This class implements the job scheduler, wich runs jobs periodically.
   It can also run jobs upon request, as well as stopping them at any
-  point in time.
+  point in time. The scheduler thread sleeps until the next event is 
+  due, or until it is woken up by a change to the events queue.
 */
 #ifndef __KIWIBES_SCHEDULER_H__
 #define __KIWIBES_SCHEDULER_H__
 
 #include "kiwibes_database.h"
 #include "kiwibes_jobs_manager.h"
-#include "kiwibes_scheduler_event.h"
-#include <queue>
+#include "kiwibes_scheduler_queue.h"
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <condition_variable>
 #include <map>
 #include <vector>
 
@@ -62,11 +64,22 @@ public:
   
   /** Schedule a job to run periodically
 
+    If the job is already scheduled, its next occurrence is updated.
+
     @param name   name of the job
     @return ERROR_NO_ERROR if successfull, error code otherwise
    */
   T_KIWIBES_ERROR schedule_job(const std::string &name);
 
+  /** Schedule many jobs to run periodically, adding them to the events queue at once
+
+    Jobs that cannot be scheduled are skipped.
+
+    @param names  names of the jobs
+    @return ERROR_NO_ERROR if all jobs were scheduled, error code of the last failure otherwise
+   */
+  T_KIWIBES_ERROR schedule_jobs(const std::vector<std::string> &names);
+
   /** Stop a job from running periodically.
 
     @param name   name of the job
@@ -83,9 +96,11 @@ private:
   KiwibesDatabase              *database;                 /* private pointer to the database */
   KiwibesJobsManager           *manager;                  /* private pointer to the jobs manager */
   bool                         is_running;                /* set to true if the scheduler thread is running */
+  bool                         exiting;                   /* set to true when the scheduler thread should exit */
   std::mutex                   qlock;                     /* synchronize access to the event queue */
+  std::condition_variable      qwake;                     /* wakes up the scheduler thread when the queue changes */
   std::unique_ptr<std::thread> scheduler;                 /* the scheduler thread */
-  std::priority_queue<KiwibesSchedulerEvent *> events;    /* event queue */
+  KiwibesSchedulerQueue        events;                    /* event queue, one event per scheduled job */
 };
 
 #endif
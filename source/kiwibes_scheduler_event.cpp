@@ -27,19 +27,13 @@
 #include "kiwibes_scheduler_event.h"
 #include "NanoLog/NanoLog.hpp"
 
-KiwibesSchedulerEvent::KiwibesSchedulerEvent(T_EVENT_TYPE type, std::time_t t0, const std::string &job_name)
+KiwibesSchedulerEvent::KiwibesSchedulerEvent(T_EVENT_TYPE type, std::time_t t0, const std::string &job_name) : job_name(job_name)
 {
   this->type = type;
   this->t0   = t0;
-  this->job_name = new std::string(job_name);
 }
 
-KiwibesSchedulerEvent::~KiwibesSchedulerEvent()
-{
-  delete job_name;
-}
-
-bool KiwibesSchedulerEvent::operator<(const KiwibesSchedulerEvent &rhs)
+bool KiwibesSchedulerEvent::operator<(const KiwibesSchedulerEvent &rhs) const
 {
   return (t0 < rhs.t0); 
 }
@@ -34,8 +34,6 @@
  */
 typedef enum { 
   EVENT_START_JOB,        /* start a job and re-schedule it again */
-  EVENT_STOP_JOB,         /* do not start the job and do not schedule it again */
-  EVENT_EXIT_SCHEDULER,   /* exit from the scheduler thread */
 } T_EVENT_TYPE;
 
 
@@ -50,10 +48,6 @@ public:
    */
   KiwibesSchedulerEvent(T_EVENT_TYPE type, std::time_t t0, const std::string &job_name);    
 
-  /** Class destructor
-   */
-  ~KiwibesSchedulerEvent();    
-
  /** Ordering for events
 
   This operator is used to order events in the event queue.
@@ -61,12 +55,12 @@ public:
   @param rhs  the event to compare against
   @return true if this event occurs first, false otherwise
   */
-  bool operator<(const KiwibesSchedulerEvent &rhs);
+  bool operator<(const KiwibesSchedulerEvent &rhs) const;
 
 public:
  T_EVENT_TYPE type;        /* type of event */
  std::time_t  t0;          /* instant in the future when the event occurs */   
- std::string  *job_name;   /* name of the job */   
+ std::string  job_name;    /* name of the job */   
 };
 
 #endif
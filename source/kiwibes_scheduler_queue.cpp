@@ -0,0 +1,253 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_scheduler_queue.h"
+#include <algorithm>
+#include <utility>
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Number of children of each node of the heap
+ */
+#define HEAP_ARITY  (4)
+
+/*--------------- Class Implemementation --------------------------------------*/  
+KiwibesSchedulerQueue::KiwibesSchedulerQueue()
+{
+}
+
+void KiwibesSchedulerQueue::push(T_EVENT_TYPE type, std::time_t t0, const std::string &job_name)
+{
+  std::unordered_map<std::string,size_t>::iterator iter = index.find(job_name);
+
+  if(index.end() == iter)
+  {
+    /* new job, add its event at the bottom of the heap */
+    heap.emplace_back(type,t0,job_name);
+    index[job_name] = heap.size() - 1;
+    sift_up(heap.size() - 1);
+  }
+  else
+  {
+    /* the job has an event already, move it to its new position */
+    size_t      pos = iter->second;
+    std::time_t old = heap[pos].t0;
+
+    heap[pos].type = type;
+    heap[pos].t0   = t0;
+
+    if(t0 < old)
+    {
+      sift_up(pos);
+    }
+    else
+    {
+      sift_down(pos);
+    }
+  }
+}
+
+void KiwibesSchedulerQueue::push_all(const std::vector<KiwibesSchedulerEvent> &batch)
+{
+  size_t first = heap.size();
+
+  /* the jobs that have an event already are moved while the heap is still ordered */
+  for(size_t e = 0; e < batch.size(); e++)
+  {
+    if(index.end() != index.find(batch[e].job_name))
+    {
+      push(batch[e].type,batch[e].t0,batch[e].job_name);
+    }
+  }
+
+  /* the new jobs are added at the bottom of the heap, without ordering it */
+  for(size_t e = 0; e < batch.size(); e++)
+  {
+    std::unordered_map<std::string,size_t>::iterator iter = index.find(batch[e].job_name);
+
+    if(index.end() == iter)
+    {
+      heap.push_back(batch[e]);
+      index[batch[e].job_name] = heap.size() - 1;
+    }
+    else if(first <= iter->second)
+    {
+      /* the same job appears more than once in the batch, the last event wins */
+      heap[iter->second].type = batch[e].type;
+      heap[iter->second].t0   = batch[e].t0;
+    }
+  }
+
+  if(HEAP_ARITY*(heap.size() - first) >= heap.size())
+  {
+    /* rebuild the heap, from the last parent up to the root */
+    for(size_t pos = (heap.size() + HEAP_ARITY - 2)/HEAP_ARITY; 0 < pos; pos--)
+    {
+      sift_down(pos - 1);
+    }
+  }
+  else
+  {
+    for(size_t pos = first; pos < heap.size(); pos++)
+    {
+      sift_up(pos);
+    }
+  }
+}
+
+const KiwibesSchedulerEvent &KiwibesSchedulerQueue::top(void) const
+{
+  return heap[0];
+}
+
+void KiwibesSchedulerQueue::pop(void)
+{
+  remove_at(0);
+}
+
+bool KiwibesSchedulerQueue::remove(const std::string &job_name)
+{
+  bool success = false;
+  std::unordered_map<std::string,size_t>::iterator iter = index.find(job_name);
+
+  if(index.end() != iter)
+  {
+    remove_at(iter->second);
+    success = true;
+  }
+
+  return success;
+}
+
+bool KiwibesSchedulerQueue::contains(const std::string &job_name) const
+{
+  return (0 < index.count(job_name));
+}
+
+bool KiwibesSchedulerQueue::empty(void) const
+{
+  return heap.empty();
+}
+
+size_t KiwibesSchedulerQueue::size(void) const
+{
+  return heap.size();
+}
+
+void KiwibesSchedulerQueue::get_all_job_names(std::vector<std::string> &jobs) const
+{
+  jobs.clear();
+
+  for(size_t e = 0; e < heap.size(); e++)
+  {
+    jobs.push_back(heap[e].job_name);
+  }
+}
+
+void KiwibesSchedulerQueue::sift_up(size_t pos)
+{
+  KiwibesSchedulerEvent event(std::move(heap[pos]));
+
+  while(0 < pos)
+  {
+    size_t parent = (pos - 1)/HEAP_ARITY;
+
+    if(false == (event < heap[parent]))
+    {
+      break;
+    }
+
+    place(pos,std::move(heap[parent]));
+    pos = parent;
+  }
+
+  place(pos,std::move(event));
+}
+
+void KiwibesSchedulerQueue::sift_down(size_t pos)
+{
+  KiwibesSchedulerEvent event(std::move(heap[pos]));
+
+  while(true)
+  {
+    /* find the earliest of the children */
+    size_t first = HEAP_ARITY*pos + 1;
+    size_t last  = std::min(first + HEAP_ARITY,heap.size());
+    size_t child = pos;
+    const KiwibesSchedulerEvent *earliest = &event;
+
+    for(size_t c = first; c < last; c++)
+    {
+      if(heap[c] < *earliest)
+      {
+        child    = c;
+        earliest = &(heap[c]);
+      }
+    }
+
+    if(child == pos)
+    {
+      break;
+    }
+
+    place(pos,std::move(heap[child]));
+    pos = child;
+  }
+
+  place(pos,std::move(event));
+}
+
+void KiwibesSchedulerQueue::remove_at(size_t pos)
+{
+  index.erase(heap[pos].job_name);
+
+  /* move the last event to the free position, then restore the heap order */
+  if(pos + 1 < heap.size())
+  {
+    std::time_t old = heap[pos].t0;
+
+    place(pos,std::move(heap.back()));
+    heap.pop_back();
+
+    if(heap[pos].t0 < old)
+    {
+      sift_up(pos);
+    }
+    else
+    {
+      sift_down(pos);
+    }
+  }
+  else
+  {
+    heap.pop_back();
+  }
+}
+
+void KiwibesSchedulerQueue::place(size_t pos, KiwibesSchedulerEvent &&event)
+{
+  heap[pos] = std::move(event);
+  index[heap[pos].job_name] = pos;
+}
@@ -0,0 +1,134 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  This class implements the events queue of the scheduler. It is a 
+  4-ary min-heap ordered by the event instant, indexed by job name. 
+  There is at most one event per job, which can be moved or removed
+  in O(log n), so the size of the queue is bounded by the number of
+  scheduled jobs. The events are stored by value in a contiguous array.
+  The queue is not synchronized, the owner must lock it.
+*/
+#ifndef __KIWIBES_SCHEDULER_QUEUE_H__
+#define __KIWIBES_SCHEDULER_QUEUE_H__
+
+#include "kiwibes_scheduler_event.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class KiwibesSchedulerQueue {
+
+public:
+  /** Class constructor
+   */
+  KiwibesSchedulerQueue();
+
+  /** Add the event for the given job to the queue
+
+    If the job already has an event in the queue, it is replaced.
+
+    @param type       the type of event 
+    @param t0         the instant when the event occurs
+    @param job_name   the name of the job
+   */
+  void push(T_EVENT_TYPE type, std::time_t t0, const std::string &job_name);
+
+  /** Add the events of many jobs to the queue
+
+    Events of jobs already in the queue replace their current events. When 
+    the new events are many compared to the size of the queue, the heap is 
+    rebuilt in linear time instead of adding them one by one.
+
+    @param batch  the events
+   */
+  void push_all(const std::vector<KiwibesSchedulerEvent> &batch);
+
+  /** Return the earliest event. The queue must not be empty.
+   */
+  const KiwibesSchedulerEvent &top(void) const;
+
+  /** Remove the earliest event. The queue must not be empty.
+   */
+  void pop(void);
+
+  /** Remove the event of the given job
+
+    @param job_name   the name of the job
+    @return true if the job had an event in the queue, false otherwise
+   */
+  bool remove(const std::string &job_name);
+
+  /** Return true if the given job has an event in the queue
+
+    @param job_name   the name of the job
+   */
+  bool contains(const std::string &job_name) const;
+
+  /** Return true if the queue is empty
+   */
+  bool empty(void) const;
+
+  /** Return the number of events in the queue
+   */
+  size_t size(void) const;
+
+  /** Return the names of all the jobs with events in the queue
+
+    @param jobs   on return contains the names of the jobs
+   */
+  void get_all_job_names(std::vector<std::string> &jobs) const;
+
+private:
+  /** Move the event at the given position up, until the heap is ordered
+
+    @param pos  the position of the event in the heap
+   */
+  void sift_up(size_t pos);
+
+  /** Move the event at the given position down, until the heap is ordered
+
+    @param pos  the position of the event in the heap
+   */
+  void sift_down(size_t pos);
+
+  /** Remove the event at the given position
+
+    @param pos  the position of the event in the heap
+   */
+  void remove_at(size_t pos);
+
+  /** Move the event to the given position, updating the index
+
+    @param pos    the position in the heap
+    @param event  the event
+   */
+  void place(size_t pos, KiwibesSchedulerEvent &&event);
+
+private:
+  std::vector<KiwibesSchedulerEvent>      heap;    /* the events, ordered as a 4-ary heap */
+  std::unordered_map<std::string, size_t> index;   /* position in the heap of the event of each job */
+};
+
+#endif
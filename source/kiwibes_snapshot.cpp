@@ -0,0 +1,430 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  See the respective header file for details.
+*/
+#include "kiwibes_snapshot.h"
+
+#include "NanoLog/NanoLog.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #error "OS not supported"
+#endif
+
+/*----------------- Private Data Definitions -----------------------------------*/
+/** Identifies a binary snapshot file
+ */
+#define SNAPSHOT_MAGIC      "KIWIBSNP"
+
+/** Version of the snapshot layout, increased whenever it changes
+ */
+#define SNAPSHOT_VERSION    (5)
+
+/** Written as a 32-bit integer, to detect snapshots from hosts with another byte order
+ */
+#define SNAPSHOT_ENDIANESS  (0x01020304)
+
+/** Header of the snapshot
+ */
+typedef struct {
+  char     magic[8];        /* always SNAPSHOT_MAGIC */
+  uint32_t version;         /* always SNAPSHOT_VERSION */
+  uint32_t endianess;       /* always SNAPSHOT_ENDIANESS */
+  uint64_t checksum;        /* FNV-1a hash of everything after this field */
+  uint64_t source_hash;     /* hash of the contents of the JSON file */
+  int64_t  source_mtime;    /* modification time of the JSON file, in nanoseconds */
+  uint64_t source_size;     /* size of the JSON file, in bytes */
+  uint64_t size;            /* size of the snapshot, in bytes */
+  uint64_t njobs;           /* number of job records */
+  uint64_t nargs;           /* number of program arguments */
+  uint64_t nbins;           /* number of bins of the runtime sketches */
+  uint64_t nruns;           /* number of runs in the histories */
+  uint64_t strings;         /* offset of the strings table */
+} T_SNAPSHOT_HEADER;
+
+/** A string, in the strings table
+ */
+typedef struct {
+  uint32_t offset;          /* offset from the start of the strings table */
+  uint32_t length;          /* length of the string, in bytes */
+} T_SNAPSHOT_STRING;
+
+/** A bin of a runtime sketch
+ */
+typedef struct {
+  int64_t  index;           /* index of the bin */
+  uint64_t count;           /* number of runtimes in the bin */
+} T_SNAPSHOT_BIN;
+
+/** A job, as stored in the snapshot. The fields which are reset when
+    the database is loaded (status, start instant, pending starts) are
+    not stored.
+ */
+typedef struct {
+  T_SNAPSHOT_STRING name;          /* the name of the job */
+  T_SNAPSHOT_STRING schedule;      /* the schedule of the job */
+  T_SNAPSHOT_STRING extra;         /* JSON text of the unknown fields, empty if there are none */
+  uint32_t          program;       /* index of the first argument of the program */
+  uint32_t          nprogram;      /* number of arguments of the program */
+  uint32_t          bins;          /* index of the first bin of the runtime sketch */
+  uint32_t          nbins;         /* number of bins of the runtime sketch */
+  uint32_t          runs;          /* index of the oldest run in the history */
+  uint32_t          nruns;         /* number of runs in the history */
+  uint64_t          zeros;         /* runtimes of the sketch too short to be placed in a bin */
+  int64_t           max_runtime;   /* maximum runtime of the job, in seconds */
+  uint32_t          max_parallel;  /* maximum number of instances of the job running at once */
+  int32_t           priority;      /* priority of the start requests of the job */
+  uint32_t          max_memory;    /* maximum memory of each instance of the job, in MB */
+  uint32_t          max_cpu;       /* maximum CPU of each instance of the job, in percent of a CPU */
+  double            avg_runtime;   /* average runtime of the job, in seconds */
+  double            var_runtime;   /* running sum of squares of the runtime differences */
+  uint64_t          nbr_runs;      /* number of times the job has run */
+  uint64_t          nbr_timeouts;  /* number of runs stopped for exceeding the maximum runtime */
+} T_SNAPSHOT_JOB;
+
+static_assert(0 == (sizeof(T_SNAPSHOT_HEADER) % 8),"the snapshot header must keep the records aligned");
+static_assert(0 == (sizeof(T_SNAPSHOT_JOB) % 8),"the snapshot job records must keep the next records aligned");
+static_assert(0 == (sizeof(T_JOB_RUN) % 8),"the snapshot runs must keep the next records aligned");
+
+/*----------------- Private Functions Declarations -----------------------------*/
+/** Add a string to the strings table
+
+  @param strings  the strings table
+  @param value    the string to add
+  @return the location of the string in the table
+ */
+static T_SNAPSHOT_STRING add_string(std::string &strings, const std::string &value);
+
+/** Return the 64-bit FNV-1a hash of a block of memory
+
+  @param data   the start of the block
+  @param size   the size of the block, in bytes
+ */
+static uint64_t block_hash(const char *data, size_t size);
+
+/** Decode the jobs of a snapshot
+
+  @param data     the contents of the snapshot
+  @param size     the size of the snapshot, in bytes
+  @param source   the modification time and size of the JSON file, on return also 
+                  contains the hash of its contents
+  @param jobs     on return, contains the job records
+  @return true if successfull, false otherwise
+ */
+static bool decode_jobs(const char *data, size_t size, T_SNAPSHOT_SOURCE &source, std::vector<T_JOB_RECORD> &jobs);
+
+/*----------------- Public Functions Definitions -------------------------------*/
+void snapshot_encode(const std::vector<const T_JOB_RECORD *> &jobs, std::string &snapshot)
+{
+  T_SNAPSHOT_HEADER              header;
+  std::vector<T_SNAPSHOT_JOB>    records(jobs.size());
+  std::vector<T_SNAPSHOT_STRING> args;
+  std::vector<T_SNAPSHOT_BIN>    bins;
+  std::vector<T_JOB_RUN>         runs;
+  std::string                    strings;
+
+  for(size_t j = 0; j < jobs.size(); j++)
+  {
+    memset(&records[j],0,sizeof(T_SNAPSHOT_JOB));
+
+    records[j].name         = add_string(strings,jobs[j]->name);
+    records[j].schedule     = add_string(strings,jobs[j]->schedule);
+    records[j].program      = args.size();
+    records[j].nprogram     = jobs[j]->program.size();
+    records[j].max_runtime  = jobs[j]->max_runtime;
+    records[j].max_parallel = jobs[j]->max_parallel;
+    records[j].priority     = jobs[j]->priority;
+    records[j].max_memory   = jobs[j]->max_memory;
+    records[j].max_cpu      = jobs[j]->max_cpu;
+    records[j].avg_runtime  = jobs[j]->avg_runtime;
+    records[j].var_runtime  = jobs[j]->var_runtime;
+    records[j].nbr_runs     = jobs[j]->nbr_runs;
+    records[j].nbr_timeouts = jobs[j]->nbr_timeouts;
+
+    if((true == jobs[j]->extra.is_object()) && (0 < jobs[j]->extra.size()))
+    {
+      records[j].extra = add_string(strings,jobs[j]->extra.dump());
+    }
+
+    for(size_t a = 0; a < jobs[j]->program.size(); a++)
+    {
+      args.push_back(add_string(strings,jobs[j]->program[a]));
+    }
+
+    /* the runs are stored oldest first */
+    records[j].bins  = bins.size();
+    records[j].nbins = jobs[j]->sketch.bins().size();
+    records[j].zeros = jobs[j]->sketch.zeros();
+    records[j].runs  = runs.size();
+    records[j].nruns = jobs[j]->runs.size();
+
+    for(std::map<int32_t,uint64_t>::const_iterator b = jobs[j]->sketch.bins().begin(); b != jobs[j]->sketch.bins().end(); b++)
+    {
+      T_SNAPSHOT_BIN bin = { b->first, b->second };
+      bins.push_back(bin);
+    }
+
+    for(size_t r = 0; r < jobs[j]->runs.size(); r++)
+    {
+      runs.push_back(jobs[j]->runs.at(r));
+    }
+  }
+
+  memset(&header,0,sizeof(T_SNAPSHOT_HEADER));
+  memcpy(header.magic,SNAPSHOT_MAGIC,sizeof(header.magic));
+  header.version   = SNAPSHOT_VERSION;
+  header.endianess = SNAPSHOT_ENDIANESS;
+  header.njobs     = records.size();
+  header.nargs     = args.size();
+  header.nbins     = bins.size();
+  header.nruns     = runs.size();
+  header.strings   = sizeof(T_SNAPSHOT_HEADER) + records.size()*sizeof(T_SNAPSHOT_JOB) + args.size()*sizeof(T_SNAPSHOT_STRING) +
+                     bins.size()*sizeof(T_SNAPSHOT_BIN) + runs.size()*sizeof(T_JOB_RUN);
+  header.size      = header.strings + strings.size();
+
+  snapshot.clear();
+  snapshot.reserve(header.size);
+  snapshot.append((const char *)&header,sizeof(T_SNAPSHOT_HEADER));
+  snapshot.append((const char *)records.data(),records.size()*sizeof(T_SNAPSHOT_JOB));
+  snapshot.append((const char *)args.data(),args.size()*sizeof(T_SNAPSHOT_STRING));
+  snapshot.append((const char *)bins.data(),bins.size()*sizeof(T_SNAPSHOT_BIN));
+  snapshot.append((const char *)runs.data(),runs.size()*sizeof(T_JOB_RUN));
+  snapshot.append(strings);
+}
+
+void snapshot_seal(std::string &snapshot, const T_SNAPSHOT_SOURCE &source)
+{
+  T_SNAPSHOT_HEADER header;
+  size_t            start = offsetof(T_SNAPSHOT_HEADER,source_hash);
+
+  memcpy(&header,snapshot.data(),sizeof(T_SNAPSHOT_HEADER));
+  header.source_hash  = source.hash;
+  header.source_mtime = source.mtime;
+  header.source_size  = source.size;
+  memcpy(&snapshot[0],&header,sizeof(T_SNAPSHOT_HEADER));
+
+  header.checksum = block_hash(snapshot.data() + start,snapshot.size() - start);
+  memcpy(&snapshot[0],&header,sizeof(T_SNAPSHOT_HEADER));
+}
+
+bool snapshot_load(const std::string &fname, T_SNAPSHOT_SOURCE &source, std::vector<T_JOB_RECORD> &jobs)
+{
+  bool        success = false;
+  int         fd      = open(fname.c_str(),O_RDONLY | O_CLOEXEC);
+  struct stat info;
+
+  if((0 <= fd) && (0 == fstat(fd,&info)) && (sizeof(T_SNAPSHOT_HEADER) <= (size_t)info.st_size))
+  {
+    void *data = mmap(nullptr,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+
+    if(MAP_FAILED == data)
+    {
+      LOG_WARN << "failed to map the binary snapshot: " << fname;
+    }
+    else
+    {
+      madvise(data,info.st_size,MADV_SEQUENTIAL);
+      success = decode_jobs((const char *)data,info.st_size,source,jobs);
+      munmap(data,info.st_size);
+    }
+  }
+
+  if(0 <= fd)
+  {
+    close(fd);
+  }
+
+  if(false == success)
+  {
+    jobs.clear();
+  }
+
+  return success;
+}
+
+/*----------------- Private Functions Definitions -------------------------------*/
+static T_SNAPSHOT_STRING add_string(std::string &strings, const std::string &value)
+{
+  T_SNAPSHOT_STRING location;
+
+  location.offset = strings.size();
+  location.length = value.size();
+  strings.append(value);
+
+  return location;
+}
+
+static uint64_t block_hash(const char *data, size_t size)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  for(size_t c = 0; c < size; c++)
+  {
+    hash ^= (uint8_t)data[c];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+static bool decode_jobs(const char *data, size_t size, T_SNAPSHOT_SOURCE &source, std::vector<T_JOB_RECORD> &jobs)
+{
+  T_SNAPSHOT_HEADER header;
+  bool              valid = false;
+
+  memcpy(&header,data,sizeof(T_SNAPSHOT_HEADER));
+
+  /* the snapshot must be complete, and a copy of the current JSON file */
+  if((0 != memcmp(header.magic,SNAPSHOT_MAGIC,sizeof(header.magic))) ||
+     (SNAPSHOT_VERSION != header.version) || (SNAPSHOT_ENDIANESS != header.endianess))
+  {
+    LOG_WARN << "unknown binary snapshot format";
+  }
+  else if((source.mtime != header.source_mtime) || (source.size != header.source_size))
+  {
+    LOG_INFO << "the binary snapshot is not a copy of the JSON file";
+  }
+  else if((size != header.size) || (header.strings > size) ||
+          (header.strings != (sizeof(T_SNAPSHOT_HEADER) + header.njobs*sizeof(T_SNAPSHOT_JOB) + header.nargs*sizeof(T_SNAPSHOT_STRING) +
+                              header.nbins*sizeof(T_SNAPSHOT_BIN) + header.nruns*sizeof(T_JOB_RUN))))
+  {
+    LOG_WARN << "the binary snapshot has an invalid size";
+  }
+  else if(header.checksum != block_hash(data + offsetof(T_SNAPSHOT_HEADER,source_hash),size - offsetof(T_SNAPSHOT_HEADER,source_hash)))
+  {
+    LOG_WARN << "the binary snapshot is corrupted";
+  }
+  else
+  {
+    const T_SNAPSHOT_JOB    *records = (const T_SNAPSHOT_JOB *)(data + sizeof(T_SNAPSHOT_HEADER));
+    const T_SNAPSHOT_STRING *args    = (const T_SNAPSHOT_STRING *)(data + sizeof(T_SNAPSHOT_HEADER) + header.njobs*sizeof(T_SNAPSHOT_JOB));
+    const T_SNAPSHOT_BIN    *bins    = (const T_SNAPSHOT_BIN *)(args + header.nargs);
+    const T_JOB_RUN         *runs    = (const T_JOB_RUN *)(bins + header.nbins);
+    const char              *strings = data + header.strings;
+    uint64_t                 nchars  = size - header.strings;
+
+    /* the records are decoded eagerly: the database replays the journal over them, then
+       moves every job to its shard and indexes it, so a lazy decode would not save any work
+     */
+    valid = true;
+    jobs.clear();
+    jobs.reserve(header.njobs);
+
+    for(uint64_t j = 0; (true == valid) && (j < header.njobs); j++)
+    {
+      const T_SNAPSHOT_JOB *record = &records[j];
+
+      valid = ((uint64_t)record->name.offset + record->name.length <= nchars) &&
+              ((uint64_t)record->schedule.offset + record->schedule.length <= nchars) &&
+              ((uint64_t)record->extra.offset + record->extra.length <= nchars) &&
+              ((uint64_t)record->program + record->nprogram <= header.nargs) &&
+              ((uint64_t)record->bins + record->nbins <= header.nbins) &&
+              ((uint64_t)record->runs + record->nruns <= header.nruns);
+
+      for(uint32_t a = 0; (true == valid) && (a < record->nprogram); a++)
+      {
+        valid = ((uint64_t)args[record->program + a].offset + args[record->program + a].length <= nchars);
+      }
+
+      if(true == valid)
+      {
+        T_JOB_RECORD job;
+
+        job.name.assign(strings + record->name.offset,record->name.length);
+        job.schedule.assign(strings + record->schedule.offset,record->schedule.length);
+        job.program.reserve(record->nprogram);
+        for(uint32_t a = 0; a < record->nprogram; a++)
+        {
+          job.program.emplace_back(strings + args[record->program + a].offset,args[record->program + a].length);
+        }
+
+        job.max_runtime   = record->max_runtime;
+        job.max_parallel  = std::max((uint32_t)1,record->max_parallel);
+        job.priority      = record->priority;
+        job.max_memory    = record->max_memory;
+        job.max_cpu       = record->max_cpu;
+        job.avg_runtime   = record->avg_runtime;
+        job.var_runtime   = record->var_runtime;
+        job.nbr_runs      = record->nbr_runs;
+        job.nbr_timeouts  = record->nbr_timeouts;
+        /* deliberate: no job is running when the database is loaded, so the
+           runtime state is reset the same way as when the JSON file is loaded
+         */
+        job.status        = JOB_STATUS_STOPPED;
+        job.start_time    = 0;
+        job.pending_start = 0;
+        job.start_instant = 0;
+        job.instances     = 0;
+        job.extra         = nlohmann::json::object();
+
+        std::map<int32_t,uint64_t> sketch;
+        for(uint32_t b = 0; b < record->nbins; b++)
+        {
+          sketch[(int32_t)bins[record->bins + b].index] += bins[record->bins + b].count;
+        }
+        job.sketch.restore(record->zeros,sketch);
+
+        for(uint32_t r = 0; r < record->nruns; r++)
+        {
+          job.runs.add(runs[record->runs + r]);
+        }
+
+        /* the unknown fields are seldom used, only parse them when there are any */
+        if(0 < record->extra.length)
+        {
+          try
+          {
+            job.extra = nlohmann::json::parse(std::string(strings + record->extra.offset,record->extra.length));
+          }
+          catch(nlohmann::detail::exception &e)
+          {
+            valid = false;
+          }
+        }
+
+        jobs.push_back(std::move(job));
+      }
+    }
+
+    if(false == valid)
+    {
+      LOG_WARN << "the binary snapshot has an invalid job record";
+    }
+    else
+    {
+      source.hash = header.source_hash;
+    }
+  }
+
+  return valid;
+}
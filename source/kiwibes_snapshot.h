@@ -0,0 +1,88 @@
+/**
+  Kiwibes Automation Server
+  =========================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+
+  Binary snapshot of the jobs database, so that large databases load
+  without parsing JSON. The snapshot is a copy of a given JSON file,
+  and it is only used if that file has not changed since. Its layout is:
+
+    - a fixed size header, with the version, a checksum of the rest of
+      the file and the hash, modification time and size of the JSON file
+    - the job records, each with a fixed size
+    - the arguments of the programs, as (offset, length) pairs
+    - the bins of the runtime sketches, and the runs of the jobs
+    - a table with all the strings
+
+  The file is mapped to memory and the jobs are decoded straight from it.
+  The fields of a job which are unknown to the server are kept as JSON
+  text, which is only parsed when it is not empty.
+*/
+#ifndef __KIWIBES_SNAPSHOT_H__
+#define __KIWIBES_SNAPSHOT_H__
+
+#include "kiwibes_database.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*-------------------------- Public Data Definitions -------------------------------*/
+/** The JSON file a binary snapshot is a copy of
+ */
+typedef struct {
+  uint64_t hash;      /* hash of the contents of the JSON file */
+  int64_t  mtime;     /* modification time of the JSON file, in nanoseconds */
+  uint64_t size;      /* size of the JSON file, in bytes */
+} T_SNAPSHOT_SOURCE;
+
+/*-------------------------- Public Function Declarations -------------------------------*/
+/** Encode the jobs in the binary snapshot format
+
+  The snapshot must be sealed before it is written to file.
+
+  @param jobs       pointers to the job records
+  @param snapshot   on return, contains the encoded snapshot
+ */
+void snapshot_encode(const std::vector<const T_JOB_RECORD *> &jobs, std::string &snapshot);
+
+/** Seal an encoded snapshot, by setting the JSON file it is a copy of and its checksum
+
+  @param snapshot   the encoded snapshot
+  @param source     the JSON file the snapshot is a copy of
+ */
+void snapshot_seal(std::string &snapshot, const T_SNAPSHOT_SOURCE &source);
+
+/** Load the jobs from a binary snapshot file
+
+  The JSON file is not read, the snapshot is a copy of it if both its modification 
+  time and size match the ones the snapshot was sealed with.
+
+  @param fname    the path to the binary snapshot
+  @param source   the modification time and size of the JSON file, on return also 
+                  contains the hash of its contents
+  @param jobs     on return, contains the job records
+  @return true if the snapshot is valid and a copy of the JSON file, false otherwise
+ */
+bool snapshot_load(const std::string &fname, T_SNAPSHOT_SOURCE &source, std::vector<T_JOB_RECORD> &jobs);
+
+#endif
@@ -245,6 +245,9 @@ static T_KIWIBES_ERROR initialize_kiwibes(T_CMD_LINE_OPTIONS &options)
   LOG_INFO << "loading the Kiwibes jobs database from: " << jobs_db_file;
 
   database = new KiwibesDatabase;
+  database->set_journal_sync((1 == options.journal_sync) ? JOURNAL_SYNC_ALWAYS : JOURNAL_SYNC_NONE);
+  database->set_binary_snapshot(1 == options.binary_snapshot);
+  database->set_group_commit(options.group_commit);
   error = database->load(jobs_db_file);
 
   if(ERROR_NO_ERROR != error)
@@ -257,6 +260,13 @@ static T_KIWIBES_ERROR initialize_kiwibes(T_CMD_LINE_OPTIONS &options)
     /* create the other components */
     data_store     = new KiwibesDataStore(options.data_store_size);
     jobs_manager   = new KiwibesJobsManager(database);
+    jobs_manager->set_max_running(options.max_running);
+
+    if(1 == options.job_output)
+    {
+      jobs_manager->set_output_folder(*(options.home) + std::string("output/"));
+    }
+
     jobs_scheduler = new KiwibesScheduler(database,jobs_manager);
     authentication = new KiwibesAuthentication(authentication_file);
     https          = new httplib::SSLServer(server_certificate.c_str(),server_priv_key.c_str());
@@ -60,17 +60,23 @@ def test_start_and_stop_jobs():
 	server = kiwibes.KiwibesServer("python-client-token",verify_cert=False)
 	
 	# attempt to start or stop a job that does not exist
-	assert server.ERROR_JOB_NAME_UNKNOWN == server.start_job("jobby")
+	assert None == server.start_job("jobby")
 	assert server.ERROR_JOB_NAME_UNKNOWN == server.stop_job("jobby")
+	assert None == server.get_invocation(123456789)
 
 	# cannot stop a job that is not running
 	assert server.ERROR_JOB_IS_NOT_RUNNING == server.stop_job("sleep_10")
 
 	# can start a job that is already running, it will be queue
-	assert server.ERROR_NO_ERROR == server.start_job("sleep_10")
-	assert server.ERROR_NO_ERROR == server.start_job("sleep_10")
-	assert server.ERROR_NO_ERROR == server.start_job("sleep_10")
-	assert server.ERROR_NO_ERROR == server.start_job("sleep_10")
+	invocations = [server.start_job("sleep_10") for i in range(4)]
+	assert None not in invocations
+
+	# the starts are handled in order, once the last is handled all the others are
+	invocation = server.get_invocation(invocations[-1],wait=5000)
+	assert invocations[-1] == invocation["invocation"]
+	assert "sleep_10" == invocation["job"]
+	assert "pending" == invocation["status"]
+	assert "started" == server.get_invocation(invocations[0])["status"]
 
 	details = server.get_job_details("sleep_10")
 	assert "running" == details["status"]
@@ -0,0 +1,160 @@
+
+#include "unit_tests.h"
+#include "ut_declarations.h"
+#include <time.h>
+
+#include "NanoLog/NanoLog.hpp"
+
+// define the assert jump variable 
+jmp_buf unit_tests_exception;
+
+// helper function that displays current date and time
+static void display_datetime(void)
+{
+  time_t rawtime;
+  struct tm * timeinfo;
+
+  time (&rawtime);
+  timeinfo = localtime(&rawtime);
+  printf("%s",asctime(timeinfo));
+}
+
+int main(void)
+{
+	// ignore logging
+#if defined(__linux__)
+	nanolog::initialize(nanolog::GuaranteedLogger(), "/tmp/", "nanolog", 1);
+#else
+	#error "OS not supported !"
+#endif
+
+  printf("----------------------------------------\n");
+  printf("Unit Tests: Kiwibes\n");
+  display_datetime();
+  printf("----------------------------------------");
+  printf("\n=== Suite Kiwibes Invocations");
+  UT_RUN_TEST(test_invocations_status);
+  UT_RUN_TEST(test_invocations_wait);
+  printf("\n=== Suite Kiwibes Database");
+  UT_RUN_TEST(test_database_constructor);
+  UT_RUN_TEST(test_database_load_errors);
+  UT_RUN_TEST(test_database_load);
+  UT_RUN_TEST(test_database_get_all_schedulable_jobs);
+  UT_RUN_TEST(test_database_get_job_next_start);
+  UT_RUN_TEST(test_database_get_job_description);
+  UT_RUN_TEST(test_database_job_started);
+  UT_RUN_TEST(test_database_job_stopped);
+  UT_RUN_TEST(test_database_job_instances);
+  UT_RUN_TEST(test_database_run_history);
+  UT_RUN_TEST(test_database_stats);
+  UT_RUN_TEST(test_database_delete_job);
+  UT_RUN_TEST(test_database_delete_jobs);
+  UT_RUN_TEST(test_database_delete_jobs_benchmark);
+  UT_RUN_TEST(test_database_create_job);
+  UT_RUN_TEST(test_database_create_jobs);
+  UT_RUN_TEST(test_database_list_jobs);
+  UT_RUN_TEST(test_database_list_jobs_benchmark);
+  UT_RUN_TEST(test_database_edit_job);
+  UT_RUN_TEST(test_database_job_incr_start_requests);
+  UT_RUN_TEST(test_database_job_decr_start_requests);
+  UT_RUN_TEST(test_database_job_clear_start_requests);
+  UT_RUN_TEST(test_database_journal_replay);
+  UT_RUN_TEST(test_database_journal_stale);
+  UT_RUN_TEST(test_database_journal_incomplete_record);
+  UT_RUN_TEST(test_database_journal_unknown_job_record);
+  UT_RUN_TEST(test_database_journal_compaction);
+  UT_RUN_TEST(test_database_atomic_save);
+  UT_RUN_TEST(test_database_interrupted_save);
+  UT_RUN_TEST(test_database_saver_merges_requests);
+  UT_RUN_TEST(test_database_saver_exit);
+  UT_RUN_TEST(test_database_extra_fields);
+  UT_RUN_TEST(test_database_binary_snapshot);
+  UT_RUN_TEST(test_database_startup_benchmark);
+  UT_RUN_TEST(test_database_job_record_benchmark);
+  UT_RUN_TEST(test_database_readers_benchmark);
+  UT_RUN_TEST(test_database_journal_benchmark);
+  UT_RUN_TEST(test_database_shards_benchmark);
+  UT_RUN_TEST(test_database_shards_save);
+  UT_RUN_TEST(test_database_group_commit);
+  UT_RUN_TEST(test_database_group_commit_benchmark);
+  printf("\n=== Suite Kiwibes Scheduler");
+  UT_RUN_TEST(test_scheduler_same_second_batch);
+  UT_RUN_TEST(test_scheduler_unschedule_job);
+  printf("\n=== Suite Kiwibes Data Store");
+  UT_RUN_TEST(test_data_store_write);
+  UT_RUN_TEST(test_data_store_read);
+  UT_RUN_TEST(test_data_store_clear);
+  UT_RUN_TEST(test_data_store_clear_all);
+  UT_RUN_TEST(test_data_store_size);
+  UT_RUN_TEST(test_data_store_get_keys);
+  printf("\n=== Suite Parse Cmd Line");
+  UT_RUN_TEST(test_parse_and_validate_command_line);
+  printf("\n=== Suite Kiwibes Authentication");
+  UT_RUN_TEST(test_authentication_verify);
+  UT_RUN_TEST(test_authentication_update);
+  printf("\n=== Suite Kiwibes Job History");
+  UT_RUN_TEST(test_runtime_sketch_quantiles);
+  UT_RUN_TEST(test_runtime_sketch_merge);
+  UT_RUN_TEST(test_run_history);
+  UT_RUN_TEST(test_run_statistics);
+  printf("\n=== Suite Kiwibes Launch Queue");
+  UT_RUN_TEST(test_launch_queue_order);
+  UT_RUN_TEST(test_launch_queue_producers);
+  printf("\n=== Suite Kiwibes Snapshot");
+  UT_RUN_TEST(test_snapshot_round_trip);
+  UT_RUN_TEST(test_snapshot_invalid);
+  printf("\n=== Suite Kiwibes Scheduler Queue");
+  UT_RUN_TEST(test_scheduler_queue_order);
+  UT_RUN_TEST(test_scheduler_queue_shuffled);
+  UT_RUN_TEST(test_scheduler_queue_update);
+  UT_RUN_TEST(test_scheduler_queue_remove);
+  UT_RUN_TEST(test_scheduler_queue_push_all);
+  UT_RUN_TEST(test_scheduler_queue_push_all_benchmark);
+  printf("\n=== Suite Kiwibes Admission Queue");
+  UT_RUN_TEST(test_admission_queue_order);
+  UT_RUN_TEST(test_admission_queue_block);
+  UT_RUN_TEST(test_admission_queue_capacity);
+  printf("\n=== Suite Kiwibes Scheduler Event");
+  UT_RUN_TEST(test_scheduler_event_order);
+  UT_RUN_TEST(test_scheduler_event_shuffled_sort);
+  printf("\n=== Suite Kiwibes Deadlines");
+  UT_RUN_TEST(test_deadlines_order);
+  UT_RUN_TEST(test_deadlines_escalation);
+  printf("\n=== Suite Kiwibes Cgroups");
+  UT_RUN_TEST(test_cgroups_unavailable);
+  UT_RUN_TEST(test_cgroups_accounting);
+  printf("\n=== Suite Kiwibes Jobs Manager");
+  UT_RUN_TEST(test_jobs_manager_start_job);
+  UT_RUN_TEST(test_jobs_manager_launch_failure);
+  UT_RUN_TEST(test_jobs_manager_stop_job);
+  UT_RUN_TEST(test_jobs_manager_stop_all_jobs);
+  UT_RUN_TEST(test_jobs_manager_queued_start_requests);
+  UT_RUN_TEST(test_jobs_manager_queued_restart_latency);
+  UT_RUN_TEST(test_jobs_manager_polling_fallback);
+  UT_RUN_TEST(test_jobs_manager_max_runtime);
+  UT_RUN_TEST(test_jobs_manager_concurrency_limits);
+  UT_RUN_TEST(test_jobs_manager_start_job_async);
+  UT_RUN_TEST(test_jobs_manager_job_output);
+  UT_RUN_TEST(test_jobs_manager_job_resources);
+  UT_RUN_TEST(test_jobs_manager_forked_children);
+  UT_RUN_TEST(test_jobs_manager_cgroups_removed);
+  printf("\n=== Suite Kiwibes Job Output");
+  UT_RUN_TEST(test_job_output_capture);
+  UT_RUN_TEST(test_job_output_ring);
+  UT_RUN_TEST(test_job_output_runs);
+  UT_RUN_TEST(test_job_output_follow);
+  UT_RUN_TEST(test_job_output_spill);
+  printf("\n=== Suite Kiwibes Process Table");
+  UT_RUN_TEST(test_process_table_insert);
+  UT_RUN_TEST(test_process_table_instances);
+  UT_RUN_TEST(test_process_table_remove);
+  UT_RUN_TEST(test_process_table_reap_benchmark);
+  printf("\n=== Suite Kiwibes Cron");
+  UT_RUN_TEST(test_cron_valid_expressions);
+  UT_RUN_TEST(test_cron_invalid_expressions);
+  UT_RUN_TEST(test_cron_next_occurrence);
+  UT_RUN_TEST(test_cron_next_n_occurrences);
+  UT_RUN_TEST(test_cron_next_n_daylight_saving);
+  UT_RUN_TEST(test_cron_next_n_benchmark);
+  printf("\n");
+}
@@ -0,0 +1,116 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the admission queue of the jobs manager.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_admission_queue.h"
+
+#include <string>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_admission_queue_order(void)
+{
+  KiwibesAdmissionQueue queue;
+  std::string           name;
+
+  /* start with an empty queue */
+  ASSERT(0 == queue.size());
+  ASSERT(false == queue.pop(name));
+
+  /* requests with the same priority are admitted in the order they arrived */
+  queue.push("job_1",0);
+  queue.push("job_2",0);
+  queue.push("job_1",0);
+  ASSERT(3 == queue.size());
+  ASSERT(2 == queue.count("job_1"));
+
+  /* higher priorities are admitted first */
+  queue.push("job_3",5);
+  queue.push("job_4",-1);
+
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_3") == name);
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_1") == name);
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_2") == name);
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_1") == name);
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_4") == name);
+
+  ASSERT(false == queue.pop(name));
+  ASSERT(0 == queue.size());
+  ASSERT(0 == queue.count("job_1"));
+}
+
+void test_admission_queue_block(void)
+{
+  KiwibesAdmissionQueue queue;
+  std::string           name;
+
+  /* the requests of a blocked job are skipped, but kept in the queue */
+  queue.block("job_1");
+  queue.push("job_1",10);
+  queue.push("job_2",0);
+
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_2") == name);
+  ASSERT(false == queue.pop(name));
+  ASSERT(1 == queue.size());
+
+  /* once unblocked, they are admitted again */
+  queue.unblock("job_1");
+  ASSERT(true == queue.pop(name));
+  ASSERT(std::string("job_1") == name);
+  ASSERT(0 == queue.size());
+
+  /* clearing a job removes all of its requests, it remains blocked */
+  queue.push("job_3",0);
+  queue.push("job_3",0);
+  queue.block("job_3");
+  ASSERT(2 == queue.clear("job_3"));
+  ASSERT(0 == queue.clear("job_3"));
+  ASSERT(0 == queue.size());
+
+  queue.push("job_3",0);
+  ASSERT(false == queue.pop(name));
+  queue.unblock("job_3");
+  ASSERT(true == queue.pop(name));
+}
+
+void test_admission_queue_capacity(void)
+{
+  KiwibesAdmissionQueue queue;
+
+  /* no limit by default */
+  ASSERT(true == queue.admissible(1000000));
+
+  queue.set_capacity(2);
+  ASSERT(true == queue.admissible(0));
+  ASSERT(true == queue.admissible(1));
+  ASSERT(false == queue.admissible(2));
+  ASSERT(false == queue.admissible(3));
+
+  queue.set_capacity(0);
+  ASSERT(true == queue.admissible(3));
+}
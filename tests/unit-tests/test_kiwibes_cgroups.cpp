@@ -0,0 +1,108 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+   
+  Summary
+  -------
+  Implements the unit tests for the cgroups of the jobs.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_cgroups.h"
+
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_cgroups_unavailable(void)
+{
+  KiwibesCgroups cgroups;
+  T_JOB_RUN      run = { 0, 0, 0, 0, 10, 20, 30, 40, 50 };
+
+  /* disabled until enabled */
+  ASSERT(false == cgroups.enabled());
+  ASSERT(-1 == cgroups.create("job_1",0,0));
+  ASSERT(false == cgroups.attach(getpid(),-1));
+
+  /* the folder of the parent cgroup does not exist */
+  ASSERT(false == cgroups.enable("/nowhere/noplace/nergens/ergens"));
+  ASSERT(false == cgroups.enabled());
+  ASSERT(-1 == cgroups.create("job_1",0,0));
+  ASSERT(false == cgroups.attach(getpid(),-1));
+  ASSERT(0 == cgroups.size());
+
+  /* the usage from wait4 is kept */
+  cgroups.collect(getpid(),run);
+  ASSERT(10 == run.cpu_user);
+  ASSERT(20 == run.cpu_system);
+  ASSERT(30 == run.memory_peak);
+  ASSERT(40 == run.io_read);
+  ASSERT(50 == run.io_write);
+}
+
+void test_cgroups_accounting(void)
+{
+  KiwibesCgroups cgroups;
+  T_JOB_RUN      run = { 0, 0, 0, 0, -1, -1, -1, -1, -1 };
+
+  /* without cgroup v2 on the host, the runs are not placed in cgroups */
+  if(false == cgroups.enable(""))
+  {
+    return;
+  }
+
+  /* the process joins its cgroup before it executes the program, which spends some CPU time */
+  int         group = cgroups.create("job_1",0,0);
+  pid_t       pid;
+  const char *argv[] = { "/bin/sh", "-c", "i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done", NULL };
+  int         wstatus;
+
+  ASSERT(0 <= group);
+
+  pid = fork();
+  if(0 == pid)
+  {
+    if(true == KiwibesCgroups::join(group))
+    {
+      execv(argv[0],(char **)argv);
+    }
+    _exit(127);
+  }
+  ASSERT(0 < pid);
+  ASSERT(true == cgroups.attach(pid,group));
+  ASSERT(1 == cgroups.size());
+
+  /* a cgroup whose process was not launched is removed */
+  int unused = cgroups.create("job_1",0,0);
+
+  ASSERT(0 <= unused);
+  ASSERT(false == cgroups.attach(INVALID_PROCESS_HANDLE,unused));
+  ASSERT(1 == cgroups.size());
+
+  ASSERT(pid == waitpid(pid,&wstatus,0));
+  ASSERT(0 == WEXITSTATUS(wstatus));
+  cgroups.collect(pid,run);
+  ASSERT(0 == cgroups.size());
+
+  /* the CPU time of the process and its children is accounted, the other resources when available */
+  ASSERT(0 <= run.cpu_user);
+  ASSERT(0 <= run.cpu_system);
+  ASSERT(0 < run.cpu_user + run.cpu_system);
+}
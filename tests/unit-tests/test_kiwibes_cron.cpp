@@ -24,7 +24,57 @@
 #include "unit_tests.h"
 #include "kiwibes_cron.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
 #include <string>
+#include <vector>
+
+/*----------------------- Private Functions Definitions -----------*/
+/** List the occurrences in a window of time, one at a time
+
+  @param cron   the cron expression
+  @param from   the occurrences are strictly after this instant
+  @param to     the occurrences are at, or before, this instant
+  @param out    on return contains the occurrences
+ */
+static void next_one_by_one(KiwibesCron &cron, std::time_t from, std::time_t to, std::vector<std::time_t> &out)
+{
+  std::time_t last = from;
+  std::time_t next = cron.next(from);
+
+  out.clear();
+  while((last < next) && (next <= to))
+  {
+    out.push_back(next);
+    last = next;
+    next = cron.next(next);
+  }
+}
+
+/** Change the local timezone of the process
+
+  @param tz   the new timezone, or an empty string to use the system timezone
+  @return the previous timezone, or an empty string if it was the system timezone
+ */
+static std::string set_timezone(const std::string &tz)
+{
+  const char  *current  = getenv("TZ");
+  std::string previous = (nullptr == current) ? std::string("") : std::string(current);
+
+  if(0 == tz.size())
+  {
+    unsetenv("TZ");
+  }
+  else
+  {
+    setenv("TZ",tz.c_str(),1);
+  }
+  tzset();
+
+  return previous;
+}
 
 /*----------------------- Public Functions Definitions ------------*/
 void test_cron_valid_expressions(void)
@@ -66,4 +116,159 @@ void test_cron_invalid_expressions(void)
 
     ASSERT(false == cron.is_valid());
   }
-}
\ No newline at end of file
+}
+
+void test_cron_next_occurrence(void)
+{
+  std::time_t from = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+  /* every minute, at second 30. Many expressions are parsed so that any
+     bits left over from previous allocations would show up
+   */
+  for(unsigned int t = 0; t < 100; t++)
+  {
+    KiwibesCron cron(std::string("30 * * ? * *"));  
+    std::time_t next = cron.next(from);
+
+    ASSERT(true == cron.is_valid());
+    ASSERT(from < next);
+    ASSERT((from + 60) >= next);
+    ASSERT(30 == (next % 60));
+
+    /* the next occurrence is strictly after the given instant */
+    ASSERT((next + 60) == cron.next(next));
+    ASSERT((next + 60) == cron.next(next + 1));
+  }
+
+  /* invalid expressions have no next occurrence */
+  KiwibesCron invalid(std::string("61 * * ? * *"));
+
+  ASSERT(0 == invalid.next(from));
+}
+
+void test_cron_next_n_occurrences(void)
+{
+  const char *expressions[] = {
+    "* * * ? * *",                  /* every second */
+    "0 */7 * ? * *",                /* every 7 minutes */
+    "0 15,30,45 * ? * *",           /* every hour at minutes 15, 30 and 45 */
+    "0 0 0 * * ?",                  /* every day at midnight - 12am */
+    "0 0 12 * * MON-FRI",           /* every Weekday at noon */
+    "0 0 12 ? JAN *",               /* every day at noon in January only */
+    "30 5 4 1,15 * *",              /* twice a month */
+    "0 0 6 31 * *",                 /* only in the months with 31 days */
+    "0 0 6 29 2 *",                 /* only in leap years */
+    "0 0 6 13 * FRI",               /* on friday the 13th */
+  };
+  std::time_t from = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+  /* the cron library is not reliable on the days with daylight saving changes */
+  std::string tz = set_timezone("UTC");
+
+  for(unsigned int t = 0; t < sizeof(expressions)/sizeof(const char *); t++)
+  {
+    KiwibesCron cron(std::string(expressions[t]));  
+    std::time_t window = (0 == t) ? 7200 : (3*366*24*3600);
+
+    /* all the occurrences match those of the cron library */
+    std::vector<std::time_t> expected;
+    std::vector<std::time_t> occurrences;
+
+    next_one_by_one(cron,from,from + window,expected);
+    ASSERT(0 < expected.size());
+    ASSERT(expected.size() == cron.next_n(from,from + window,occurrences,expected.size() + 1));
+    ASSERT(expected == occurrences);
+
+    /* the occurrences are appended, up to the maximum */
+    ASSERT(1 == cron.next_n(from,from + window,occurrences,1));
+    ASSERT((expected.size() + 1) == occurrences.size());
+    ASSERT(expected[0] == occurrences.back());
+
+    /* the window limits are respected */
+    occurrences.clear();
+    ASSERT(1 == cron.next_n(expected[0] - 1,expected[0],occurrences,10));
+    ASSERT(0 == cron.next_n(expected[0],expected[0],occurrences,10));
+  }
+
+  /* invalid expressions have no occurrences */
+  KiwibesCron              invalid(std::string("61 * * ? * *"));
+  std::vector<std::time_t> occurrences;
+
+  ASSERT(0 == invalid.next_n(from,from + 3600,occurrences,10));
+
+  set_timezone(tz);
+}
+
+void test_cron_next_n_daylight_saving(void)
+{
+  std::string tz = set_timezone("America/New_York");
+  struct tm  local;
+
+  /* 2019-03-10 00:00 EST, the clocks moved forward at 02:00 */
+  std::time_t              spring = 1552194000;
+  std::vector<std::time_t> occurrences;
+  KiwibesCron              nonexistent(std::string("0 30 2 * * *"));
+  KiwibesCron              hourly(std::string("0 0 * * * *"));
+
+  ASSERT(3 == nonexistent.next_n(spring - 1,spring + 3*24*3600,occurrences,10));
+
+  localtime_r(&(occurrences[0]),&local);
+  ASSERT((10 == local.tm_mday) && (3 == local.tm_hour) && (30 == local.tm_min));
+  localtime_r(&(occurrences[1]),&local);
+  ASSERT((11 == local.tm_mday) && (2 == local.tm_hour) && (30 == local.tm_min));
+
+  /* 2019-11-03 00:00 EDT, the clocks moved back at 02:00 */
+  std::time_t autumn = 1572753600;
+
+  occurrences.clear();
+  ASSERT(24 == hourly.next_n(autumn - 1,autumn + 25*3600 - 1,occurrences,100));
+
+  for(int h = 0; h < 24; h++)
+  {
+    localtime_r(&(occurrences[h]),&local);
+    ASSERT((3 == local.tm_mday) && (h == local.tm_hour));
+  }
+
+  set_timezone(tz);
+}
+
+void test_cron_next_n_benchmark(void)
+{
+  const char *expressions[] = {
+    "0 */5 * ? * *",                /* every 5 minutes */
+    "0 0 */2 ? * *",                /* every 2 hours */
+    "*/30 * * ? * *",               /* every 30 seconds */
+    "0 0 12 * * MON-FRI",           /* every Weekday at noon */
+  };
+  std::time_t from   = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::time_t to     = from + 24*3600;
+  size_t      starts = 0;
+  long        batch  = 0;
+  long        single = 0;
+  std::string tz     = set_timezone("UTC");
+
+  /* the next 24 hours of 500 jobs */
+  for(unsigned int j = 0; j < 500; j++)
+  {
+    KiwibesCron              cron(std::string(expressions[j % (sizeof(expressions)/sizeof(const char *))]));
+    std::vector<std::time_t> expected;
+    std::vector<std::time_t> occurrences;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    next_one_by_one(cron,from,to,expected);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    cron.next_n(from,to,occurrences,100000);
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    ASSERT(expected == occurrences);
+
+    starts += occurrences.size();
+    single += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    batch  += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+  }
+
+  set_timezone(tz);
+
+  printf("[%zu starts: next_n %ld us, next %ld us] ",starts,batch,single);
+  ASSERT(batch < single);
+}
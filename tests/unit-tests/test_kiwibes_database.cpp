@@ -25,13 +25,79 @@
 #include "kiwibes_database.h"
 
 #include "nlohmann/json.h"
+#include "NanoLog/NanoLog.hpp"
 
+#include <algorithm>
 #include <vector>
+#include <map>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cstdio>
+#include <sstream>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*----------------------- Private Functions Definitions -----------*/
+/** Copy a test database to the current folder, without a journal or temporary files
+
+  @param name   the name of the database file
+ */
+static void copy_test_database(const std::string &name)
+{
+  std::ifstream src("../tests/data/databases/" + name);
+  std::ofstream dst("./" + name);
+
+  dst << src.rdbuf();
+  std::remove(("./" + name + ".journal").c_str());
+  std::remove(("./" + name + ".journal.old").c_str());
+  std::remove(("./" + name + ".journal.tmp").c_str());
+  std::remove(("./" + name + ".tmp").c_str());
+  std::remove(("./" + name + ".bin").c_str());
+}
+
+/** Return the contents of a file
+
+  @param fname  the path to the file
+ */
+static std::string file_contents(const std::string &fname)
+{
+  std::ifstream     file(fname);
+  std::stringstream contents;
+
+  contents << file.rdbuf();
+
+  return contents.str();
+}
+
+/** Wait until the saver thread has written a JSON file with the given number of jobs
+
+  @param fname  the path to the JSON file
+  @param njobs  the expected number of jobs
+  @return true if the file was written before the timeout, false otherwise
+ */
+static bool wait_for_save(const std::string &fname, size_t njobs)
+{
+  bool saved = false;
+
+  for(int t = 0; (false == saved) && (t < 1000); t++)
+  {
+    std::ifstream old(fname + ".journal.old");
+
+    saved = (false == old.is_open()) && (njobs == nlohmann::json::parse(file_contents(fname)).size());
+    if(false == saved)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  return saved;
+}
 
 /*----------------------- Public Functions Definitions ------------*/
 void test_database_constructor(void)
@@ -108,6 +174,49 @@ void test_database_get_all_schedulable_jobs(void)
   ASSERT(expected_schedulable_jobs == schedulable_jobs);
 }
 
+void test_database_get_job_next_start(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  update;
+  std::time_t     next = 0;
+  std::time_t     from = 3600*24*365;
+
+  {
+    std::ifstream src("../tests/data/databases/single_job.json");
+    std::ofstream dst("./single_job.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  /* unknown jobs and empty schedules have no next start */
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_next_start(next,"my job",from));
+  ASSERT(ERROR_JOB_SCHEDULE_INVALID == database.get_job_next_start(next,"job_1",from));
+
+  /* editing the schedule replaces the cached one */
+  update["schedule"] = "0 0 * * * *";
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",update));
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"job_1",from));
+  ASSERT((from + 3600) == next);
+
+  update["schedule"] = "0 30 * * * *";
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",update));
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"job_1",from));
+  ASSERT((from + 1800) == next);
+
+  /* editing other fields keeps the schedule */
+  update.clear();
+  update["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",update));
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"job_1",from + 1800));
+  ASSERT((from + 5400) == next);
+
+  /* deleted jobs have no next start */
+  ASSERT(ERROR_NO_ERROR == database.delete_job("job_1"));
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_next_start(next,"job_1",from));
+}
+
 void test_database_get_job_description(void)
 {
   KiwibesDatabase database; 
@@ -329,6 +438,195 @@ void test_database_job_stopped(void)
   ASSERT(ERROR_JOB_IS_NOT_RUNNING == database.job_stopped("job_1"));
 }
 
+void test_database_job_instances(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  job;
+  nlohmann::json  details;
+  nlohmann::json  stats;
+  T_JOB_RUN       run;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  /* by default, a job runs a single instance at once */
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(1 == job["max-parallel"].get<unsigned int>());
+  ASSERT(0 == job["priority"].get<signed int>());
+  ASSERT(0 == job["max-memory"].get<unsigned int>());
+  ASSERT(0 == job["max-cpu"].get<unsigned int>());
+
+  details["max-parallel"] = 2;
+  details["priority"]     = -3;
+  details["max-memory"]   = 256;
+  details["max-cpu"]      = 50;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+
+  /* it remains running until the last of its instances stops */
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_JOB_IS_RUNNING == database.job_started("job_1"));
+
+  database.get_stats(stats);
+  ASSERT(1 == stats["running"].get<uint64_t>());
+
+  run.start       = 1000;
+  run.duration    = 250;
+  run.exit_status = 0;
+  run.signal      = 0;
+  run.cpu_user    = 1500;
+  run.cpu_system  = 500;
+  run.memory_peak = 8*1024*1024;
+  run.io_read     = 4096;
+  run.io_write    = 0;
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1",run,false));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(1                      == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(250                    == job["runs"][0]["duration"].get<int64_t>());
+  ASSERT(1500                   == job["runs"][0]["cpu-user"].get<int64_t>());
+  ASSERT(8*1024*1024            == job["runs"][0]["memory-peak"].get<int64_t>());
+
+  run.duration = 500;
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1",run,false));
+  ASSERT(ERROR_JOB_IS_NOT_RUNNING == database.job_stopped("job_1",run,false));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(2                      == job["nbr-runs"].get<unsigned long int>());
+
+  database.get_stats(stats);
+  ASSERT(0 == stats["running"].get<uint64_t>());
+  ASSERT(0.004 == stats["cpu-time"].get<double>());
+
+  /* the limits, and the resources of the runs, are kept when the database is loaded again */
+  {
+    KiwibesDatabase reloaded;
+    nlohmann::json  replayed;
+
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(replayed,"job_1"));
+    ASSERT(2  == replayed["max-parallel"].get<unsigned int>());
+    ASSERT(-3 == replayed["priority"].get<signed int>());
+    ASSERT(256 == replayed["max-memory"].get<unsigned int>());
+    ASSERT(50 == replayed["max-cpu"].get<unsigned int>());
+    ASSERT(2000 == replayed["runs"][1]["cpu-user"].get<int64_t>() + replayed["runs"][1]["cpu-system"].get<int64_t>());
+    ASSERT(4096 == replayed["runs"][1]["io-read"].get<int64_t>());
+  }
+}
+
+void test_database_run_history(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  /* jobs which never ran have no history */
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(0 == job.count("runs"));
+  ASSERT(0 == job.count("runtime-percentiles"));
+  ASSERT(0 == job["nbr-timeouts"].get<unsigned long int>());
+
+  /* the second run exceeds the maximum runtime */
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1",3,0));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1",-1,9,true));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(2 == job["runs"].size());
+  ASSERT(50 <= job["runs"][0]["duration"].get<int64_t>());
+  ASSERT(3 == job["runs"][0]["exit-status"].get<int>());
+  ASSERT(0 == job["runs"][0]["signal"].get<int>());
+  ASSERT(-1 == job["runs"][1]["exit-status"].get<int>());
+  ASSERT(9 == job["runs"][1]["signal"].get<int>());
+  ASSERT(1 == job["nbr-timeouts"].get<unsigned long int>());
+  ASSERT(job["runs"][0]["start"].get<int64_t>() <= job["runs"][1]["start"].get<int64_t>());
+  ASSERT(49.0 <= job["runtime-percentiles"]["p50"].get<double>());
+  ASSERT(job["runtime-percentiles"]["p50"].get<double>() <= job["runtime-percentiles"]["p99"].get<double>());
+
+  /* only the runs are journaled, and replaying them gives the same history */
+  std::string journal = file_contents("./single_job.json.journal");
+  ASSERT(3 == std::count(journal.begin(),journal.end(),'\n'));
+  ASSERT(std::string::npos != journal.find("\"op\":\"run\""));
+  {
+    KiwibesDatabase reloaded;
+    nlohmann::json  replayed;
+
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(replayed,"job_1"));
+    ASSERT(job == replayed);
+  }
+
+  /* the history is saved with the job, and in the binary snapshot */
+  database.set_binary_snapshot(true);
+  ASSERT(ERROR_NO_ERROR == database.save());
+  ASSERT(2 == nlohmann::json::parse(file_contents("./single_job.json"))["job_1"]["runs"].size());
+  {
+    KiwibesDatabase reloaded;
+    nlohmann::json  saved;
+
+    reloaded.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(saved,"job_1"));
+    ASSERT(job == saved);
+  }
+
+  std::remove("./single_job.json.bin");
+}
+
+void test_database_stats(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  stats;
+
+  copy_test_database("two_jobs.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./two_jobs.json"));
+
+  database.get_stats(stats);
+  ASSERT(2 == stats["jobs"].get<int64_t>());
+  ASSERT(0 == stats["running"].get<int64_t>());
+  ASSERT(0 == stats["pending-start"].get<int64_t>());
+  ASSERT(0 == stats["runs"].get<uint64_t>());
+
+  /* the counters follow the state of the jobs */
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_incr_start_requests("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_incr_start_requests("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_incr_start_requests("job_2"));
+
+  database.get_stats(stats);
+  ASSERT(1 == stats["running"].get<int64_t>());
+  ASSERT(3 == stats["pending-start"].get<int64_t>());
+
+  ASSERT(1 == database.job_decr_start_requests("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1",2,0));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+
+  database.get_stats(stats);
+  ASSERT(0 == stats["running"].get<int64_t>());
+  ASSERT(2 == stats["pending-start"].get<int64_t>());
+  ASSERT(2 == stats["runs"].get<uint64_t>());
+  ASSERT(1 == stats["failed-runs"].get<uint64_t>());
+  ASSERT(2 == stats["runs-per-minute"].get<uint64_t>());
+  ASSERT(0 == stats["timed-out-runs"].get<uint64_t>());
+
+  /* the pending start requests of cleared and deleted jobs are no longer counted */
+  ASSERT(ERROR_NO_ERROR == database.job_clear_start_requests("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.delete_job("job_2"));
+
+  database.get_stats(stats);
+  ASSERT(1 == stats["jobs"].get<int64_t>());
+  ASSERT(0 == stats["pending-start"].get<int64_t>());
+  ASSERT(2 == stats["runs"].get<uint64_t>());
+}
+
 void test_database_delete_job(void)
 {
   KiwibesDatabase database; 
@@ -382,6 +680,131 @@ void test_database_delete_job(void)
   ASSERT(0 == names.size());
 }
 
+void test_database_delete_jobs(void)
+{
+  KiwibesDatabase          database; 
+  nlohmann::json           job; 
+  std::vector<std::string> names;
+
+  copy_test_database("two_jobs.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./two_jobs.json"));
+
+  /* no job is deleted if one of them cannot be deleted */
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.delete_jobs({ "job_1", "my job" }));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_2"));  
+  ASSERT(ERROR_JOB_IS_RUNNING == database.delete_jobs({ "job_1", "job_2" }));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_2"));
+
+  database.get_all_job_names(names);
+  ASSERT(2 == names.size());
+
+  /* an empty list deletes nothing, repeated names are deleted once */
+  ASSERT(ERROR_NO_ERROR == database.delete_jobs({}));
+  ASSERT(ERROR_NO_ERROR == database.delete_jobs({ "job_1", "job_2", "job_1" }));
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_description(job,"job_1"));  
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_description(job,"job_2"));  
+
+  database.get_all_job_names(names);
+  ASSERT(0 == names.size());
+
+  /* the jobs were deleted with a single journal record */
+  std::string journal = file_contents("./two_jobs.json.journal");
+  ASSERT(3 == std::count(journal.begin(),journal.end(),'\n'));
+
+  /* a job created again with the name of a deleted job is seen by readers */
+  job = { {"program", { "/usr/bin/ls" }}, {"schedule", ""}, {"max-runtime", 9} };
+  ASSERT(ERROR_NO_ERROR == database.create_job("job_1",job));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  database.get_all_job_names(names);
+  ASSERT((1 == names.size()) && ("job_1" == names[0]));
+  ASSERT(ERROR_NO_ERROR == database.delete_job("job_1"));
+
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./two_jobs.json"));
+  reloaded.get_all_job_names(names);
+  ASSERT(0 == names.size());
+}
+
+void test_database_delete_jobs_benchmark(void)
+{
+  KiwibesDatabase                      database; 
+  std::vector<std::string>             names;
+  std::vector<std::string>             bulk;
+  std::map<std::string,nlohmann::json> created;
+  nlohmann::json                       details;
+
+  /* a database with 50000 jobs */
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("../tests/data/databases/single_job.json"));
+    nlohmann::json job  = jobs["job_1"];
+    std::ofstream  dst("./many_jobs.json");
+
+    for(int j = 0; j < 50000; j++)
+    {
+      jobs["job_" + std::to_string(j)] = job;
+    }
+    dst << jobs.dump();
+  }
+  std::remove("./many_jobs.json.journal");
+  ASSERT(ERROR_NO_ERROR == database.load("./many_jobs.json"));
+
+  /* delete 1000 jobs one at a time, and then 1000 jobs at once, each delete is durable */
+  database.set_journal_sync(JOURNAL_SYNC_ALWAYS);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(int j = 1; j <= 1000; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.delete_job("job_" + std::to_string(j)));
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  for(int j = 1001; j <= 2000; j++)
+  {
+    bulk.push_back("job_" + std::to_string(j));
+  }
+  ASSERT(ERROR_NO_ERROR == database.delete_jobs(bulk));
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  database.get_all_job_names(names);
+  ASSERT(48000 == names.size());
+
+  /* a bulk delete removes the jobs from each shard and journals them once */
+  printf("[1000 of 50000 jobs: %.1f ms one at a time, %.1f ms at once] ",
+         std::chrono::duration<double,std::milli>(t1 - t0).count(),
+         std::chrono::duration<double,std::milli>(t2 - t1).count());
+  ASSERT(2*(t2 - t1) < (t1 - t0));
+
+  /* create 1000 new jobs one at a time, and then 1000 new jobs at once */
+  database.set_journal_sync(JOURNAL_SYNC_NONE);
+  details["program"]     = { "/usr/bin/ls" };
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 9;
+  std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+  for(int j = 0; j < 1000; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("new_" + std::to_string(j),details));
+  }
+  std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+  for(int j = 1000; j < 2000; j++)
+  {
+    created["new_" + std::to_string(j)] = details;
+  }
+  ASSERT(ERROR_NO_ERROR == database.create_jobs(created));
+  std::chrono::steady_clock::time_point t5 = std::chrono::steady_clock::now();
+
+  database.get_all_job_names(names);
+  ASSERT(50000 == names.size());
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(details,"new_0"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(details,"new_999"));
+
+  /* creating a job does not publish all the slots of its shard again */
+  printf("[1000 new jobs: %.1f ms one at a time, %.1f ms at once] ",
+         std::chrono::duration<double,std::milli>(t4 - t3).count(),
+         std::chrono::duration<double,std::milli>(t5 - t4).count());
+  ASSERT((t4 - t3) < 4*(t5 - t4));
+  
+  std::remove("./many_jobs.json");
+  std::remove("./many_jobs.json.journal");
+}
+
 void test_database_create_job(void)
 {
   KiwibesDatabase database; 
@@ -502,6 +925,260 @@ void test_database_create_job(void)
   ASSERT(0                          == job["pending-start"].get<signed int>());
 }
 
+void test_database_create_jobs(void)
+{
+  KiwibesDatabase                      database; 
+  nlohmann::json                       job; 
+  std::map<std::string,nlohmann::json> jobs;
+  std::vector<std::string>             names;
+
+  copy_test_database("two_jobs.json");
+  std::remove("./two_jobs.json.journal");
+  ASSERT(ERROR_NO_ERROR == database.load("./two_jobs.json"));
+
+  job["program"]     = std::vector<std::string>({ "/usr/bin/ls" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 9;
+
+  /* no job is created if one of them cannot be created */
+  jobs["job_3"] = job;
+  jobs["job_1"] = job;
+  ASSERT(ERROR_JOB_NAME_TAKEN == database.create_jobs(jobs));
+  jobs.erase("job_1");
+  jobs["job_4"] = nlohmann::json::object();
+  ASSERT(ERROR_JOB_DESCRIPTION_INVALID == database.create_jobs(jobs));
+
+  database.get_all_job_names(names);
+  ASSERT(2 == names.size());
+
+  /* an empty map creates nothing */
+  ASSERT(ERROR_NO_ERROR == database.create_jobs(std::map<std::string,nlohmann::json>()));
+
+  for(int j = 4; j < 100; j++)
+  {
+    job["schedule"] = (0 == (j % 2)) ? "* * * * * *" : "";
+    jobs["job_" + std::to_string(j)] = job;
+  }
+  ASSERT(ERROR_NO_ERROR == database.create_jobs(jobs));
+
+  database.get_all_job_names(names);
+  ASSERT(99 == names.size());
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_50"));
+  ASSERT(0 == job["schedule"].get<std::string>().compare("* * * * * *"));
+  ASSERT(0 == job["nbr-runs"].get<unsigned int>());
+
+  names.clear();
+  database.get_all_schedulable_jobs(names);
+  ASSERT(49 == names.size());
+
+  /* the jobs were created with a single journal record, after its header */
+  std::string journal = file_contents("./two_jobs.json.journal");
+  ASSERT(2 == std::count(journal.begin(),journal.end(),'\n'));
+
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./two_jobs.json"));
+  reloaded.get_all_job_names(names);
+  ASSERT(99 == names.size());
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_99"));
+  ASSERT(9 == job["max-runtime"].get<unsigned int>());
+}
+
+void test_database_list_jobs(void)
+{
+  KiwibesDatabase                      database; 
+  nlohmann::json                       job; 
+  std::map<std::string,nlohmann::json> jobs;
+  std::vector<std::string>             page;
+  std::vector<std::string>             listed;
+  std::string                          cursor;
+  T_JOB_FILTER                         filter;
+  std::time_t                          next;
+
+  copy_test_database("empty_db.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  job["program"]     = std::vector<std::string>({ "/usr/bin/ls" });
+  job["max-runtime"] = 9;
+  for(int j = 0; j < 100; j++)
+  {
+    job["schedule"] = (0 == (j % 2)) ? "0 0 * * * *" : "";
+    jobs["etl_" + std::to_string(100 + j)] = job;
+    jobs["web_" + std::to_string(100 + j)] = job;
+  }
+  ASSERT(ERROR_NO_ERROR == database.create_jobs(jobs));
+
+  /* every third job of each prefix is running, and every fifth has pending start requests */
+  for(int j = 0; j < 100; j += 3)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("etl_" + std::to_string(100 + j)));
+    ASSERT(ERROR_NO_ERROR == database.job_started("web_" + std::to_string(100 + j)));
+  }
+  for(int j = 0; j < 100; j += 5)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_incr_start_requests("etl_" + std::to_string(100 + j)));
+  }
+
+  /* all the jobs, a page at a time */
+  filter.by_status = false;
+  filter.status    = JOB_STATUS_STOPPED;
+  filter.pending   = false;
+  filter.prefix    = "";
+  filter.order     = JOB_ORDER_NAME;
+  do
+  {
+    ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,7));
+    ASSERT(7 >= page.size());
+    listed.insert(listed.end(),page.begin(),page.end());
+  } while(0 < cursor.size());
+  ASSERT(200 == listed.size());
+  ASSERT(true == std::is_sorted(listed.begin(),listed.end()));
+
+  /* the running jobs with a prefix */
+  filter.by_status = true;
+  filter.status    = JOB_STATUS_RUNNING;
+  filter.prefix    = "etl_";
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(34 == page.size());
+  ASSERT(0 == cursor.size());
+  for(size_t n = 0; n < page.size(); n++)
+  {
+    ASSERT(0 == page[n].compare(0,4,"etl_"));
+    ASSERT(0 == ((std::stoi(page[n].substr(4)) - 100) % 3));
+  }
+
+  /* the stopped jobs with pending start requests, and the stopped jobs */
+  filter.status  = JOB_STATUS_STOPPED;
+  filter.pending = true;
+  filter.prefix  = "";
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(13 == page.size());
+
+  filter.pending = false;
+  filter.prefix  = "web_";
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(66 == page.size());
+
+  /* a prefix no job has */
+  filter.by_status = false;
+  filter.prefix    = "etl_2";
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,10));
+  ASSERT(0 == page.size());
+  ASSERT(0 == cursor.size());
+
+  /* only the jobs whose next start was computed are listed by their next start */
+  filter.prefix = "";
+  filter.order  = JOB_ORDER_NEXT_START;
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,10));
+  ASSERT(0 == page.size());
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"web_102",7200));
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"etl_100",3600));
+  ASSERT(ERROR_NO_ERROR == database.get_job_next_start(next,"web_100",3600));
+  ASSERT(ERROR_JOB_SCHEDULE_INVALID == database.get_job_next_start(next,"web_101",3600));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,2));
+  ASSERT(2 == page.size());
+  ASSERT(0 == page[0].compare("etl_100"));
+  ASSERT(0 == page[1].compare("web_100"));
+  ASSERT(0 < cursor.size());
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,2));
+  ASSERT(1 == page.size());
+  ASSERT(0 == page[0].compare("web_102"));
+  ASSERT(0 == cursor.size());
+
+  cursor = "job_1";
+  ASSERT(ERROR_JOB_LIST_INVALID == database.get_job_names_page(page,cursor,filter,2));
+  ASSERT(ERROR_JOB_LIST_INVALID == database.get_job_names_page(page,cursor,filter,0));
+
+  /* deleted jobs, and jobs that are no longer scheduled, leave the indexes */
+  cursor = "";
+  ASSERT(ERROR_NO_ERROR == database.delete_job("web_102"));
+  job["schedule"] = "";
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("etl_100"));
+  ASSERT(ERROR_NO_ERROR == database.edit_job("etl_100",job));
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,10));
+  ASSERT(1 == page.size());
+  ASSERT(0 == page[0].compare("web_100"));
+
+  filter.by_status = true;
+  filter.status    = JOB_STATUS_RUNNING;
+  filter.prefix    = "web_";
+  filter.order     = JOB_ORDER_NAME;
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(34 == page.size());
+
+  /* the indexes are built again when the database is loaded, with all the jobs stopped */
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./empty_db.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(0 == page.size());
+  filter.status = JOB_STATUS_STOPPED;
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_names_page(page,cursor,filter,1000));
+  ASSERT(99 == page.size());
+}
+
+void test_database_list_jobs_benchmark(void)
+{
+  KiwibesDatabase          database; 
+  std::vector<std::string> names;
+  std::vector<std::string> running;
+  std::string              cursor;
+  T_JOB_FILTER             filter;
+
+  /* a database with 50000 jobs, 20 of them running */
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("../tests/data/databases/single_job.json"));
+    nlohmann::json job  = jobs["job_1"];
+    std::ofstream  dst("./many_jobs.json");
+
+    for(int j = 0; j < 50000; j++)
+    {
+      jobs["job_" + std::to_string(j)] = job;
+    }
+    dst << jobs.dump();
+  }
+  std::remove("./many_jobs.json.journal");
+  ASSERT(ERROR_NO_ERROR == database.load("./many_jobs.json"));
+
+  for(int j = 0; j < 50000; j += 2500)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("job_" + std::to_string(j)));
+  }
+
+  /* find the running jobs from all the descriptions, and then from the index */
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  database.get_all_job_names(names);
+  for(size_t n = 0; n < names.size(); n++)
+  {
+    nlohmann::json job;
+
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,names[n]));
+    if(0 == job["status"].get<std::string>().compare("running"))
+    {
+      running.push_back(names[n]);
+    }
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  filter.by_status = true;
+  filter.status    = JOB_STATUS_RUNNING;
+  filter.pending   = false;
+  filter.prefix    = "";
+  filter.order     = JOB_ORDER_NAME;
+  ASSERT(ERROR_NO_ERROR == database.get_job_names_page(names,cursor,filter,100));
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  ASSERT(20 == running.size());
+  ASSERT(running == names);
+
+  printf("[20 running of 50000 jobs: %.2f ms from the descriptions, %.3f ms from the index] ",
+         std::chrono::duration<double,std::milli>(t1 - t0).count(),
+         std::chrono::duration<double,std::milli>(t2 - t1).count());
+  
+  std::remove("./many_jobs.json");
+  std::remove("./many_jobs.json.journal");
+}
+
 void test_database_edit_job(void)
 {
   KiwibesDatabase database; 
@@ -778,3 +1455,1072 @@ void test_database_job_clear_start_requests(void)
   /* cannot decrement the pending requests */
   ASSERT(-1 == database.job_decr_start_requests("job_1"));  
 }
+
+void test_database_journal_replay(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  /* make some changes to the jobs */
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  ASSERT(ERROR_NO_ERROR == database.create_job("job_2",details));
+  ASSERT(ERROR_NO_ERROR == database.create_job("job_3",details));
+  ASSERT(ERROR_NO_ERROR == database.delete_job("job_2"));
+
+  details["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+
+  /* the changes are in the journal, the JSON file is the original */
+  ASSERT(file_contents("../tests/data/databases/single_job.json") == file_contents("./single_job.json"));
+
+  /* another database sees the changes when loading */
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == reloaded.get_job_description(job,"job_2"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_3"));
+  ASSERT(5 == job["max-runtime"].get<unsigned long int>()); 
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+  ASSERT(1 == job["nbr-runs"].get<unsigned long int>()); 
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+
+  /* changes after reloading are appended to the same journal */
+  ASSERT(ERROR_NO_ERROR == reloaded.delete_job("job_3"));
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_description(job,"job_3"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+
+  /* saving writes the changes to the JSON file and empties the journal */
+  ASSERT(ERROR_NO_ERROR == database.save());
+  ASSERT(std::string::npos != file_contents("./single_job.json").find("\"max-runtime\": 20"));
+  std::string journal = file_contents("./single_job.json.journal");
+  ASSERT(1 == std::count(journal.begin(),journal.end(),'\n'));
+}
+
+void test_database_journal_stale(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  details["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+
+  /* replacing the JSON file makes the journal obsolete */
+  {
+    std::ifstream src("../tests/data/databases/single_job.json");
+    std::ofstream dst("./single_job.json");
+
+    dst << src.rdbuf() << std::endl;
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(10 == job["max-runtime"].get<unsigned long int>()); 
+}
+
+void test_database_journal_incomplete_record(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  details["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+
+  /* the server died while writing a record */
+  {
+    std::ofstream journal("./single_job.json.journal",std::ios::app);
+
+    journal << "{\"op\":\"set\",\"name\":\"job_1\",\"job\":{\"max-runt";
+  }
+
+  /* the incomplete record is ignored, and removed from the journal */
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+
+  details["max-runtime"] = 30;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(30 == job["max-runtime"].get<unsigned long int>()); 
+}
+
+void test_database_journal_unknown_job_record(void)
+{
+  nlohmann::json details;
+  nlohmann::json job;
+  std::string    journal;
+
+  copy_test_database("single_job.json");
+  {
+    KiwibesDatabase database; 
+
+    ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+    details["max-runtime"] = 20;
+    ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+    details["max-runtime"] = 40;
+    ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  }
+
+  /* a complete record that cannot be applied sits between the two edits */
+  journal = file_contents("./single_job.json.journal");
+  ASSERT(3 == std::count(journal.begin(),journal.end(),'\n'));
+  journal.insert(journal.rfind('\n',journal.size() - 2) + 1,
+                 "{\"op\":\"run\",\"name\":\"job_x\",\"run\":{\"start\":1,\"duration\":1,\"exit-status\":0,\"signal\":0}}\n");
+  {
+    std::ofstream output("./single_job.json.journal",std::ios::trunc);
+
+    output << journal;
+  }
+
+  /* the record is skipped, the next ones are still applied and kept in the journal */
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(40 == job["max-runtime"].get<unsigned long int>()); 
+  ASSERT(journal == file_contents("./single_job.json.journal"));
+}
+
+void test_database_journal_compaction(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+
+  copy_test_database("empty_db.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  /* the journal can have as many records as there are jobs */
+  for(int j = 0; j < 1500; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+  }
+  ASSERT(0 == nlohmann::json::parse(file_contents("./empty_db.json")).size());
+
+  /* once the journal is longer, it is merged into the JSON file by the saver thread */
+  details["max-runtime"] = 10;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_0",details));
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  ASSERT(true == wait_for_save("./empty_db.json",1500));
+
+  nlohmann::json snapshot = nlohmann::json::parse(file_contents("./empty_db.json"));
+  std::string    journal  = file_contents("./empty_db.json.journal");
+
+  ASSERT(10 == snapshot["job_0"]["max-runtime"].get<unsigned long int>());
+  ASSERT(2 >= std::count(journal.begin(),journal.end(),'\n'));
+  ASSERT(file_contents("./empty_db.json.tmp").empty());
+
+  KiwibesDatabase          reloaded;
+  std::vector<std::string> names;
+
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./empty_db.json"));
+  reloaded.get_all_job_names(names);
+  ASSERT(1500 == names.size());
+
+  nlohmann::json job;
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(10 == job["max-runtime"].get<unsigned long int>()); 
+}
+
+void test_database_atomic_save(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+
+  /* the server died while writing the JSON file, which was not replaced */
+  {
+    std::ofstream tmp("./single_job.json.tmp");
+
+    tmp << "{\"job_1\": {\"program\": [\"/bin/tr";
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+
+  details["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* the temporary file was renamed over the JSON file */
+  ASSERT(file_contents("./single_job.json.tmp").empty());
+  ASSERT(file_contents("./single_job.json.journal.tmp").empty());
+  ASSERT(20 == nlohmann::json::parse(file_contents("./single_job.json"))["job_1"]["max-runtime"].get<unsigned long int>());
+
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+}
+
+void test_database_interrupted_save(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+  nlohmann::json  header;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* the server died while writing the JSON file, after rotating the journal */
+  header = nlohmann::json::parse(file_contents("./single_job.json.journal"));
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("./single_job.json"));
+    std::ofstream  old("./single_job.json.journal.old");
+    std::ofstream  journal("./single_job.json.journal");
+
+    old << header.dump() << std::endl;
+    old << nlohmann::json({ {"op","set"}, {"name","job_2"}, {"job",jobs["job_1"]} }).dump() << std::endl;
+
+    header["next"] = 1;
+    journal << header.dump() << std::endl;
+    journal << "{\"op\":\"delete\",\"name\":\"job_1\"}" << std::endl;
+  }
+
+  /* both journals are applied, and then merged into the JSON file */
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == database.get_job_description(job,"job_1"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_2"));
+  ASSERT(false == std::ifstream("./single_job.json.journal.old").is_open());
+  ASSERT(1 == nlohmann::json::parse(file_contents("./single_job.json")).count("job_2"));
+
+  /* the server died after replacing the JSON file, but before starting its journal */
+  header = nlohmann::json::parse(file_contents("./single_job.json.journal"));
+  {
+    nlohmann::json stale;
+    std::ofstream  old("./single_job.json.journal.old");
+    std::ofstream  journal("./single_job.json.journal");
+
+    stale["snapshot"] = 1;
+    stale["mtime"]    = 1;
+    old << stale.dump() << std::endl;
+    old << "{\"op\":\"delete\",\"name\":\"job_2\"}" << std::endl;
+
+    stale["next"] = header["snapshot"];
+    journal << stale.dump() << std::endl;
+    journal << nlohmann::json({ {"op","set"}, {"name","job_3"}, {"job",job} }).dump() << std::endl;
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_2"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_3"));
+  ASSERT(false == std::ifstream("./single_job.json.journal.old").is_open());
+  ASSERT(2 == nlohmann::json::parse(file_contents("./single_job.json")).size());
+}
+
+void test_database_saver_merges_requests(void)
+{
+  std::chrono::steady_clock::time_point t0;
+  std::chrono::steady_clock::time_point t1;
+
+  {
+    KiwibesDatabase database; 
+    nlohmann::json  details;
+
+    copy_test_database("empty_db.json");
+    ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+    details["program"]     = std::vector<std::string>({ "/bin/true" });
+    details["schedule"]    = "1 2 3 4 5 6";
+    details["max-runtime"] = 5;
+
+    for(int j = 0; j < 5; j++)
+    {
+      ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+    }
+
+    /* every change past the threshold asks for a save, without waiting for it */
+    t0 = std::chrono::steady_clock::now();
+    for(int j = 0; j < 3000; j++)
+    {
+      details["max-runtime"] = j + 1;
+      ASSERT(ERROR_NO_ERROR == database.edit_job("job_" + std::to_string(j % 5),details));
+    }
+    t1 = std::chrono::steady_clock::now();
+
+    ASSERT(true == wait_for_save("./empty_db.json",5));
+
+    /* the saver thread might still be writing the last changes, wait for it to stop */
+  }
+
+  /* the JSON file and the journal together have all the changes */
+  KiwibesDatabase          reloaded;
+  std::vector<std::string> names;
+
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./empty_db.json"));
+  reloaded.get_all_job_names(names);
+  ASSERT(5 == names.size());
+
+  nlohmann::json job;
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_4"));
+  ASSERT(3000 == job["max-runtime"].get<unsigned long int>()); 
+
+  printf("[3000 changes in %.1f ms] ",std::chrono::duration<double,std::milli>(t1 - t0).count());
+}
+
+void test_database_saver_exit(void)
+{
+  nlohmann::json details;
+  nlohmann::json job;
+
+  /* without a journal, every change is left to the saver thread */
+  copy_test_database("single_job.json");
+  ASSERT(0 == mkdir("./single_job.json.journal",0700));
+  {
+    KiwibesDatabase database; 
+
+    ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+    details["max-runtime"] = 20;
+    ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  }
+  ASSERT(0 == rmdir("./single_job.json.journal"));
+  std::remove("./single_job.json.journal.tmp");
+
+  /* the save still pending at the exit was done */
+  KiwibesDatabase reloaded;
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+  ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+}
+
+void test_database_extra_fields(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  job;
+
+  /* a job description with a field unknown to the server */
+  copy_test_database("single_job.json");
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("./single_job.json"));
+    std::ofstream  dst("./single_job.json");
+
+    jobs["job_1"]["owner"] = "operations";
+    dst << jobs.dump(4) << std::endl;
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* the field is kept when the job changes */
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(std::string("operations") == job["owner"].get<std::string>());
+  ASSERT(1 == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(std::string("operations") == nlohmann::json::parse(file_contents("./single_job.json"))["job_1"]["owner"].get<std::string>());
+
+  /* fields with the wrong type make the database invalid */
+  {
+    std::ofstream dst("./single_job.json");
+
+    dst << "{ \"job_1\": { \"program\": [\"/bin/true\"], \"max-runtime\": \"ten\", \"avg-runtime\": 0.0, ";
+    dst << "\"var-runtime\": 0.0, \"schedule\": \"\", \"status\": \"stopped\", \"pending-start\": 0, ";
+    dst << "\"start-time\": 0, \"nbr-runs\": 0 } }" << std::endl;
+  }
+  std::remove("./single_job.json.journal");
+  ASSERT(ERROR_JOB_DESCRIPTION_INVALID == database.load("./single_job.json"));
+}
+
+void test_database_binary_snapshot(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("two_jobs.json");
+
+  /* the first load writes the binary snapshot of the JSON file */
+  database.set_binary_snapshot(true);
+  ASSERT(ERROR_NO_ERROR == database.load("./two_jobs.json"));
+  ASSERT(false == file_contents("./two_jobs.json.bin").empty());
+
+  details["max-runtime"] = 20;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_1",details));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* the snapshot follows the saved file, and the journal applies on top of it */
+  details["max-runtime"] = 30;
+  ASSERT(ERROR_NO_ERROR == database.edit_job("job_2",details));
+  {
+    KiwibesDatabase reloaded;
+
+    reloaded.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./two_jobs.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+    ASSERT(20 == job["max-runtime"].get<unsigned long int>()); 
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_2"));
+    ASSERT(30 == job["max-runtime"].get<unsigned long int>()); 
+  }
+
+  /* the snapshot is ignored once the JSON file is edited by hand */
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("./two_jobs.json"));
+    std::ofstream  dst("./two_jobs.json");
+
+    jobs["job_1"]["max-runtime"] = 40;
+    jobs.erase("job_2");
+    dst << jobs.dump(4) << std::endl;
+  }
+  std::remove("./two_jobs.json.journal");
+  {
+    KiwibesDatabase          reloaded;
+    std::vector<std::string> names;
+
+    reloaded.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./two_jobs.json"));
+    reloaded.get_all_job_names(names);
+    ASSERT(1 == names.size());
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+    ASSERT(40 == job["max-runtime"].get<unsigned long int>()); 
+  }
+
+  /* a corrupted snapshot falls back to the JSON file */
+  {
+    std::string   snapshot = file_contents("./two_jobs.json.bin");
+    std::ofstream dst("./two_jobs.json.bin");
+
+    snapshot[snapshot.size() - 1] ^= 0x20;
+    dst << snapshot;
+  }
+  {
+    KiwibesDatabase reloaded;
+
+    reloaded.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./two_jobs.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+    ASSERT(40 == job["max-runtime"].get<unsigned long int>()); 
+  }
+
+  std::remove("./two_jobs.json.bin");
+}
+
+void test_database_startup_benchmark(void)
+{
+  std::vector<std::string> names;
+
+  /* a database with 50000 jobs */
+  {
+    nlohmann::json jobs = nlohmann::json::parse(file_contents("../tests/data/databases/single_job.json"));
+    nlohmann::json job  = jobs["job_1"];
+    std::ofstream  dst("./many_jobs.json");
+
+    for(int j = 0; j < 50000; j++)
+    {
+      jobs["job_" + std::to_string(j)] = job;
+    }
+    dst << jobs.dump(4) << std::endl;
+  }
+  std::remove("./many_jobs.json.journal");
+  std::remove("./many_jobs.json.bin");
+
+  /* the first load parses the JSON file and writes the binary snapshot */
+  {
+    KiwibesDatabase database; 
+
+    database.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == database.load("./many_jobs.json"));
+  }
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  {
+    KiwibesDatabase database; 
+
+    ASSERT(ERROR_NO_ERROR == database.load("./many_jobs.json"));
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  {
+    KiwibesDatabase database; 
+
+    database.set_binary_snapshot(true);
+    ASSERT(ERROR_NO_ERROR == database.load("./many_jobs.json"));
+    database.get_all_job_names(names);
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  ASSERT(50000 == names.size());
+
+  double json   = std::chrono::duration<double,std::milli>(t1 - t0).count();
+  double binary = std::chrono::duration<double,std::milli>(t2 - t1).count();
+
+  printf("[50000 jobs: %.1f ms from JSON, %.1f ms from the binary snapshot] ",json,binary);
+  ASSERT(binary < json);
+
+  std::remove("./many_jobs.json");
+  std::remove("./many_jobs.json.journal");
+  std::remove("./many_jobs.json.bin");
+}
+
+/** Request, start and stop a job, as the database did when it kept the jobs as JSON,
+    with per-field lookups under a single lock. The run is journaled as it is now.
+
+  @param dbjobs   the JSON descriptions of the jobs
+  @param dblock   the lock of the database
+  @param journal  the file descriptor of the journal
+  @param name     the name of the job
+ */
+static void json_transition(nlohmann::json *dbjobs, std::mutex *dblock, int journal, const std::string &name)
+{
+  {
+    std::lock_guard<std::mutex> lock(*dblock);
+
+    if(1 == (*dbjobs).count(name))
+    {
+      LOG_INFO << "incremented start requests for job '" << name << "'";
+
+      signed int pending_start = (*dbjobs)[name]["pending-start"].get<signed int>();
+      pending_start++;
+      (*dbjobs)[name]["pending-start"] = pending_start;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(*dblock);
+
+    if((1 == (*dbjobs).count(name)) && (0 < (*dbjobs)[name]["pending-start"].get<signed int>()))
+    {
+      LOG_INFO << "decremented start requests for job '" << name << "'";
+
+      signed int pending_start = (*dbjobs)[name]["pending-start"].get<signed int>();
+      pending_start--;
+      (*dbjobs)[name]["pending-start"] = pending_start;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(*dblock);
+
+    if((1 == (*dbjobs).count(name)) && (std::string("running") != (*dbjobs)[name]["status"].get<std::string>()))
+    {
+      LOG_INFO << "has started, job '" << name << "'";
+
+      (*dbjobs)[name]["status"]     = "running";
+      (*dbjobs)[name]["start-time"] = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(*dblock);
+
+    if((1 == (*dbjobs).count(name)) && (std::string("stopped") != (*dbjobs)[name]["status"].get<std::string>()))
+    {
+      LOG_INFO << "has stopped, job '" << name << "'";
+
+      std::time_t       now     = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+      std::time_t       runtime = now - (*dbjobs)[name]["start-time"].get<std::time_t>();
+      unsigned long int runs    = (*dbjobs)[name]["nbr-runs"].get<unsigned long int>() + 1;
+      double            avg     = (*dbjobs)[name]["avg-runtime"].get<double>();
+      double            var     = (*dbjobs)[name]["var-runtime"].get<double>();
+      double            delta   = 1.0*(runtime - avg); 
+      nlohmann::json    record;
+
+      avg += delta/runs; 
+      var += delta*(runtime - avg);
+
+      (*dbjobs)[name]["status"]      = "stopped";
+      (*dbjobs)[name]["start-time"]  = 0;
+      (*dbjobs)[name]["avg-runtime"] = avg;
+      (*dbjobs)[name]["var-runtime"] = var;
+      (*dbjobs)[name]["nbr-runs"]    = runs;
+
+      record["op"]                 = "run";
+      record["name"]               = name;
+      record["run"]["start"]       = 1000*now;
+      record["run"]["duration"]    = 1000*runtime;
+      record["run"]["exit-status"] = 0;
+      record["run"]["signal"]      = 0;
+      record["run"]["cpu-user"]    = 0;
+      record["run"]["cpu-system"]  = 0;
+      record["run"]["memory-peak"] = 0;
+      record["run"]["io-read"]     = 0;
+      record["run"]["io-write"]    = 0;
+      record["run"]["timed-out"]   = false;
+
+      std::string line = record.dump() + "\n";
+      ASSERT((ssize_t)line.size() == write(journal,line.c_str(),line.size()));
+    }
+  }
+}
+
+void test_database_job_record_benchmark(void)
+{
+  KiwibesDatabase          database; 
+  nlohmann::json           jobs;
+  std::mutex               dblock;
+  std::vector<std::string> names;
+  nlohmann::json           job;
+
+  /* a database with 2000 jobs, loaded from file */
+  {
+    nlohmann::json single = nlohmann::json::parse(file_contents("../tests/data/databases/single_job.json"));
+    std::ofstream  dst("./many_records.json");
+
+    for(int j = 0; j < 2000; j++)
+    {
+      names.push_back("job_" + std::to_string(j));
+      jobs[names[j]] = single["job_1"];
+    }
+    dst << jobs.dump(4) << std::endl;
+  }
+  std::remove("./many_records.json.journal");
+  ASSERT(ERROR_NO_ERROR == database.load("./many_records.json"));
+
+  int journal = open("./many_records.json.baseline",O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+  ASSERT(0 <= journal);
+
+  /* the transitions stay below the records that trigger a save of the database */
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(size_t t = 0; t < 1500; t++)
+  {
+    json_transition(&jobs,&dblock,journal,names[t % names.size()]);
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  for(size_t t = 0; t < 1500; t++)
+  {
+    const std::string &name = names[t % names.size()];
+
+    ASSERT(ERROR_NO_ERROR == database.job_incr_start_requests(name));
+    ASSERT(0 == database.job_decr_start_requests(name));
+    ASSERT(ERROR_NO_ERROR == database.job_started(name));
+    ASSERT(ERROR_NO_ERROR == database.job_stopped(name));
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+  close(journal);
+
+  /* both paths ran the same jobs */
+  for(size_t j = 0; j < names.size(); j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,names[j]));
+    ASSERT(jobs[names[j]]["nbr-runs"].get<unsigned long int>() == job["nbr-runs"].get<unsigned long int>());
+    ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  }
+
+  double json  = std::chrono::duration<double,std::nano>(t1 - t0).count()/1500;
+  double typed = std::chrono::duration<double,std::nano>(t2 - t1).count()/1500;
+
+  printf("[per transition: %.0f ns with JSON fields, %.0f ns with job records] ",json,typed);
+  ASSERT(typed < json);
+
+  std::remove("./many_records.json");
+  std::remove("./many_records.json.journal");
+  std::remove("./many_records.json.baseline");
+}
+
+/** Read the database until asked to stop, every millisecond as a dashboard polling it
+
+  @param database   the database
+  @param serialize  if not NULL, the lock taken around each read
+  @param done       set to true when the reader should stop
+  @param latencies  on return, contains the duration of each read, in microseconds
+ */
+static void contention_reader(KiwibesDatabase *database, std::mutex *serialize, std::atomic<bool> *done, std::vector<double> *latencies)
+{
+  std::vector<std::string> names;
+  nlohmann::json           job;
+
+  while(false == *done)
+  {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    {
+      std::unique_lock<std::mutex> lock;
+      if(nullptr != serialize)
+      {
+        lock = std::unique_lock<std::mutex>(*serialize);
+      }
+
+      database->get_all_job_names(names);
+      database->get_job_description(job,names[latencies->size() % names.size()]);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    latencies->push_back(std::chrono::duration<double,std::micro>(t1 - t0).count());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+/** Read the database from 32 threads, while this thread changes it
+
+  @param database   the database
+  @param serialize  if not NULL, readers and writer take this lock, as a single lock database would
+  @param reads      on return, contains the number of reads done
+  @param writes     on return, contains the number of changes done
+  @param latency    on return, contains the median duration of the reads, in microseconds
+ */
+static void contention_run(KiwibesDatabase *database, std::mutex *serialize, unsigned long int *reads, unsigned long int *writes, double *latency)
+{
+  std::atomic<bool>                done(false);
+  std::vector<std::vector<double> > latencies(32);
+  std::vector<std::thread>          readers;
+
+  for(size_t r = 0; r < latencies.size(); r++)
+  {
+    readers.push_back(std::thread(contention_reader,database,serialize,&done,&latencies[r]));
+  }
+
+  /* the writer keeps starting and stopping a job, syncing each change to disk */
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+  *writes = 0;
+  while(std::chrono::steady_clock::now() < end)
+  {
+    std::unique_lock<std::mutex> lock;
+    if(nullptr != serialize)
+    {
+      lock = std::unique_lock<std::mutex>(*serialize);
+    }
+
+    database->job_started("job_1");
+    database->job_stopped("job_1");
+    *writes += 2;
+  }
+
+  done = true;
+  std::vector<double> all;
+
+  for(size_t r = 0; r < readers.size(); r++)
+  {
+    readers[r].join();
+    all.insert(all.end(),latencies[r].begin(),latencies[r].end());
+  }
+  std::sort(all.begin(),all.end());
+  *reads   = all.size();
+  *latency = (0 < all.size()) ? all[all.size()/2] : 0.0;
+}
+
+void test_database_readers_benchmark(void)
+{
+  KiwibesDatabase   database; 
+  std::mutex        serialize;
+  unsigned long int locked_reads;
+  unsigned long int locked_writes;
+  unsigned long int free_reads;
+  unsigned long int free_writes;
+  double            locked_latency;
+  double            free_latency;
+
+  copy_test_database("two_jobs.json");
+  database.set_journal_sync(JOURNAL_SYNC_ALWAYS);
+  ASSERT(ERROR_NO_ERROR == database.load("./two_jobs.json"));
+
+  contention_run(&database,&serialize,&locked_reads,&locked_writes,&locked_latency);
+  contention_run(&database,nullptr,&free_reads,&free_writes,&free_latency);
+
+  printf("[32 readers, 1 writer: %lu reads, %lu changes, median read %.0f us with a single lock, %lu reads, %lu changes, median read %.0f us with snapshots] ",
+         locked_reads,locked_writes,locked_latency,free_reads,free_writes,free_latency);
+  ASSERT((0 < locked_writes) && (0 < free_writes));
+
+  /* with snapshots, the readers do not wait for the changes to be synced to disk. The
+     latencies depend on the host, so they are only reported */
+  ASSERT((0 < locked_reads) && (0 < free_reads));
+
+  /* the readers saw consistent descriptions */
+  nlohmann::json job;
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+}
+
+void test_database_journal_benchmark(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+
+  copy_test_database("empty_db.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  for(int j = 0; j < 2000; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+  }
+
+  /* completions with the journal */
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(int j = 0; j < 2000; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("job_" + std::to_string(j)));
+    ASSERT(ERROR_NO_ERROR == database.job_stopped("job_" + std::to_string(j)));
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  /* completions when saving the whole database each time */
+  for(int j = 0; j < 100; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("job_" + std::to_string(j)));
+    ASSERT(ERROR_NO_ERROR == database.job_stopped("job_" + std::to_string(j)));
+    ASSERT(ERROR_NO_ERROR == database.save());
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  double journal = 2000.0/std::chrono::duration<double>(t1 - t0).count();
+  double rewrite = 100.0/std::chrono::duration<double>(t2 - t1).count();
+
+  printf("[2000 jobs: %.0f completions/s with journal, %.0f completions/s with rewrite] ",journal,rewrite);
+  ASSERT(journal > rewrite);
+}
+
+/** Start and stop each of the given jobs a number of times
+
+  @param database   the database
+  @param first      number of the first job of the thread
+  @param count      number of jobs of the thread
+  @param rounds     number of times each job runs
+ */
+static void scaling_worker(KiwibesDatabase *database, int first, int count, int rounds)
+{
+  for(int r = 0; r < rounds; r++)
+  {
+    for(int j = first; j < (first + count); j++)
+    {
+      database->job_started("job_" + std::to_string(j));
+      database->job_stopped("job_" + std::to_string(j));
+    }
+  }
+}
+
+void test_database_shards_benchmark(void)
+{
+  KiwibesDatabase     database; 
+  nlohmann::json      details;
+  std::string         results;
+  std::vector<double> rates;
+
+  copy_test_database("empty_db.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  for(int j = 0; j < 64; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+  }
+
+  /* the same number of transitions, spread over more threads, each with its own jobs,
+     and each stopped run is synced to disk before the transition returns */
+  database.set_journal_sync(JOURNAL_SYNC_ALWAYS);
+  for(int threads = 1; threads <= 32; threads *= 2)
+  {
+    std::vector<std::thread> workers;
+    char                     result[64];
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for(int t = 0; t < threads; t++)
+    {
+      workers.push_back(std::thread(scaling_worker,&database,t*(64/threads),64/threads,20));
+    }
+    for(size_t t = 0; t < workers.size(); t++)
+    {
+      workers[t].join();
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    rates.push_back(2*64*20/std::chrono::duration<double>(t1 - t0).count());
+    snprintf(result,sizeof(result),"%s%d: %.0f/s",(1 == threads) ? "" : ", ",threads,rates.back());
+    results += result;
+  }
+  /* the threads of other shards share the writes and syncs of the journal, the rates
+     depend on the host so they are only reported */
+  printf("[transitions by number of threads, %s] ",results.c_str());
+  ASSERT(6 == rates.size());
+
+  /* no transition was lost, and the saved database has all the jobs */
+  nlohmann::json job;
+
+  ASSERT(ERROR_NO_ERROR == database.save());
+  for(int j = 0; j < 64; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_" + std::to_string(j)));
+    ASSERT(6*20 == job["nbr-runs"].get<unsigned long int>());
+    ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  }
+
+  nlohmann::json saved = nlohmann::json::parse(file_contents("./empty_db.json"));
+  ASSERT(64 == saved.size());
+  ASSERT(6*20 == saved["job_63"]["nbr-runs"].get<unsigned long int>());
+}
+
+void test_database_shards_save(void)
+{
+  KiwibesDatabase database; 
+  KiwibesDatabase restored; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("empty_db.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  for(int j = 0; j < 100; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+  }
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* only some of the shards change before the next save */
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_7"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_7"));
+  ASSERT(ERROR_NO_ERROR == database.delete_jobs(std::vector<std::string>({ "job_3", "job_42", "job_99" })));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  nlohmann::json saved = nlohmann::json::parse(file_contents("./empty_db.json"));
+  ASSERT(97 == saved.size());
+  ASSERT(0 == saved.count("job_42"));
+  ASSERT(1 == saved["job_7"]["nbr-runs"].get<unsigned long int>());
+
+  /* all the shards are empty once every job is deleted */
+  std::vector<std::string> names;
+
+  database.get_all_job_names(names);
+  ASSERT(97 == names.size());
+  ASSERT(true == std::is_sorted(names.begin(),names.end()));
+  ASSERT(ERROR_NO_ERROR == database.delete_jobs(names));
+  ASSERT(ERROR_NO_ERROR == database.save());
+  ASSERT(std::string("{}\n") == file_contents("./empty_db.json"));
+
+  ASSERT(ERROR_NO_ERROR == restored.load("./empty_db.json"));
+  restored.get_all_job_names(names);
+  ASSERT(0 == names.size());
+}
+
+void test_database_group_commit(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  job;
+
+  copy_test_database("single_job.json");
+  ASSERT(ERROR_NO_ERROR == database.load("./single_job.json"));
+  ASSERT(ERROR_NO_ERROR == database.save());
+
+  /* the changes are buffered until the delay expires */
+  database.set_group_commit(60000);
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+
+  std::string contents = file_contents("./single_job.json.journal");
+  ASSERT(1 == std::count(contents.begin(),contents.end(),'\n'));
+
+  /* the barrier writes them all at once */
+  ASSERT(ERROR_NO_ERROR == database.barrier());
+  contents = file_contents("./single_job.json.journal");
+  ASSERT(3 == std::count(contents.begin(),contents.end(),'\n'));
+
+  {
+    KiwibesDatabase reloaded;
+
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+    ASSERT(2 == job["nbr-runs"].get<unsigned long int>());
+  }
+
+  /* without a barrier, the changes are written once the delay expires */
+  database.set_group_commit(10);
+  ASSERT(ERROR_NO_ERROR == database.job_started("job_1"));
+  ASSERT(ERROR_NO_ERROR == database.job_stopped("job_1"));
+
+  bool written = false;
+  for(int t = 0; (false == written) && (t < 100); t++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    contents = file_contents("./single_job.json.journal");
+    written  = (4 == std::count(contents.begin(),contents.end(),'\n'));
+  }
+  ASSERT(true == written);
+
+  /* buffered changes are not lost when the database is destroyed */
+  {
+    KiwibesDatabase buffered;
+
+    ASSERT(ERROR_NO_ERROR == buffered.load("./single_job.json"));
+    buffered.set_group_commit(60000);
+    ASSERT(ERROR_NO_ERROR == buffered.job_started("job_1"));
+    ASSERT(ERROR_NO_ERROR == buffered.job_stopped("job_1"));
+  }
+  {
+    KiwibesDatabase reloaded;
+
+    ASSERT(ERROR_NO_ERROR == reloaded.load("./single_job.json"));
+    ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_1"));
+    ASSERT(4 == job["nbr-runs"].get<unsigned long int>());
+  }
+}
+
+void test_database_group_commit_benchmark(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  details;
+  nlohmann::json  job;
+
+  copy_test_database("empty_db.json");
+  database.set_journal_sync(JOURNAL_SYNC_ALWAYS);
+  ASSERT(ERROR_NO_ERROR == database.load("./empty_db.json"));
+
+  details["program"]     = std::vector<std::string>({ "/bin/true" });
+  details["schedule"]    = "1 2 3 4 5 6";
+  details["max-runtime"] = 5;
+
+  for(int j = 0; j < 500; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.create_job("job_" + std::to_string(j),details));
+  }
+
+  /* many jobs finish together, each completion is synced to disk */
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(int j = 0; j < 500; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("job_" + std::to_string(j)));
+    ASSERT(ERROR_NO_ERROR == database.job_stopped("job_" + std::to_string(j)));
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+  /* the completions are synced to disk in batches */
+  database.set_group_commit(50);
+  for(int j = 0; j < 500; j++)
+  {
+    ASSERT(ERROR_NO_ERROR == database.job_started("job_" + std::to_string(j)));
+    ASSERT(ERROR_NO_ERROR == database.job_stopped("job_" + std::to_string(j)));
+  }
+  ASSERT(ERROR_NO_ERROR == database.barrier());
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  double single = 500.0/std::chrono::duration<double>(t1 - t0).count();
+  double group  = 500.0/std::chrono::duration<double>(t2 - t1).count();
+
+  printf("[500 completions: %.0f/s synced one by one, %.0f/s with group commit] ",single,group);
+
+  KiwibesDatabase reloaded;
+
+  ASSERT(ERROR_NO_ERROR == reloaded.load("./empty_db.json"));
+  ASSERT(ERROR_NO_ERROR == reloaded.get_job_description(job,"job_499"));
+  ASSERT(2 == job["nbr-runs"].get<unsigned long int>());
+}
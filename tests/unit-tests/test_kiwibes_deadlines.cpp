@@ -0,0 +1,130 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the deadlines of the running jobs.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_deadlines.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <signal.h>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_deadlines_order(void)
+{
+  KiwibesDeadlines  deadlines(1000000);
+  T_PROCESS_HANDLER handle = INVALID_PROCESS_HANDLE;
+
+  /* start without deadlines */
+  ASSERT(0 == deadlines.size());
+  ASSERT(-1 == deadlines.next());
+  ASSERT(0 == deadlines.expire(1000000,handle));
+
+  /* add the deadlines in random order */
+  std::vector<int64_t> instants;
+  std::mt19937         generator(42);
+
+  for(T_PROCESS_HANDLER p = 100; p < 1100; p++)
+  {
+    int64_t deadline = 1000 + (generator() % 100000);
+
+    ASSERT(true == deadlines.insert(p,deadline));
+    instants.push_back(deadline);
+  }
+  ASSERT(1000 == deadlines.size());
+  ASSERT(*std::min_element(instants.begin(),instants.end()) == deadlines.next());
+
+  /* a process cannot have two deadlines */
+  ASSERT(false == deadlines.insert(100,1));
+  ASSERT(1000 == deadlines.size());
+
+  /* removing the processes which did not expire keeps the heap ordered */
+  for(T_PROCESS_HANDLER p = 100; p < 1100; p += 2)
+  {
+    ASSERT(false == deadlines.remove(p));
+    instants[p - 100] = -1;
+  }
+  ASSERT(500 == deadlines.size());
+  ASSERT(false == deadlines.remove(100));
+
+  /* the deadlines expire earliest first, and never before their instant */
+  int64_t previous = 0;
+
+  ASSERT(0 == deadlines.expire(1000 - 1,handle));
+  for(size_t e = 0; e < 500; e++)
+  {
+    int64_t now = deadlines.next();
+
+    ASSERT(previous <= now);
+    ASSERT(SIGTERM == deadlines.expire(now,handle));
+    ASSERT(1 == (handle % 2));
+    ASSERT(instants[handle - 100] == now);
+    previous = now;
+  }
+
+  /* after the grace period, which is longer than all the deadlines, they expire again */
+  ASSERT(500 == deadlines.size());
+  ASSERT(SIGKILL == deadlines.expire(deadlines.next(),handle));
+  ASSERT(499 == deadlines.size());
+}
+
+void test_deadlines_escalation(void)
+{
+  KiwibesDeadlines  deadlines(5000);
+  T_PROCESS_HANDLER handle = INVALID_PROCESS_HANDLE;
+
+  ASSERT(true == deadlines.insert(100,10000));
+  ASSERT(true == deadlines.insert(200,12000));
+  ASSERT(true == deadlines.insert(300,20000));
+
+  /* the first process is asked to terminate, and killed after the grace period */
+  ASSERT(0 == deadlines.expire(9999,handle));
+  ASSERT(SIGTERM == deadlines.expire(10000,handle));
+  ASSERT(100 == handle);
+  ASSERT(3 == deadlines.size());
+  ASSERT(12000 == deadlines.next());
+
+  /* the second one exits after being asked to terminate */
+  ASSERT(SIGTERM == deadlines.expire(12000,handle));
+  ASSERT(200 == handle);
+  ASSERT(15000 == deadlines.next());
+  ASSERT(true == deadlines.remove(200));
+
+  ASSERT(0 == deadlines.expire(14999,handle));
+  ASSERT(SIGKILL == deadlines.expire(15000,handle));
+  ASSERT(100 == handle);
+  ASSERT(1 == deadlines.size());
+  ASSERT(20000 == deadlines.next());
+
+  /* the killed process is no longer in the heap, but it remains expired until it exits */
+  ASSERT(false == deadlines.insert(100,30000));
+  ASSERT(true == deadlines.remove(100));
+  ASSERT(false == deadlines.remove(100));
+
+  /* the last one exits on its own */
+  ASSERT(false == deadlines.remove(300));
+  ASSERT(0 == deadlines.size());
+  ASSERT(-1 == deadlines.next());
+  ASSERT(0 == deadlines.expire(1000000,handle));
+}
@@ -0,0 +1,98 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the table of start invocations.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_invocations.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_invocations_status(void)
+{
+  KiwibesInvocations invocations(2);
+  T_INVOCATION       invocation;
+
+  /* unknown invocations */
+  ASSERT(ERROR_INVOCATION_UNKNOWN == invocations.get(invocation,1,0));
+
+  /* new invocations are queued, with increasing identifiers */
+  uint64_t first  = invocations.create("job_1");
+  uint64_t second = invocations.create("job_2");
+  ASSERT(0 < first);
+  ASSERT(first < second);
+
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,first,0));
+  ASSERT(first == invocation.id);
+  ASSERT(std::string("job_1") == invocation.name);
+  ASSERT(INVOCATION_QUEUED == invocation.status);
+
+  /* the outcome is kept once it is handled */
+  invocations.finish(first,INVOCATION_FAILED,ERROR_JOB_NAME_UNKNOWN);
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,first,0));
+  ASSERT(INVOCATION_FAILED == invocation.status);
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == invocation.error);
+
+  /* only the last handled invocations are remembered, the queued ones are kept */
+  uint64_t third = invocations.create("job_3");
+  invocations.finish(third,INVOCATION_STARTED,ERROR_NO_ERROR);
+  uint64_t fourth = invocations.create("job_4");
+  invocations.finish(fourth,INVOCATION_PENDING,ERROR_NO_ERROR);
+
+  ASSERT(ERROR_INVOCATION_UNKNOWN == invocations.get(invocation,first,0));
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,second,0));
+  ASSERT(INVOCATION_QUEUED == invocation.status);
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,fourth,0));
+  ASSERT(INVOCATION_PENDING == invocation.status);
+  ASSERT(3 == invocations.size());
+}
+
+void test_invocations_wait(void)
+{
+  KiwibesInvocations invocations(16);
+  T_INVOCATION       invocation;
+  uint64_t           id = invocations.create("job_1");
+
+  /* waiting for a queued invocation times out */
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,id,100));
+  ASSERT(INVOCATION_QUEUED == invocation.status);
+  ASSERT(std::chrono::milliseconds(100) <= std::chrono::steady_clock::now() - start);
+
+  /* the caller is woken up as soon as it is handled */
+  std::thread launcher([&invocations,id]()
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    invocations.finish(id,INVOCATION_STARTED,ERROR_NO_ERROR);
+  });
+
+  start = std::chrono::steady_clock::now();
+
+  ASSERT(ERROR_NO_ERROR == invocations.get(invocation,id,5000));
+  ASSERT(INVOCATION_STARTED == invocation.status);
+  ASSERT(std::chrono::milliseconds(1000) > std::chrono::steady_clock::now() - start);
+
+  launcher.join();
+}
@@ -0,0 +1,213 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+  Implements the unit tests for the runtime sketch and the history of runs.
+ */
+#include "unit_tests.h"
+#include "kiwibes_job_history.h"
+
+#include <cmath>
+
+/*----------------------- Private Functions Definitions -----------*/
+/** Return true if a value is within the accuracy of the sketch
+
+  @param value      the value returned by the sketch
+  @param expected   the exact value
+ */
+static bool within_accuracy(double value, double expected)
+{
+  return std::fabs(value - expected) <= 0.01*expected;
+}
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_runtime_sketch_quantiles(void)
+{
+  KiwibesRuntimeSketch sketch;
+
+  /* an empty sketch */
+  ASSERT(0 == sketch.count());
+  ASSERT(0.0 == sketch.quantile(0.5));
+
+  /* runtimes from 1 ms to 10 s */
+  for(int r = 1; r <= 10000; r++)
+  {
+    sketch.add(r);
+  }
+
+  ASSERT(10000 == sketch.count());
+  ASSERT(0 == sketch.zeros());
+  ASSERT(true == within_accuracy(sketch.quantile(0.0),1.0));
+  ASSERT(true == within_accuracy(sketch.quantile(0.50),5000.5));
+  ASSERT(true == within_accuracy(sketch.quantile(0.95),9500.05));
+  ASSERT(true == within_accuracy(sketch.quantile(0.99),9900.01));
+  ASSERT(true == within_accuracy(sketch.quantile(1.0),10000.0));
+
+  /* runtimes shorter than 1 ms */
+  sketch.add(0.0);
+  sketch.add(0.5);
+  ASSERT(2 == sketch.zeros());
+  ASSERT(0.0 == sketch.quantile(0.0));
+
+  /* the number of bins is bounded, the highest quantiles keep their accuracy */
+  KiwibesRuntimeSketch wide;
+  double               largest = 0.0;
+
+  for(double r = 1.0; r < 1e30; r *= 1.01)
+  {
+    wide.add(r);
+    largest = r;
+  }
+  ASSERT(1024 >= wide.bins().size());
+  ASSERT(true == within_accuracy(wide.quantile(1.0),largest));
+  ASSERT(1e29 < wide.quantile(0.99));
+}
+
+void test_runtime_sketch_merge(void)
+{
+  KiwibesRuntimeSketch low;
+  KiwibesRuntimeSketch high;
+  KiwibesRuntimeSketch all;
+
+  for(int r = 1; r <= 1000; r++)
+  {
+    low.add(r);
+    high.add(1000 + r);
+    all.add(r);
+    all.add(1000 + r);
+  }
+  low.add(0.0);
+  all.add(0.0);
+
+  low.merge(high);
+  ASSERT(all.count() == low.count());
+  ASSERT(all.zeros() == low.zeros());
+  ASSERT(all.bins() == low.bins());
+  ASSERT(all.quantile(0.99) == low.quantile(0.99));
+
+  /* the JSON representation keeps all the bins */
+  KiwibesRuntimeSketch restored;
+
+  ASSERT(true == restored.from_json(all.to_json()));
+  ASSERT(all.count() == restored.count());
+  ASSERT(all.bins() == restored.bins());
+
+  ASSERT(false == restored.from_json(nlohmann::json::parse("{\"zeros\": 1}")));
+  ASSERT(false == restored.from_json(nlohmann::json::parse("{\"zeros\": 1, \"bins\": [[1]]}")));
+  ASSERT(false == restored.from_json(nlohmann::json::parse("{\"zeros\": \"one\", \"bins\": []}")));
+  ASSERT(all.count() == restored.count());
+}
+
+void test_run_history(void)
+{
+  KiwibesRunHistory history;
+  KiwibesRunHistory restored;
+
+  ASSERT(0 == history.size());
+
+  /* the oldest runs are replaced once the history is full */
+  for(int r = 0; r < JOB_HISTORY_MAX_RUNS + 5; r++)
+  {
+    T_JOB_RUN run = { 1000*r, r, r % 3, 0, 10*r, r, 1024*r, 0, 4096 };
+    history.add(run);
+  }
+
+  ASSERT(JOB_HISTORY_MAX_RUNS == history.size());
+  ASSERT(5 == history.at(0).duration);
+  ASSERT(JOB_HISTORY_MAX_RUNS + 4 == history.at(JOB_HISTORY_MAX_RUNS - 1).duration);
+
+  for(size_t r = 1; r < history.size(); r++)
+  {
+    ASSERT(history.at(r - 1).start < history.at(r).start);
+  }
+
+  /* the JSON representation has the oldest run first */
+  nlohmann::json runs = history.to_json();
+
+  ASSERT(JOB_HISTORY_MAX_RUNS == runs.size());
+  ASSERT(5000 == runs[0]["start"].get<int64_t>());
+  ASSERT(2 == runs[0]["exit-status"].get<int32_t>());
+  ASSERT(50 == runs[0]["cpu-user"].get<int64_t>());
+  ASSERT(5*1024 == runs[0]["memory-peak"].get<int64_t>());
+  ASSERT(4096 == runs[0]["io-write"].get<int64_t>());
+
+  ASSERT(true == restored.from_json(runs));
+  ASSERT(history.size() == restored.size());
+  ASSERT(history.at(0).start == restored.at(0).start);
+  ASSERT(history.at(JOB_HISTORY_MAX_RUNS - 1).start == restored.at(JOB_HISTORY_MAX_RUNS - 1).start);
+  ASSERT(history.at(0).cpu_user == restored.at(0).cpu_user);
+  ASSERT(history.at(0).cpu_system == restored.at(0).cpu_system);
+  ASSERT(history.at(0).memory_peak == restored.at(0).memory_peak);
+  ASSERT(history.at(0).io_write == restored.at(0).io_write);
+
+  /* the runs of older databases have no resources */
+  ASSERT(true == restored.from_json(nlohmann::json::parse("[{\"start\": 1, \"duration\": 2, \"exit-status\": 0, \"signal\": 0}]")));
+  ASSERT(1 == restored.size());
+  ASSERT(0 == restored.at(0).cpu_user);
+  ASSERT(0 == restored.at(0).memory_peak);
+
+  ASSERT(false == restored.from_json(nlohmann::json::parse("[{\"start\": 1}]")));
+  ASSERT(false == restored.from_json(nlohmann::json::parse("{}")));
+}
+
+void test_run_statistics(void)
+{
+  KiwibesRunStatistics stats;
+  int64_t              now = 1000000000000LL;
+
+  ASSERT(0 == stats.runs());
+  ASSERT(0.0 == stats.mean_runtime());
+  ASSERT(0 == stats.recent_runs(now));
+
+  /* one run ending in each of the last two minutes, one of every ten fails */
+  for(int r = 0; r < 120; r++)
+  {
+    T_JOB_RUN run = { now - 1000*r - 500, 500, (0 == (r % 10)) ? 1 : 0, 0 };
+    stats.add(run);
+  }
+
+  ASSERT(120 == stats.runs());
+  ASSERT(12 == stats.failures());
+  ASSERT(500.0 == stats.mean_runtime());
+  ASSERT(60 == stats.recent_runs(now));
+  ASSERT(30 == stats.recent_runs(now + 30000));
+  ASSERT(0 == stats.recent_runs(now + 60000));
+  ASSERT(true == within_accuracy(stats.sketch().quantile(0.5),500.0));
+
+  /* the runtimes are counted in the bucket of their upper bound */
+  T_JOB_RUN killed = { now, 2*3600*1000, -1, 9 };
+  T_JOB_RUN minute = { now, 60*1000, 0, 0 };
+
+  stats.add(killed);
+  stats.add(minute);
+
+  nlohmann::json json = stats.to_json(now);
+
+  ASSERT(122 == json["runs"].get<uint64_t>());
+  ASSERT(13 == json["failed-runs"].get<uint64_t>());
+  ASSERT(120 == json["runtime-histogram"]["1"].get<uint64_t>());
+  ASSERT(1 == json["runtime-histogram"]["60"].get<uint64_t>());
+  ASSERT(0 == json["runtime-histogram"]["3600"].get<uint64_t>());
+  ASSERT(1 == json["runtime-histogram"]["+inf"].get<uint64_t>());
+
+  stats.clear();
+  ASSERT(0 == stats.runs());
+  ASSERT(0 == stats.recent_runs(now));
+}
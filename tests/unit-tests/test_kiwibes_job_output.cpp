@@ -0,0 +1,295 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+   
+  Summary
+  -------
+  Implements the unit tests for the store of the output of the jobs.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_job_output.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_job_output_capture(void)
+{
+  KiwibesJobOutput output(64,4);
+  std::string      data;
+  bool             finished = false;
+  uint64_t         run      = 0;
+  uint64_t         offset   = 0;
+  int              fds[2];
+
+  /* nothing is kept for unknown jobs */
+  ASSERT(ERROR_OUTPUT_UNKNOWN == output.read(data,finished,"job_1",run,offset,64,0));
+
+  ASSERT(0 == pipe2(fds,O_NONBLOCK));
+  ASSERT(1 == output.capture("job_1",fds[0]));
+
+  /* the output is read once drained */
+  ASSERT(9 == write(fds[1],"hello\nwo\n",9));
+  ASSERT(true == output.drain(fds[0]));
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(std::string("hello\nwo\n") == data);
+  ASSERT(1 == run);
+  ASSERT(9 == offset);
+  ASSERT(false == finished);
+
+  /* nothing more to read, the read times out */
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,10));
+  ASSERT(true == data.empty());
+  ASSERT(false == finished);
+
+  /* the run finishes once the pipe is closed */
+  close(fds[1]);
+  ASSERT(false == output.drain(fds[0]));
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,1000));
+  ASSERT(true == data.empty());
+  ASSERT(true == finished);
+
+  /* a pipe no longer captured is ignored */
+  ASSERT(false == output.drain(fds[0]));
+}
+
+void test_job_output_ring(void)
+{
+  KiwibesJobOutput output(8,4);
+  std::string      data;
+  bool             finished = false;
+  uint64_t         run      = 0;
+  uint64_t         offset   = 0;
+  int              fds[2];
+
+  ASSERT(0 == pipe2(fds,O_NONBLOCK));
+  output.capture("job_1",fds[0]);
+
+  /* only the latest bytes are kept */
+  ASSERT(12 == write(fds[1],"0123456789ab",12));
+  ASSERT(true == output.drain(fds[0]));
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(std::string("456789ab") == data);
+  ASSERT(12 == offset);
+
+  /* the offset skips over the bytes which were lost */
+  ASSERT(6 == write(fds[1],"cdefgh",6));
+  ASSERT(true == output.drain(fds[0]));
+  offset = 2;
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,3,0));
+  ASSERT(std::string("abc") == data);
+  ASSERT(13 == offset);
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(std::string("defgh") == data);
+  ASSERT(18 == offset);
+
+  close(fds[1]);
+  ASSERT(false == output.drain(fds[0]));
+}
+
+void test_job_output_runs(void)
+{
+  KiwibesJobOutput output(64,2);
+  std::string      data;
+  bool             finished = false;
+  uint64_t         run      = 0;
+  uint64_t         offset   = 0;
+  int              fds[3][2];
+
+  /* the first run is still running, the second one finished */
+  for(int r = 0; r < 2; r++)
+  {
+    ASSERT(0 == pipe2(fds[r],O_NONBLOCK));
+    ASSERT((uint64_t)(r + 1) == output.capture("job_1",fds[r][0]));
+    ASSERT(1 == write(fds[r][1],(0 == r) ? "a" : "b",1));
+    ASSERT(true == output.drain(fds[r][0]));
+  }
+  close(fds[1][1]);
+  ASSERT(false == output.drain(fds[1][0]));
+
+  /* the finished run is forgotten first */
+  ASSERT(0 == pipe2(fds[2],O_NONBLOCK));
+  ASSERT(3 == output.capture("job_1",fds[2][0]));
+
+  run = 2;
+  ASSERT(ERROR_OUTPUT_UNKNOWN == output.read(data,finished,"job_1",run,offset,64,0));
+  run = 1;
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(std::string("a") == data);
+
+  /* the latest run is read by default */
+  run    = 0;
+  offset = 0;
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(3 == run);
+  ASSERT(true == data.empty());
+
+  /* the runs still captured finish when the store is closed */
+  output.close_all();
+  close(fds[0][1]);
+  close(fds[2][1]);
+  run = 1;
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(true == finished);
+}
+
+void test_job_output_follow(void)
+{
+  KiwibesJobOutput output(64,4);
+  std::string      data;
+  std::string      followed;
+  bool             finished = false;
+  uint64_t         run      = 0;
+  uint64_t         offset   = 0;
+  int              fds[2];
+
+  ASSERT(0 == pipe2(fds,O_NONBLOCK));
+  output.capture("job_1",fds[0]);
+
+  /* the job writes and exits while the reader waits */
+  std::thread writer([&output,&fds](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if(3 == write(fds[1],"abc",3))
+    {
+      output.drain(fds[0]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close(fds[1]);
+    output.drain(fds[0]);
+  });
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  while((false == finished) && (std::chrono::steady_clock::now() - start < std::chrono::seconds(5)))
+  {
+    ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,5000));
+    followed += data;
+  }
+  writer.join();
+
+  ASSERT(true == finished);
+  ASSERT(std::string("abc") == followed);
+  ASSERT(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+
+  /* a reader following the latest run stays on it, when a newer run starts meanwhile */
+  int next[2];
+
+  ASSERT(0 == pipe2(fds,O_NONBLOCK));
+  ASSERT(0 == pipe2(next,O_NONBLOCK));
+  ASSERT(2 == output.capture("job_1",fds[0]));
+  ASSERT(3 == write(fds[1],"abc",3));
+  ASSERT(true == output.drain(fds[0]));
+
+  std::thread restart([&output,&fds,&next](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    output.capture("job_1",next[0]);
+    if(3 == write(next[1],"xyz",3))
+    {
+      output.drain(next[0]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close(fds[1]);
+    output.drain(fds[0]);
+  });
+
+  run    = 0;
+  offset = 3;
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,5000));
+  restart.join();
+
+  ASSERT(2 == run);
+  ASSERT(3 == offset);
+  ASSERT(true == data.empty());
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,5000));
+  ASSERT(true == finished);
+
+  close(next[1]);
+  output.close_all();
+}
+
+void test_job_output_spill(void)
+{
+  KiwibesJobOutput output(8,4);
+  char             folder[] = "/tmp/kiwibes_output_XXXXXX";
+  std::string      payload;
+  int              fds[2];
+
+  ASSERT(nullptr != mkdtemp(folder));
+  output.set_spill_folder(std::string(folder) + "/output/");
+
+  ASSERT(0 == pipe2(fds,O_NONBLOCK));
+  ASSERT(1 == output.capture("job_1",fds[0]));
+
+  /* the file has the complete output, the ring only the latest bytes */
+  for(int l = 0; l < 100; l++)
+  {
+    std::string line = "line " + std::to_string(l) + "\n";
+
+    payload += line;
+    ASSERT((ssize_t)line.size() == write(fds[1],line.c_str(),line.size()));
+    ASSERT(true == output.drain(fds[0]));
+  }
+  close(fds[1]);
+  ASSERT(false == output.drain(fds[0]));
+
+  std::string data;
+  bool        finished = false;
+  uint64_t    run      = 0;
+  uint64_t    offset   = 0;
+
+  ASSERT(ERROR_NO_ERROR == output.read(data,finished,"job_1",run,offset,64,0));
+  ASSERT(payload.substr(payload.size() - 8) == data);
+  ASSERT(true == finished);
+
+  std::string    spilled;
+  std::string    fname;
+  DIR           *dir = opendir((std::string(folder) + "/output").c_str());
+  struct dirent *entry;
+
+  ASSERT(nullptr != dir);
+  while(nullptr != (entry = readdir(dir)))
+  {
+    if(0 == strncmp(entry->d_name,"job_1.",6))
+    {
+      fname = std::string(folder) + "/output/" + entry->d_name;
+    }
+  }
+  closedir(dir);
+
+  ASSERT(false == fname.empty());
+  ASSERT(std::string(".1.log") == fname.substr(fname.size() - 6));
+
+  std::ifstream     file(fname);
+  std::stringstream content;
+  content << file.rdbuf();
+  ASSERT(payload == content.str());
+
+  unlink(fname.c_str());
+  rmdir((std::string(folder) + "/output").c_str());
+  rmdir(folder);
+}
@@ -24,13 +24,21 @@
 #include "unit_tests.h"
 #include "kiwibes_jobs_manager.h"
 #include "kiwibes_database.h"
+#include "kiwibes_cgroups.h"
 
 #include "nlohmann/json.h"
 
 #include <fstream>
 #include <chrono>
 #include <cstdio>
+#include <climits>
+#include <cstring>
 #include <streambuf>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
 
 /*----------------------- Public Functions Definitions ------------*/
 void test_jobs_manager_start_job(void)
@@ -85,6 +93,44 @@ void test_jobs_manager_start_job(void)
   ASSERT(0.0                    == job["var-runtime"].get<double>()); 
 }
 
+void test_jobs_manager_launch_failure(void)
+{
+  KiwibesDatabase database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json job; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job whose program does not exist fails to launch, and remains stopped */
+  job["program"]     = std::vector<std::string>({ "/nowhere/noplace/does/not/exist" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 1;
+
+  ASSERT(ERROR_NO_ERROR == database.create_job("no_program",job));
+  ASSERT(ERROR_PROCESS_LAUNCH_FAILED == manager.start_job("no_program"));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"no_program"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(0                      == job["nbr-runs"].get<unsigned long int>()); 
+
+  /* the job can be started again, and fails again */
+  ASSERT(ERROR_PROCESS_LAUNCH_FAILED == manager.start_job("no_program"));
+}
+
 void test_jobs_manager_stop_job(void)
 {
   KiwibesDatabase database; 
@@ -289,4 +335,642 @@ void test_jobs_manager_queued_start_requests(void)
   std::this_thread::sleep_for(std::chrono::seconds(6)); 
 
   ASSERT(2 == count_occurrences());
-}
\ No newline at end of file
+}
+void test_jobs_manager_queued_restart_latency(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* start a long running job and queue another execution of it */
+  ASSERT(ERROR_NO_ERROR == manager.start_job("sleep_20"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("sleep_20"));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"sleep_20"));
+  ASSERT(1 == job["pending-start"].get<signed int>());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  /* stop the current execution, the queued one must start right after 
+     the process exits and not on the next polling period
+   */
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::chrono::milliseconds             elapsed(0);
+
+  ASSERT(ERROR_NO_ERROR == manager.stop_job("sleep_20"));
+
+  do
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"sleep_20"));
+
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  }
+  while(((0 != job["pending-start"].get<signed int>()) || 
+         (std::string("running") != job["status"].get<std::string>())) &&
+        (std::chrono::milliseconds(1000) > elapsed));
+
+  ASSERT(0                      == job["pending-start"].get<signed int>());
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(1                      == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(std::chrono::milliseconds(20) > elapsed);
+
+  /* stop the second execution */
+  manager.stop_all_jobs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"sleep_20"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(2                      == job["nbr-runs"].get<unsigned long int>());
+}
+
+void test_jobs_manager_polling_fallback(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* count the process file descriptors opened by the server */
+  auto count_pidfds = []()
+  {
+    DIR           *folder = opendir("/proc/self/fd");
+    struct dirent *entry  = nullptr;
+    unsigned int   pidfds = 0;
+
+    while((nullptr != folder) && (nullptr != (entry = readdir(folder))))
+    {
+      char    target[64];
+      ssize_t length = readlinkat(dirfd(folder),entry->d_name,target,sizeof(target) - 1);
+
+      if(0 < length)
+      {
+        target[length] = 0;
+        pidfds += (0 == strcmp("anon_inode:[pidfd]",target)) ? 1 : 0;
+      }
+    }
+
+    if(nullptr != folder)
+    {
+      closedir(folder);
+    }
+
+    return pidfds;
+  };
+
+  unsigned int pidfds = count_pidfds();
+
+  /* many instances exiting at once, watched through their process file descriptors */
+  job["program"]      = std::vector<std::string>({ "/bin/sleep", "0.5" });
+  job["schedule"]     = "";
+  job["max-runtime"]  = 0;
+  job["max-parallel"] = 64;
+  ASSERT(ERROR_NO_ERROR == database.create_job("short",job));
+
+  for(int i = 0; i < 32; i++)
+  {
+    ASSERT(ERROR_NO_ERROR == manager.start_job("short"));
+  }
+
+  /* without file descriptors left, the last instance cannot be watched, and the
+     watcher thread falls back to polling. It then also reaps the other instances
+   */
+  std::vector<int> spare;
+
+  for(int fd = open("/dev/null",O_RDONLY | O_CLOEXEC); 0 <= fd; fd = open("/dev/null",O_RDONLY | O_CLOEXEC))
+  {
+    spare.push_back(fd);
+  }
+
+  T_KIWIBES_ERROR error = manager.start_job("short");
+
+  for(size_t f = 0; f < spare.size(); f++)
+  {
+    close(spare[f]);
+  }
+
+  ASSERT(ERROR_NO_ERROR == error);
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"short"));
+  for(int r = 0; (r < 50) && (std::string("running") == job["status"].get<std::string>()); r++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"short"));
+  }
+
+  /* all the instances were reaped, and their file descriptors closed whichever way they were reaped */
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(33 == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(pidfds == count_pidfds());
+
+  /* the watcher thread is idle between polls, no event is left to wake it up */
+  struct rusage before;
+  struct rusage after;
+
+  getrusage(RUSAGE_SELF,&before);
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  getrusage(RUSAGE_SELF,&after);
+
+  int64_t cpu = ((int64_t)after.ru_utime.tv_sec - before.ru_utime.tv_sec)*1000000 + (after.ru_utime.tv_usec - before.ru_utime.tv_usec) +
+                ((int64_t)after.ru_stime.tv_sec - before.ru_stime.tv_sec)*1000000 + (after.ru_stime.tv_usec - before.ru_stime.tv_usec);
+
+  ASSERT(50000 > cpu);
+}
+
+void test_jobs_manager_max_runtime(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+  nlohmann::json     stats; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job which runs for longer than its maximum runtime, and another one 
+     which also ignores the request to terminate
+   */
+  job["program"]     = std::vector<std::string>({ "/bin/sleep", "30" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 1;
+  ASSERT(ERROR_NO_ERROR == database.create_job("overrun",job));
+
+  job["program"]     = std::vector<std::string>({ "/bin/bash", "-c", "trap '' TERM; exec /bin/sleep 30" });
+  ASSERT(ERROR_NO_ERROR == database.create_job("stubborn",job));
+
+  /* queue a second execution of the first job, it starts once the first one is stopped */
+  ASSERT(ERROR_NO_ERROR == manager.start_job("overrun"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("overrun"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("stubborn"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("sleep_2"));
+
+  /* the first execution is terminated at its deadline */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"overrun"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(0                      == job["pending-start"].get<signed int>());
+  ASSERT(1                      == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(1                      == job["nbr-timeouts"].get<unsigned long int>());
+  ASSERT(SIGTERM                == job["runs"][0]["signal"].get<int>());
+  ASSERT(1000                   <= job["runs"][0]["duration"].get<int64_t>());
+  ASSERT(1250                   >  job["runs"][0]["duration"].get<int64_t>());
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"stubborn"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+
+  /* the second execution is also terminated, while the job within its maximum runtime finishes */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"overrun"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(2                      == job["nbr-timeouts"].get<unsigned long int>());
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"sleep_2"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(1                      == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(0                      == job["nbr-timeouts"].get<unsigned long int>());
+
+  /* the job which ignores the request is killed after the grace period */
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"stubborn"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(1                      == job["nbr-timeouts"].get<unsigned long int>());
+  ASSERT(SIGKILL                == job["runs"][0]["signal"].get<int>());
+  ASSERT(6000                   <= job["runs"][0]["duration"].get<int64_t>());
+
+  database.get_stats(stats);
+  ASSERT(4 == stats["runs"].get<uint64_t>());
+  ASSERT(3 == stats["timed-out-runs"].get<uint64_t>());
+}
+
+void test_jobs_manager_concurrency_limits(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+  nlohmann::json     stats; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job that runs two instances at once, and two jobs of different priorities */
+  job["program"]      = std::vector<std::string>({ "/bin/sleep", "1" });
+  job["schedule"]     = "";
+  job["max-runtime"]  = 0;
+  job["max-parallel"] = 2;
+  ASSERT(ERROR_NO_ERROR == database.create_job("parallel",job));
+
+  job["max-parallel"] = 1;
+  job["priority"]     = 0;
+  ASSERT(ERROR_NO_ERROR == database.create_job("low",job));
+
+  job["priority"]     = 10;
+  ASSERT(ERROR_NO_ERROR == database.create_job("urgent",job));
+
+  /* at most two jobs run at once, the other requests are queued */
+  manager.set_max_running(2);
+
+  ASSERT(ERROR_NO_ERROR == manager.start_job("parallel"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("parallel"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("parallel"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("low"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("urgent"));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"parallel"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(1                      == job["pending-start"].get<signed int>());
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"low"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(1                      == job["pending-start"].get<signed int>());
+
+  /* once both instances exit, the job with the highest priority starts first, then 
+     the oldest of the others
+   */
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"parallel"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(0                      == job["pending-start"].get<signed int>());
+  ASSERT(2                      == job["nbr-runs"].get<unsigned long int>());
+  ASSERT(1000                   <= job["runs"][1]["duration"].get<int64_t>());
+  ASSERT(1250                   >  job["runs"][1]["duration"].get<int64_t>());
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"urgent"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"low"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(1                      == job["pending-start"].get<signed int>());
+
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"low"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(0                      == job["pending-start"].get<signed int>());
+
+  /* the queued requests of a job can be removed before they start */
+  ASSERT(ERROR_NO_ERROR == manager.start_job("urgent"));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("urgent"));
+  ASSERT(ERROR_NO_ERROR == manager.clear_start_requests("urgent"));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"urgent"));
+  ASSERT(0 == job["pending-start"].get<signed int>());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"urgent"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(2                      == job["nbr-runs"].get<unsigned long int>());
+
+  database.get_stats(stats);
+  ASSERT(0 == stats["running"].get<uint64_t>());
+  ASSERT(6 == stats["runs"].get<uint64_t>());
+}
+
+void test_jobs_manager_start_job_async(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+  T_INVOCATION       invocation;
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* the requests are handed over to the launcher thread, in order */
+  uint64_t started = 0;
+  uint64_t pending = 0;
+  uint64_t unknown = 1;
+
+  ASSERT(ERROR_NO_ERROR == manager.start_job_async("sleep_2",started));
+  ASSERT(ERROR_NO_ERROR == manager.start_job_async("sleep_2",pending));
+  ASSERT(0 < started);
+  ASSERT(started < pending);
+
+  /* unknown jobs are refused at once, without an invocation */
+  ASSERT(ERROR_JOB_NAME_UNKNOWN == manager.start_job_async("my job",unknown));
+  ASSERT(0 == unknown);
+
+  ASSERT(ERROR_NO_ERROR == manager.get_invocation(invocation,started,1000));
+  ASSERT(std::string("sleep_2") == invocation.name);
+  ASSERT(INVOCATION_STARTED     == invocation.status);
+  ASSERT(ERROR_NO_ERROR         == invocation.error);
+
+  ASSERT(ERROR_NO_ERROR == manager.get_invocation(invocation,pending,1000));
+  ASSERT(INVOCATION_PENDING == invocation.status);
+
+  ASSERT(ERROR_INVOCATION_UNKNOWN == manager.get_invocation(invocation,pending + 1,0));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"sleep_2"));
+  ASSERT(std::string("running") == job["status"].get<std::string>());
+  ASSERT(1                      == job["pending-start"].get<signed int>());
+
+  ASSERT(ERROR_NO_ERROR == manager.clear_start_requests("sleep_2"));
+}
+
+void test_jobs_manager_job_output(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job that writes to both its standard output and error */
+  job["program"]     = std::vector<std::string>({ "/bin/sh", "-c", "echo out; echo err >&2" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 0;
+  ASSERT(ERROR_NO_ERROR == database.create_job("chatty",job));
+
+  std::string data;
+  std::string output;
+  bool        finished = false;
+  uint64_t    run      = 0;
+  uint64_t    offset   = 0;
+
+  ASSERT(ERROR_OUTPUT_UNKNOWN == manager.read_job_output(data,finished,"chatty",run,offset,1024,0));
+  ASSERT(ERROR_NO_ERROR == manager.start_job("chatty"));
+
+  /* both are captured, until the job exits */
+  for(int r = 0; (false == finished) && (r < 5); r++)
+  {
+    ASSERT(ERROR_NO_ERROR == manager.read_job_output(data,finished,"chatty",run,offset,1024,2000));
+    output += data;
+  }
+  ASSERT(true == finished);
+  ASSERT(1 == run);
+  ASSERT(std::string::npos != output.find("out\n"));
+  ASSERT(std::string::npos != output.find("err\n"));
+}
+
+void test_jobs_manager_job_resources(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  nlohmann::json     job; 
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+#if defined(__linux__)
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+#else 
+    #error "OS not supported"
+#endif 
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job that spends some CPU time, within its limits */
+  job["program"]     = std::vector<std::string>({ "/bin/sh", "-c", "i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 0;
+  job["max-memory"]  = 64;
+  job["max-cpu"]     = 100;
+  ASSERT(ERROR_NO_ERROR == database.create_job("busy",job));
+
+  ASSERT(ERROR_NO_ERROR == manager.start_job("busy"));
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"busy"));
+
+  for(int r = 0; (r < 100) && (std::string("running") == job["status"].get<std::string>()); r++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"busy"));
+  }
+
+  /* the resources it used are in the history of its runs */
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"busy"));
+  ASSERT(std::string("stopped") == job["status"].get<std::string>());
+  ASSERT(1 == job["runs"].size());
+  ASSERT(0 == job["runs"][0]["exit-status"].get<int32_t>());
+  ASSERT(0 < job["runs"][0]["cpu-user"].get<int64_t>() + job["runs"][0]["cpu-system"].get<int64_t>());
+  /* the peak memory is only known from the cgroup, the one of the process is the server's */
+  ASSERT(0 <= job["runs"][0]["memory-peak"].get<int64_t>());
+  ASSERT(64*1024*1024 > job["runs"][0]["memory-peak"].get<int64_t>());
+}
+
+void test_jobs_manager_forked_children(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  KiwibesCgroups     cgroups;
+  nlohmann::json     job; 
+
+  /* without cgroup v2 on the host, the jobs are not placed in cgroups */
+  if(false == cgroups.enable(""))
+  {
+    return;
+  }
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  /* a job that forks at once, its child reports its cgroup and spends some CPU time */
+  job["program"]     = std::vector<std::string>({ "/bin/sh", "-c", "(grep ^0:: /proc/self/cgroup; i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done) & wait" });
+  job["schedule"]    = "";
+  job["max-runtime"] = 0;
+  job["max-memory"]  = 64;
+  job["max-cpu"]     = 100;
+  ASSERT(ERROR_NO_ERROR == database.create_job("forker",job));
+
+  std::string data;
+  std::string output;
+  bool        finished = false;
+  uint64_t    run      = 0;
+  uint64_t    offset   = 0;
+
+  ASSERT(ERROR_NO_ERROR == manager.start_job("forker"));
+
+  for(int r = 0; (false == finished) && (r < 10); r++)
+  {
+    ASSERT(ERROR_NO_ERROR == manager.read_job_output(data,finished,"forker",run,offset,1024,2000));
+    output += data;
+  }
+  ASSERT(true == finished);
+
+  /* the child was created in the cgroup of the run, so it is limited with it */
+  ASSERT(std::string::npos != output.find("/kiwibes-jobs/forker."));
+
+  /* and the CPU time it spent is charged to the run */
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"forker"));
+
+  for(int r = 0; (r < 100) && (std::string("running") == job["status"].get<std::string>()); r++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"forker"));
+  }
+  ASSERT(1 == job["runs"].size());
+  ASSERT(0 == job["runs"][0]["exit-status"].get<int32_t>());
+  ASSERT(0 < job["runs"][0]["cpu-user"].get<int64_t>() + job["runs"][0]["cpu-system"].get<int64_t>());
+}
+
+void test_jobs_manager_cgroups_removed(void)
+{
+  KiwibesDatabase database; 
+  nlohmann::json  job; 
+  std::string     folder;
+
+  /* the folder of the cgroups of the jobs is the parent of a cgroup created here */
+  {
+    KiwibesCgroups cgroups;
+    char           path[PATH_MAX];
+
+    /* without cgroup v2 on the host, the jobs are not placed in cgroups */
+    if(false == cgroups.enable(""))
+    {
+      return;
+    }
+
+    int     group = cgroups.create("probe",0,0);
+    ssize_t size  = readlink(("/proc/self/fd/" + std::to_string(group)).c_str(),path,sizeof(path));
+
+    ASSERT(0 <= group);
+    ASSERT(0 < size);
+    folder = std::string(path,size);
+    folder = folder.substr(0,folder.rfind('/'));
+    cgroups.attach(INVALID_PROCESS_HANDLE,group);
+  }
+
+  /* because all job changes are written to the database, we need to use
+     a copy of the original database 
+   */
+  {
+    std::ifstream src("../tests/data/databases/linux_jobs.json");
+    std::ofstream dst("./test_jobs.json");
+
+    dst << src.rdbuf();
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_jobs.json"));
+
+  job["program"]      = std::vector<std::string>({ "/bin/sleep", "10" });
+  job["schedule"]     = "";
+  job["max-runtime"]  = 0;
+  job["max-parallel"] = 4;
+  ASSERT(ERROR_NO_ERROR == database.create_job("sleeper",job));
+
+  /* the manager is destroyed while its jobs are still running, and others
+     are queued, which start as soon as the running ones are killed
+   */
+  {
+    KiwibesJobsManager manager(&database);
+
+    for(int s = 0; s < 8; s++)
+    {
+      ASSERT(ERROR_NO_ERROR == manager.start_job("sleeper"));
+    }
+  }
+
+  /* the jobs were killed and reaped, so none of their cgroups is left behind */
+  DIR           *dir  = opendir(folder.c_str());
+  size_t         left = 0;
+  struct dirent *entry;
+
+  while((NULL != dir) && (NULL != (entry = readdir(dir))))
+  {
+    left += (0 == strncmp(entry->d_name,"sleeper.",8)) ? 1 : 0;
+  }
+
+  if(NULL != dir)
+  {
+    closedir(dir);
+  }
+  ASSERT(0 == left);
+}
@@ -0,0 +1,109 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the queue of the launcher thread.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_launch_queue.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_launch_queue_order(void)
+{
+  KiwibesLaunchQueue queue;
+  T_LAUNCH_REQUEST   request;
+
+  /* start with an empty queue */
+  ASSERT(false == queue.pop(request));
+
+  /* requests are popped in the order they were pushed */
+  queue.push(1,"job_1");
+  queue.push(2,"job_2");
+  queue.push(3,"job_1");
+
+  ASSERT(true == queue.pop(request));
+  ASSERT(1 == request.invocation);
+  ASSERT(std::string("job_1") == request.name);
+  ASSERT(true == queue.pop(request));
+  ASSERT(2 == request.invocation);
+  ASSERT(std::string("job_2") == request.name);
+
+  /* the queue can be refilled while it is not empty */
+  queue.push(4,"job_3");
+
+  ASSERT(true == queue.pop(request));
+  ASSERT(3 == request.invocation);
+  ASSERT(true == queue.pop(request));
+  ASSERT(4 == request.invocation);
+  ASSERT(false == queue.pop(request));
+
+  /* the requests left in the queue are dropped by its destructor */
+  queue.push(5,"job_4");
+}
+
+void test_launch_queue_producers(void)
+{
+  KiwibesLaunchQueue       queue;
+  std::vector<std::thread> producers;
+  const uint64_t           threads  = 4;
+  const uint64_t           requests = 20000;
+  std::vector<uint64_t>    last(threads,0);
+  uint64_t                 popped   = 0;
+  bool                     ordered  = true;
+
+  /* several threads push at once, while this one pops */
+  for(uint64_t t = 0; t < threads; t++)
+  {
+    producers.push_back(std::thread([&queue,t,requests]()
+    {
+      for(uint64_t r = 1; r <= requests; r++)
+      {
+        queue.push(t*requests + r,std::to_string(t));
+      }
+    }));
+  }
+
+  while(popped < threads*requests)
+  {
+    T_LAUNCH_REQUEST request;
+
+    if(true == queue.pop(request))
+    {
+      uint64_t t = (request.invocation - 1)/requests;
+
+      /* none is lost, and those of each producer keep their order */
+      ordered = ordered && (std::to_string(t) == request.name) && (last[t] < request.invocation);
+      last[t] = request.invocation;
+      popped++;
+    }
+  }
+
+  for(uint64_t t = 0; t < threads; t++)
+  {
+    producers[t].join();
+    ASSERT((t + 1)*requests == last[t]);
+  }
+
+  ASSERT(true == ordered);
+}
@@ -0,0 +1,173 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the table of running jobs.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_process_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_process_table_insert(void)
+{
+  KiwibesProcessTable table;
+
+  /* start with an empty table */
+  ASSERT(0 == table.size());
+  ASSERT(false == table.is_running("job_1"));
+  ASSERT(INVALID_PROCESS_HANDLE == table.get_handle("job_1"));
+
+  /* add two jobs */
+  ASSERT(true == table.insert("job_1",100));
+  ASSERT(true == table.insert("job_2",200));
+  ASSERT(2 == table.size());
+
+  /* the same process cannot be added twice */
+  ASSERT(false == table.insert("job_3",200));
+  ASSERT(2 == table.size());
+
+  /* both indexes are consistent */
+  ASSERT(true == table.is_running("job_1"));
+  ASSERT(true == table.is_running("job_2"));
+  ASSERT(false == table.is_running("job_3"));
+  ASSERT(100 == table.get_handle("job_1"));
+  ASSERT(200 == table.get_handle("job_2"));
+  ASSERT(INVALID_PROCESS_HANDLE == table.get_handle("job_3"));
+
+  ASSERT(1 == table.instances("job_1"));
+  ASSERT(0 == table.instances("job_3"));
+  ASSERT(0 < table.get_start(100));
+  ASSERT(0 == table.get_start(300));
+
+  /* the processes are not watched until their watch is set */
+  ASSERT(-1 == table.get_watch(100));
+  ASSERT(true == table.set_watch(100,7));
+  ASSERT(false == table.set_watch(300,8));
+  ASSERT(7 == table.get_watch(100));
+  ASSERT(-1 == table.get_watch(200));
+  ASSERT(-1 == table.get_watch(300));
+
+  /* running jobs are ordered by name */
+  ASSERT(2 == table.running().size());
+  ASSERT(std::string("job_1") == table.running().begin()->first);
+}
+
+void test_process_table_instances(void)
+{
+  KiwibesProcessTable table;
+  std::string         name;
+
+  /* a job can run several instances at once, the oldest is returned first */
+  ASSERT(true == table.insert("job_1",100));
+  ASSERT(true == table.insert("job_1",300));
+  ASSERT(true == table.insert("job_2",200));
+  ASSERT(3 == table.size());
+  ASSERT(2 == table.instances("job_1"));
+  ASSERT(100 == table.get_handle("job_1"));
+  ASSERT(table.get_start(100) <= table.get_start(300));
+
+  /* removing one instance keeps the others running */
+  ASSERT(true == table.remove(name,100));
+  ASSERT(std::string("job_1") == name);
+  ASSERT(true == table.is_running("job_1"));
+  ASSERT(1 == table.instances("job_1"));
+  ASSERT(300 == table.get_handle("job_1"));
+
+  ASSERT(true == table.remove(name,300));
+  ASSERT(false == table.is_running("job_1"));
+  ASSERT(INVALID_PROCESS_HANDLE == table.get_handle("job_1"));
+  ASSERT(1 == table.size());
+}
+
+void test_process_table_remove(void)
+{
+  KiwibesProcessTable table;
+  std::string         name;
+
+  ASSERT(true == table.insert("job_1",100));
+  ASSERT(true == table.insert("job_2",200));
+
+  /* unknown processes cannot be removed */
+  ASSERT(false == table.remove(name,300));
+  ASSERT(2 == table.size());
+
+  /* removing the process returns the name of its job */
+  ASSERT(true == table.remove(name,200));
+  ASSERT(std::string("job_2") == name);
+  ASSERT(1 == table.size());
+  ASSERT(false == table.is_running("job_2"));
+  ASSERT(INVALID_PROCESS_HANDLE == table.get_handle("job_2"));
+
+  /* it cannot be removed twice */
+  ASSERT(false == table.remove(name,200));
+
+  /* the job can run again with a different process */
+  ASSERT(true == table.insert("job_2",400));
+  ASSERT(400 == table.get_handle("job_2"));
+
+  ASSERT(true == table.remove(name,100));
+  ASSERT(std::string("job_1") == name);
+  ASSERT(true == table.remove(name,400));
+  ASSERT(std::string("job_2") == name);
+  ASSERT(0 == table.size());
+}
+
+void test_process_table_reap_benchmark(void)
+{
+  KiwibesProcessTable            table;
+  std::vector<T_PROCESS_HANDLER> handles;
+  const unsigned int             count = 10000;
+
+  /* fill the table with synthetic jobs, then reap them in random 
+     order as the watcher thread would do
+   */
+  for(unsigned int j = 0; j < count; j++)
+  {
+    T_PROCESS_HANDLER handle = 1000 + j;
+
+    ASSERT(true == table.insert(std::string("job_") + std::to_string(j),handle));
+    handles.push_back(handle);
+  }
+
+  std::shuffle(handles.begin(),handles.end(),std::mt19937(42));
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for(unsigned int h = 0; h < handles.size(); h++)
+  {
+    std::string name;
+
+    ASSERT(true == table.remove(name,handles[h]));
+    ASSERT(std::string("job_") + std::to_string(handles[h] - 1000) == name);
+  }
+
+  std::chrono::microseconds elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+  printf("[%u exits in %ld us] ",count,(long)elapsed.count());
+
+  ASSERT(0 == table.size());
+  ASSERT(std::chrono::microseconds(100000) > elapsed);
+}
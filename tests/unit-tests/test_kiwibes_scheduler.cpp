@@ -0,0 +1,200 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the scheduler.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_scheduler.h"
+#include "kiwibes_jobs_manager.h"
+#include "kiwibes_database.h"
+
+#include "nlohmann/json.h"
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*----------------------- Private Functions Definitions -----------*/
+/** Return a job description, as stored in the database
+
+  @param program    the job command line
+  @param schedule   the job schedule
+ */
+static nlohmann::json job_description(const std::vector<std::string> &program, const std::string &schedule)
+{
+  nlohmann::json job;
+
+  job["program"]       = program;
+  job["max-runtime"]   = 10;
+  job["avg-runtime"]   = 0.0;
+  job["var-runtime"]   = 0.0;
+  job["schedule"]      = schedule;
+  job["status"]        = "stopped";
+  job["pending-start"] = 0;
+  job["start-time"]    = 0;
+  job["nbr-runs"]      = 0;
+
+  return job;
+}
+
+/** Return a Cron expression that occurs once a day, at the given instant
+
+  @param t0   the instant when the expression occurs
+ */
+static std::string daily_schedule(std::time_t t0)
+{
+  struct tm local;
+
+  localtime_r(&t0,&local);
+
+  return std::to_string(local.tm_sec) + " " + std::to_string(local.tm_min) + " " + std::to_string(local.tm_hour) + " * * *";
+}
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_scheduler_same_second_batch(void)
+{
+  const unsigned int count     = 50;
+  unsigned int       running   = 0;
+  unsigned int       same_time = 0;
+  size_t             scheduled = 0;
+  std::time_t        t0;
+  std::time_t        started   = 0;
+
+  /* the server objects are destroyed before checking the results, a failed 
+     check does not leave their threads running */
+  {
+    KiwibesDatabase    database; 
+    KiwibesJobsManager manager(&database);
+    KiwibesScheduler   scheduler(&database,&manager);
+    nlohmann::json     jobs;
+    nlohmann::json     job;
+
+    /* all the jobs are scheduled to start in the same second, a few seconds from now */
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    t0 = now + 3;
+
+    for(unsigned int j = 0; j < count; j++)
+    {
+      jobs[std::string("job_") + std::to_string(j)] = job_description({ "/bin/sleep", "30" },daily_schedule(t0));
+    }
+
+    {
+      std::ofstream dst("./test_scheduler.json");
+
+      dst << jobs;
+    }
+
+    database.load("./test_scheduler.json");
+    scheduler.start();
+
+    for(unsigned int j = 0; j < count; j++)
+    {
+      scheduler.schedule_job(std::string("job_") + std::to_string(j));
+    }
+
+    /* wait, with a generous deadline, until all the jobs are running */
+    std::this_thread::sleep_until(std::chrono::system_clock::from_time_t(t0));
+
+    for(int retries = 0; (retries < 300) && (count != running); retries++)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+      running = 0;
+      for(unsigned int j = 0; j < count; j++)
+      {
+        database.get_job_description(job,std::string("job_") + std::to_string(j));
+        running += (std::string("running") == job["status"].get<std::string>()) ? 1 : 0;
+      }
+    }
+
+    /* they were all started for the same occurrence of their schedule */
+    for(unsigned int j = 0; j < count; j++)
+    {
+      database.get_job_description(job,std::string("job_") + std::to_string(j));
+      started    = (0 == j) ? job["start-time"].get<std::time_t>() : started;
+      same_time += (started == job["start-time"].get<std::time_t>()) ? 1 : 0;
+    }
+
+    /* the jobs are scheduled again, for the next day */
+    std::vector<std::string> names;
+
+    scheduler.get_all_scheduled_job_names(names);
+    scheduled = names.size();
+
+    scheduler.stop();
+    manager.stop_all_jobs();
+  }
+
+  ASSERT(count == running);
+  ASSERT(count == same_time);
+  ASSERT(t0 <= started);
+  ASSERT(count == scheduled);
+}
+
+void test_scheduler_unschedule_job(void)
+{
+  KiwibesDatabase    database; 
+  KiwibesJobsManager manager(&database);
+  KiwibesScheduler   scheduler(&database,&manager);
+  nlohmann::json     jobs;
+  nlohmann::json     job;
+
+  /* two jobs are scheduled for the same instant, but one is unscheduled */
+  std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::time_t t0  = now + 2;
+
+  jobs["job_1"] = job_description({ "/bin/sleep", "1" },daily_schedule(t0));
+  jobs["job_2"] = job_description({ "/bin/sleep", "1" },daily_schedule(t0));
+  jobs["job_3"] = job_description({ "/bin/sleep", "1" },"");
+
+  {
+    std::ofstream dst("./test_scheduler.json");
+
+    dst << jobs;
+  }
+
+  ASSERT(ERROR_NO_ERROR == database.load("./test_scheduler.json"));
+
+  scheduler.start();
+
+  ASSERT(ERROR_NO_ERROR == scheduler.schedule_job("job_1"));
+  ASSERT(ERROR_NO_ERROR == scheduler.schedule_job("job_2"));
+
+  /* unknown jobs and jobs without a valid schedule cannot be scheduled */
+  ASSERT(ERROR_JOB_NAME_UNKNOWN     == scheduler.schedule_job("my job"));
+  ASSERT(ERROR_JOB_SCHEDULE_INVALID == scheduler.schedule_job("job_3"));
+
+  scheduler.unschedule_job("job_2");
+
+  /* wait until the job is started, and then finishes */
+  std::this_thread::sleep_until(std::chrono::system_clock::from_time_t(t0 + 2) + std::chrono::milliseconds(500));
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_1"));
+  ASSERT(1 == job["nbr-runs"].get<unsigned long int>());
+
+  ASSERT(ERROR_NO_ERROR == database.get_job_description(job,"job_2"));
+  ASSERT(0 == job["nbr-runs"].get<unsigned long int>());
+
+  scheduler.stop();
+}
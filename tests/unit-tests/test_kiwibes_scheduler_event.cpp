@@ -24,7 +24,10 @@
 #include "unit_tests.h"
 #include "kiwibes_scheduler_event.h"
 
+#include <algorithm>
 #include <chrono>
+#include <random>
+#include <vector>
 
 /*----------------------- Public Functions Definitions ------------*/
 void test_scheduler_event_order(void)
@@ -43,4 +46,23 @@ void test_scheduler_event_order(void)
   /* this order is not correct */
   ASSERT(false == (third < first));
   ASSERT(false == (third < third));
-}
\ No newline at end of file
+}
+void test_scheduler_event_shuffled_sort(void)
+{
+  std::vector<KiwibesSchedulerEvent> events;
+  std::mt19937                       rng(42);
+
+  /* events are copyable values, sorted by their instant */
+  for(int e = 0; e < 1000; e++)
+  {
+    events.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,e,"job_" + std::to_string(e)));
+  }
+  std::shuffle(events.begin(),events.end(),rng);
+  std::sort(events.begin(),events.end());
+
+  for(size_t e = 0; e < events.size(); e++)
+  {
+    ASSERT((std::time_t)e == events[e].t0);
+    ASSERT(0 == events[e].job_name.compare("job_" + std::to_string(e)));
+  }
+}
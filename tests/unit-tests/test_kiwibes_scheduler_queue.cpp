@@ -0,0 +1,237 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+   
+  Summary
+  -------
+  Implements the unit tests for the scheduler events queue.  
+ */
+#include "unit_tests.h"
+#include "kiwibes_scheduler_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_scheduler_queue_order(void)
+{
+  KiwibesSchedulerQueue    queue;
+  std::vector<std::time_t> instants;
+  std::mt19937             rng(1234);
+
+  ASSERT(true == queue.empty());
+
+  /* add the events in a random order */
+  for(int e = 0; e < 500; e++)
+  {
+    instants.push_back(1000 + (rng() % 100));
+    queue.push(EVENT_START_JOB,instants.back(),"job_" + std::to_string(e));
+  }
+  ASSERT(500 == queue.size());
+
+  /* the events come out ordered by their instant */
+  std::sort(instants.begin(),instants.end());
+  for(size_t e = 0; e < instants.size(); e++)
+  {
+    ASSERT(instants[e] == queue.top().t0);
+    queue.pop();
+  }
+  ASSERT(true == queue.empty());
+}
+
+void test_scheduler_queue_shuffled(void)
+{
+  KiwibesSchedulerQueue    queue;
+  std::vector<std::time_t> instants;
+  std::mt19937             rng(4321);
+
+  /* far-future deadlines must not block the earlier ones */
+  for(std::time_t t = 0; t < 1000; t++)
+  {
+    instants.push_back((0 == (t % 10)) ? (t + 1000000) : t);
+  }
+  std::shuffle(instants.begin(),instants.end(),rng);
+
+  for(size_t e = 0; e < instants.size(); e++)
+  {
+    queue.push(EVENT_START_JOB,instants[e],"job_" + std::to_string(instants[e]));
+  }
+
+  std::sort(instants.begin(),instants.end());
+  for(size_t e = 0; e < instants.size(); e++)
+  {
+    ASSERT(instants[e] == queue.top().t0);
+    ASSERT(0 == queue.top().job_name.compare("job_" + std::to_string(instants[e])));
+    queue.pop();
+  }
+  ASSERT(true == queue.empty());
+}
+
+void test_scheduler_queue_update(void)
+{
+  KiwibesSchedulerQueue queue;
+
+  queue.push(EVENT_START_JOB,100,"job_1");
+  queue.push(EVENT_START_JOB,200,"job_2");
+  queue.push(EVENT_START_JOB,300,"job_3");
+
+  /* re-scheduling a job moves its event instead of adding another one */
+  queue.push(EVENT_START_JOB,50,"job_3");
+  ASSERT(3 == queue.size());
+  ASSERT(0 == queue.top().job_name.compare("job_3"));
+
+  queue.push(EVENT_START_JOB,400,"job_3");
+  ASSERT(3 == queue.size());
+  ASSERT(0 == queue.top().job_name.compare("job_1"));
+
+  /* re-scheduling the same jobs many times does not grow the queue */
+  for(int r = 0; r < 1000; r++)
+  {
+    queue.push(EVENT_START_JOB,1000 - r,"job_" + std::to_string(1 + (r % 3)));
+  }
+  ASSERT(3 == queue.size());
+  ASSERT(1 == queue.top().t0);
+  ASSERT(0 == queue.top().job_name.compare("job_1"));
+}
+
+void test_scheduler_queue_remove(void)
+{
+  KiwibesSchedulerQueue    queue;
+  std::vector<std::string> names;
+
+  for(int e = 0; e < 100; e++)
+  {
+    queue.push(EVENT_START_JOB,1000 - e,"job_" + std::to_string(e));
+  }
+
+  /* removing unknown jobs does nothing */
+  ASSERT(false == queue.remove("job_100"));
+  ASSERT(100 == queue.size());
+
+  /* remove all the even jobs, from the middle of the heap */
+  for(int e = 0; e < 100; e += 2)
+  {
+    ASSERT(true == queue.remove("job_" + std::to_string(e)));
+    ASSERT(false == queue.contains("job_" + std::to_string(e)));
+  }
+  ASSERT(50 == queue.size());
+
+  queue.get_all_job_names(names);
+  ASSERT(50 == names.size());
+  for(size_t n = 0; n < names.size(); n++)
+  {
+    ASSERT(1 == (std::stoi(names[n].substr(4)) % 2));
+  }
+
+  /* the remaining events are still ordered */
+  std::time_t last = 0;
+  while(false == queue.empty())
+  {
+    ASSERT(last < queue.top().t0);
+    last = queue.top().t0;
+    queue.pop();
+  }
+}
+
+void test_scheduler_queue_push_all(void)
+{
+  KiwibesSchedulerQueue              queue;
+  std::vector<KiwibesSchedulerEvent> batch;
+  std::vector<std::time_t>           instants;
+  std::mt19937                       rng(5678);
+
+  /* a small batch into a large queue is sifted up, event by event */
+  for(int e = 0; e < 100; e++)
+  {
+    instants.push_back(1000 + (rng() % 500));
+    queue.push(EVENT_START_JOB,instants.back(),"job_" + std::to_string(e));
+  }
+  for(int e = 100; e < 105; e++)
+  {
+    instants.push_back(1000 + (rng() % 500));
+    batch.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,instants.back(),"job_" + std::to_string(e)));
+  }
+  queue.push_all(batch);
+  ASSERT(105 == queue.size());
+
+  /* a large batch rebuilds the heap, and moves the jobs already in the queue */
+  batch.clear();
+  for(int e = 105; e < 1000; e++)
+  {
+    instants.push_back(1000 + (rng() % 500));
+    batch.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,instants.back(),"job_" + std::to_string(e)));
+  }
+  batch.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,10,"job_0"));
+  batch.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,5,"job_999"));
+  queue.push_all(batch);
+  ASSERT(1000 == queue.size());
+
+  instants[0]   = 10;
+  instants[999] = 5;
+  std::sort(instants.begin(),instants.end());
+
+  ASSERT(0 == queue.top().job_name.compare("job_999"));
+  for(size_t e = 0; e < instants.size(); e++)
+  {
+    ASSERT(instants[e] == queue.top().t0);
+    queue.pop();
+  }
+  ASSERT(true == queue.empty());
+
+  /* an empty batch does nothing */
+  queue.push_all(std::vector<KiwibesSchedulerEvent>());
+  ASSERT(true == queue.empty());
+}
+
+void test_scheduler_queue_push_all_benchmark(void)
+{
+  std::vector<KiwibesSchedulerEvent> batch;
+  std::mt19937                       rng(8765);
+
+  for(int e = 0; e < 100000; e++)
+  {
+    batch.push_back(KiwibesSchedulerEvent(EVENT_START_JOB,rng() % 100000,"job_" + std::to_string(e)));
+  }
+
+  /* schedule 100000 jobs one at a time, and then all at once */
+  KiwibesSchedulerQueue                 single;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(size_t e = 0; e < batch.size(); e++)
+  {
+    single.push(batch[e].type,batch[e].t0,batch[e].job_name);
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  KiwibesSchedulerQueue                 bulk;
+  bulk.push_all(batch);
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  ASSERT(single.size() == bulk.size());
+  while(false == single.empty())
+  {
+    ASSERT(single.top().t0 == bulk.top().t0);
+    single.pop();
+    bulk.pop();
+  }
+
+  printf("[100000 jobs: %.1f ms one at a time, %.1f ms at once] ",
+         std::chrono::duration<double,std::milli>(t1 - t0).count(),
+         std::chrono::duration<double,std::milli>(t2 - t1).count());
+}
@@ -0,0 +1,187 @@
+/* Kiwibes Automation Server Unit Tests
+  =====================================
+  Copyright 2018, Nelson Filipe Ferreira Goncalves
+  nelsongoncalves@patois.eu
+
+  License
+  -------
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details. You should have received
+  a copy of the GNU General Public License along with this program.
+  If not, see <http://www.gnu.org/licenses/>.
+
+  Summary
+  -------
+  Implements the unit tests for the binary snapshot of the database.
+ */
+#include "unit_tests.h"
+#include "kiwibes_snapshot.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*----------------------- Private Functions Definitions -----------*/
+/** Write a sealed snapshot of two jobs to a file
+
+  @param fname    the path to the snapshot
+  @param source   the JSON file the snapshot is a copy of
+  @return the contents of the snapshot
+ */
+static std::string write_snapshot(const std::string &fname, const T_SNAPSHOT_SOURCE &source)
+{
+  std::vector<T_JOB_RECORD> jobs(2);
+  std::string               snapshot;
+
+  jobs[0].name         = "job_1";
+  jobs[0].program      = std::vector<std::string>({ "/bin/echo", "hello", "" });
+  jobs[0].schedule     = "*/5 * * * * *";
+  jobs[0].max_runtime  = 10;
+  jobs[0].max_parallel = 4;
+  jobs[0].priority     = -2;
+  jobs[0].max_memory   = 512;
+  jobs[0].max_cpu      = 150;
+  jobs[0].avg_runtime  = 1.5;
+  jobs[0].var_runtime  = 0.25;
+  jobs[0].nbr_runs     = 42;
+  jobs[0].nbr_timeouts = 3;
+  jobs[0].extra        = nlohmann::json::object();
+  for(int r = 0; r < 40; r++)
+  {
+    T_JOB_RUN run = { 1000*r, 10*r, 0, 0, 100*r, 10*r, 4096*r, 0, 512 };
+
+    jobs[0].sketch.add(run.duration);
+    jobs[0].runs.add(run);
+  }
+
+  jobs[1].name          = "job_2";
+  jobs[1].max_runtime   = 5;
+  jobs[1].max_parallel  = 1;
+  jobs[1].priority      = 0;
+  jobs[1].max_memory    = 0;
+  jobs[1].max_cpu       = 0;
+  jobs[1].avg_runtime   = 0.0;
+  jobs[1].var_runtime   = 0.0;
+  jobs[1].nbr_runs      = 0;
+  jobs[1].nbr_timeouts  = 0;
+  jobs[1].extra["owner"] = "operations";
+
+  snapshot_encode(std::vector<const T_JOB_RECORD *>({ &jobs[0], &jobs[1] }),snapshot);
+  snapshot_seal(snapshot,source);
+
+  std::ofstream file(fname,std::ios::binary);
+  file << snapshot;
+
+  return snapshot;
+}
+
+/*----------------------- Public Functions Definitions ------------*/
+void test_snapshot_round_trip(void)
+{
+  std::vector<T_JOB_RECORD> jobs;
+  T_SNAPSHOT_SOURCE         sealed = {0x1234567890abcdefULL,1000000000LL,512};
+  T_SNAPSHOT_SOURCE         source = {0,1000000000LL,512};
+
+  write_snapshot("./snapshot.bin",sealed);
+
+  /* the hash of the JSON file comes from the snapshot */
+  ASSERT(true == snapshot_load("./snapshot.bin",source,jobs));
+  ASSERT(sealed.hash == source.hash);
+  ASSERT(2 == jobs.size());
+
+  ASSERT(std::string("job_1") == jobs[0].name);
+  ASSERT(3 == jobs[0].program.size());
+  ASSERT(std::string("/bin/echo") == jobs[0].program[0]);
+  ASSERT(std::string("hello") == jobs[0].program[1]);
+  ASSERT(jobs[0].program[2].empty());
+  ASSERT(std::string("*/5 * * * * *") == jobs[0].schedule);
+  ASSERT(10 == jobs[0].max_runtime);
+  ASSERT(4 == jobs[0].max_parallel);
+  ASSERT(-2 == jobs[0].priority);
+  ASSERT(512 == jobs[0].max_memory);
+  ASSERT(150 == jobs[0].max_cpu);
+  ASSERT(0 == jobs[0].instances);
+  ASSERT(1.5 == jobs[0].avg_runtime);
+  ASSERT(0.25 == jobs[0].var_runtime);
+  ASSERT(42 == jobs[0].nbr_runs);
+  ASSERT(3 == jobs[0].nbr_timeouts);
+  ASSERT(JOB_STATUS_STOPPED == jobs[0].status);
+  ASSERT(0 == jobs[0].pending_start);
+  ASSERT(0 == jobs[0].extra.size());
+  ASSERT(40 == jobs[0].sketch.count());
+  ASSERT(1 == jobs[0].sketch.zeros());
+  ASSERT(JOB_HISTORY_MAX_RUNS == jobs[0].runs.size());
+  ASSERT(8000 == jobs[0].runs.at(0).start);
+  ASSERT(390 == jobs[0].runs.at(JOB_HISTORY_MAX_RUNS - 1).duration);
+  ASSERT(3900 == jobs[0].runs.at(JOB_HISTORY_MAX_RUNS - 1).cpu_user);
+  ASSERT(4096*39 == jobs[0].runs.at(JOB_HISTORY_MAX_RUNS - 1).memory_peak);
+  ASSERT(512 == jobs[0].runs.at(JOB_HISTORY_MAX_RUNS - 1).io_write);
+  ASSERT(0 == jobs[1].max_memory);
+
+  ASSERT(std::string("job_2") == jobs[1].name);
+  ASSERT(0 == jobs[1].program.size());
+  ASSERT(0 == jobs[1].sketch.count());
+  ASSERT(0 == jobs[1].runs.size());
+  ASSERT(jobs[1].schedule.empty());
+  ASSERT(std::string("operations") == jobs[1].extra["owner"].get<std::string>());
+
+  std::remove("./snapshot.bin");
+}
+
+void test_snapshot_invalid(void)
+{
+  std::vector<T_JOB_RECORD> jobs;
+  T_SNAPSHOT_SOURCE         source = {0,1000000000LL,512};
+  std::string               snapshot;
+
+  /* the file does not exist */
+  std::remove("./snapshot.bin");
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+
+  /* the JSON file was changed since the snapshot was written */
+  snapshot = write_snapshot("./snapshot.bin",source);
+  source.mtime++;
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+  source.mtime--;
+  source.size++;
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+  source.size--;
+  ASSERT(true == snapshot_load("./snapshot.bin",source,jobs));
+
+  /* a corrupted byte fails the checksum */
+  {
+    std::string   corrupted = snapshot;
+    std::ofstream file("./snapshot.bin",std::ios::binary);
+
+    corrupted[corrupted.size() - 3] ^= 0x20;
+    file << corrupted;
+  }
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+  ASSERT(0 == jobs.size());
+
+  /* a truncated snapshot */
+  {
+    std::ofstream file("./snapshot.bin",std::ios::binary);
+
+    file << snapshot.substr(0,snapshot.size() - 1);
+  }
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+
+  /* not a snapshot */
+  {
+    std::ofstream file("./snapshot.bin",std::ios::binary);
+
+    file << "{ \"job_1\": {} }";
+  }
+  ASSERT(false == snapshot_load("./snapshot.bin",source,jobs));
+
+  std::remove("./snapshot.bin");
+}
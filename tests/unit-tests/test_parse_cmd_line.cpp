@@ -56,6 +56,11 @@ void test_parse_and_validate_command_line(void)
     ASSERT(4242 == options.https_port);    
     ASSERT(1 == options.log_max_size);    
     ASSERT(0 == options.log_level);    
+    ASSERT(0 == options.journal_sync);    
+    ASSERT(0 == options.binary_snapshot);    
+    ASSERT(0 == options.group_commit);    
+    ASSERT(0 == options.max_running);    
+    ASSERT(0 == options.job_output);    
   }
 
   /* valid command line arguments, check parsed values */
@@ -68,6 +73,11 @@ void test_parse_and_validate_command_line(void)
       "-s","100",
       "-p","31415",
       "-d","3",
+      "-f","1",
+      "-b","1",
+      "-g","20",
+      "-j","8",
+      "-o","1",
       NULL,
     };
     int argc = sizeof(argv)/sizeof(char *) - 1;
@@ -78,6 +88,67 @@ void test_parse_and_validate_command_line(void)
     ASSERT(100 == options.log_max_size);    
     ASSERT(2 == options.log_level);    
     ASSERT(3 == options.data_store_size);    
+    ASSERT(1 == options.journal_sync);    
+    ASSERT(1 == options.binary_snapshot);    
+    ASSERT(20 == options.group_commit);    
+    ASSERT(8 == options.max_running);    
+    ASSERT(1 == options.job_output);    
+  }
+
+  /* journal sync is invalid */
+  {
+    T_CMD_LINE_OPTIONS options;
+    const char *argv[] = {
+      "/bin/prog",
+      "./",
+      "-f","2",
+      NULL,
+    };
+    int argc = sizeof(argv)/sizeof(char *) - 1;
+    
+    ASSERT(ERROR_CMDLINE_INV_JOURNAL_SYNC == parse_and_validate_command_line(options,argc,(char **)argv));    
+  }
+
+  /* binary snapshot is invalid */
+  {
+    T_CMD_LINE_OPTIONS options;
+    const char *argv[] = {
+      "/bin/prog",
+      "./",
+      "-b","2",
+      NULL,
+    };
+    int argc = sizeof(argv)/sizeof(char *) - 1;
+    
+    ASSERT(ERROR_CMDLINE_INV_BINARY_SNAPSHOT == parse_and_validate_command_line(options,argc,(char **)argv));    
+  }
+
+  /* group commit delay is invalid */
+  {
+    T_CMD_LINE_OPTIONS options;
+    const char *argv[] = {
+      "/bin/prog",
+      "./",
+      "-g","1000",
+      NULL,
+    };
+    int argc = sizeof(argv)/sizeof(char *) - 1;
+    
+    ASSERT(ERROR_CMDLINE_INV_GROUP_COMMIT == parse_and_validate_command_line(options,argc,(char **)argv));    
+  }
+
+  /* job output is invalid */
+  {
+    T_CMD_LINE_OPTIONS options;
+    const char *argv[] = {
+      "/bin/prog",
+      "./",
+      "-o","2",
+      NULL,
+    };
+    int argc = sizeof(argv)/sizeof(char *) - 1;
+    
+    ASSERT(ERROR_CMDLINE_INV_JOB_OUTPUT == parse_and_validate_command_line(options,argc,(char **)argv));    
   }
 
   /* home folder does not exist */
@@ -0,0 +1,112 @@
+
+#ifndef __UT_KIWIBES_DECLARATIONS__
+#define __UT_KIWIBES_DECLARATIONS__
+
+void test_invocations_status(void);
+void test_invocations_wait(void);
+void test_database_constructor(void);
+void test_database_load_errors(void);
+void test_database_load(void);
+void test_database_get_all_schedulable_jobs(void);
+void test_database_get_job_next_start(void);
+void test_database_get_job_description(void);
+void test_database_job_started(void);
+void test_database_job_stopped(void);
+void test_database_job_instances(void);
+void test_database_run_history(void);
+void test_database_stats(void);
+void test_database_delete_job(void);
+void test_database_delete_jobs(void);
+void test_database_delete_jobs_benchmark(void);
+void test_database_create_job(void);
+void test_database_create_jobs(void);
+void test_database_list_jobs(void);
+void test_database_list_jobs_benchmark(void);
+void test_database_edit_job(void);
+void test_database_job_incr_start_requests(void);
+void test_database_job_decr_start_requests(void);
+void test_database_job_clear_start_requests(void);
+void test_database_journal_replay(void);
+void test_database_journal_stale(void);
+void test_database_journal_incomplete_record(void);
+void test_database_journal_unknown_job_record(void);
+void test_database_journal_compaction(void);
+void test_database_atomic_save(void);
+void test_database_interrupted_save(void);
+void test_database_saver_merges_requests(void);
+void test_database_saver_exit(void);
+void test_database_extra_fields(void);
+void test_database_binary_snapshot(void);
+void test_database_startup_benchmark(void);
+void test_database_job_record_benchmark(void);
+void test_database_readers_benchmark(void);
+void test_database_journal_benchmark(void);
+void test_database_shards_benchmark(void);
+void test_database_shards_save(void);
+void test_database_group_commit(void);
+void test_database_group_commit_benchmark(void);
+void test_scheduler_same_second_batch(void);
+void test_scheduler_unschedule_job(void);
+void test_data_store_write(void);
+void test_data_store_read(void);
+void test_data_store_clear(void);
+void test_data_store_clear_all(void);
+void test_data_store_size(void);
+void test_data_store_get_keys(void);
+void test_parse_and_validate_command_line(void);
+void test_authentication_verify(void);
+void test_authentication_update(void);
+void test_runtime_sketch_quantiles(void);
+void test_runtime_sketch_merge(void);
+void test_run_history(void);
+void test_run_statistics(void);
+void test_launch_queue_order(void);
+void test_launch_queue_producers(void);
+void test_snapshot_round_trip(void);
+void test_snapshot_invalid(void);
+void test_scheduler_queue_order(void);
+void test_scheduler_queue_shuffled(void);
+void test_scheduler_queue_update(void);
+void test_scheduler_queue_remove(void);
+void test_scheduler_queue_push_all(void);
+void test_scheduler_queue_push_all_benchmark(void);
+void test_admission_queue_order(void);
+void test_admission_queue_block(void);
+void test_admission_queue_capacity(void);
+void test_scheduler_event_order(void);
+void test_scheduler_event_shuffled_sort(void);
+void test_deadlines_order(void);
+void test_deadlines_escalation(void);
+void test_cgroups_unavailable(void);
+void test_cgroups_accounting(void);
+void test_jobs_manager_start_job(void);
+void test_jobs_manager_launch_failure(void);
+void test_jobs_manager_stop_job(void);
+void test_jobs_manager_stop_all_jobs(void);
+void test_jobs_manager_queued_start_requests(void);
+void test_jobs_manager_queued_restart_latency(void);
+void test_jobs_manager_polling_fallback(void);
+void test_jobs_manager_max_runtime(void);
+void test_jobs_manager_concurrency_limits(void);
+void test_jobs_manager_start_job_async(void);
+void test_jobs_manager_job_output(void);
+void test_jobs_manager_job_resources(void);
+void test_jobs_manager_forked_children(void);
+void test_jobs_manager_cgroups_removed(void);
+void test_job_output_capture(void);
+void test_job_output_ring(void);
+void test_job_output_runs(void);
+void test_job_output_follow(void);
+void test_job_output_spill(void);
+void test_process_table_insert(void);
+void test_process_table_instances(void);
+void test_process_table_remove(void);
+void test_process_table_reap_benchmark(void);
+void test_cron_valid_expressions(void);
+void test_cron_invalid_expressions(void);
+void test_cron_next_occurrence(void);
+void test_cron_next_n_occurrences(void);
+void test_cron_next_n_daylight_saving(void);
+void test_cron_next_n_benchmark(void);
+
+#endif
@@ -129,6 +129,74 @@ def test_get_scheduled_jobs():
 	assert 200 == result.status_code
 	assert sorted(["list_hal"]) == sorted(result.json())
 
+def test_get_jobs_forecast():
+	"""
+	Return the start instants of the scheduled jobs
+	"""
+	# the jobs in the REST database have no schedule
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/forecast',verify=False)
+	assert 200 == result.status_code
+	assert 0 == len(result.json())
+
+	# create a job which runs every hour
+	scheduled_job =  {
+		"program"     : [ "/bin/ls",'-l','-a','-h'],
+		"schedule"    : "0 0 * * * *",
+		"max-runtime" : 5,
+		"auth"        : "validation-rest-calls",
+	}
+
+	result = requests.post('https://127.0.0.1:4242/rest/job/create/list_hal',data=scheduled_job,verify=False)	
+	assert 200 == result.status_code
+
+	start = int(time.time()) // 3600 * 3600
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/forecast',params={'from' : start, 'to' : start + 24*3600},verify=False)
+	assert 200 == result.status_code
+	assert [start + 3600*h for h in range(1,25)] == result.json()['list_hal']
+
+	# the window must be valid
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/forecast',params={'from' : start, 'to' : start - 1},verify=False)
+	assert 404 == result.status_code
+
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/forecast',params={'from' : 'yesterday'},verify=False)
+	assert 404 == result.status_code
+
+def test_get_stats():
+	"""
+	Return the statistics of the server
+	"""
+	result = requests.get('https://127.0.0.1:4242/rest/stats',verify=False)
+	assert 200 == result.status_code
+	assert 3 == result.json()['jobs']
+	assert 0 == result.json()['running']
+	assert 0 == result.json()['runs']
+
+	# run a job, and queue another start of it
+	token = {"auth" : "validation-rest-calls"}
+	result = requests.post('https://127.0.0.1:4242/rest/job/start/sleep_10',data=token,verify=False)
+	assert 202 == result.status_code
+	result = requests.post('https://127.0.0.1:4242/rest/job/start/sleep_10',data=token,verify=False)
+	assert 202 == result.status_code
+
+	result = requests.get('https://127.0.0.1:4242/rest/stats',verify=False)
+	assert 200 == result.status_code
+	assert 1 == result.json()['running']
+	assert 1 == result.json()['pending-start']
+
+	result = requests.post('https://127.0.0.1:4242/rest/job/clear_pending/sleep_10',data=token,verify=False)
+	assert 200 == result.status_code
+	result = requests.post('https://127.0.0.1:4242/rest/job/stop/sleep_10',data=token,verify=False)
+	assert 200 == result.status_code
+	time.sleep(1.0)
+
+	result = requests.get('https://127.0.0.1:4242/rest/stats',verify=False)
+	assert 200 == result.status_code
+	assert 0 == result.json()['running']
+	assert 0 == result.json()['pending-start']
+	assert 1 == result.json()['runs']
+	assert 1 == result.json()['failed-runs']
+	assert 1 == result.json()['runs-per-minute']
+
 def test_get_job_details():
 	"""
 	Retrieve the details of a job
@@ -256,7 +324,7 @@ def test_post_edit_job():
 
 	# cannot edit a job that is running
 	result = requests.post('https://127.0.0.1:4242/rest/job/start/sleep_10',data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	time.sleep(2)
 	result = requests.post('https://127.0.0.1:4242/rest/job/edit/sleep_10',data=new_job,verify=False)
@@ -319,7 +387,7 @@ def test_post_delete_job():
 
 	# cannot delete a job that is running
 	result = requests.post('https://127.0.0.1:4242/rest/job/start/sleep_10',data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 	
 	time.sleep(2)
 
@@ -336,6 +404,31 @@ def test_post_delete_job():
 	result = requests.get('https://127.0.0.1:4242/rest/jobs/list',params=token,verify=False)
 	assert not 'list_home' in result.json()
 
+def test_post_delete_jobs():
+	"""
+	Delete many jobs at once
+	"""
+	token = { "auth" : "validation-rest-calls"}
+	# at least one job must be given
+	result = requests.post('https://127.0.0.1:4242/rest/jobs/delete',data=token,verify=False)
+	assert 404 == result.status_code
+	assert result.json()["error"] == util.KIWIBES_ERRORS['ERROR_EMPTY_REST_REQUEST']
+
+	# no job is deleted if one of them is unknown
+	result = requests.post('https://127.0.0.1:4242/rest/jobs/delete',data={ "auth" : "validation-rest-calls", "name" : ["list_home","my_shiny_job"]},verify=False)
+	assert 404 == result.status_code
+	assert result.json()["error"] == util.KIWIBES_ERRORS['ERROR_JOB_NAME_UNKNOWN']
+
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/list',params=token,verify=False)
+	assert sorted(['hello_world','sleep_10','list_home']) == sorted(result.json())
+
+	# delete existing jobs
+	result = requests.post('https://127.0.0.1:4242/rest/jobs/delete',data={ "auth" : "validation-rest-calls", "name" : ["list_home","hello_world"]},verify=False)
+	assert 200 == result.status_code
+	
+	result = requests.get('https://127.0.0.1:4242/rest/jobs/list',params=token,verify=False)
+	assert ['sleep_10'] == result.json()
+
 def test_start_job():
 	"""
 	Start a job 
@@ -350,7 +443,7 @@ def test_start_job():
 	assert False == os.path.isfile(os.path.join(util.KIWIBES_HOME,"hello_world.txt"))
 
 	result = requests.post('https://127.0.0.1:4242/rest/job/start/hello_world',data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	result = requests.get('https://127.0.0.1:4242/rest/job/details/hello_world',params=token,verify=False)
 	assert 200 == result.status_code
@@ -393,7 +486,7 @@ def test_stop_job():
 	assert False == os.path.isfile(os.path.join(util.KIWIBES_HOME,"hello_world.txt"))
 
 	result = requests.post('https://127.0.0.1:4242/rest/job/start/hello_world',data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 	
 	result = requests.get('https://127.0.0.1:4242/rest/job/details/hello_world',params=token,verify=False)
 	assert 200 == result.status_code
@@ -428,13 +521,13 @@ def test_queue_job():
 	token = { "auth" : "validation-rest-calls"}	
 	# start the same job multiple times
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	# verify it is queued
 	result = requests.get("https://127.0.0.1:4242/rest/job/details/hello_world",params=token,verify=False)
@@ -470,13 +563,13 @@ def test_clear_job_queue():
 	
 	# start the same job multiple times
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	result = requests.post("https://127.0.0.1:4242/rest/job/start/hello_world",data=token,verify=False)
-	assert 200 == result.status_code
+	assert 202 == result.status_code
 
 	# verify it is queued
 	result = requests.get("https://127.0.0.1:4242/rest/job/details/hello_world",params=token,verify=False)